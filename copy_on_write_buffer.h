@@ -129,6 +129,10 @@ class CopyOnWriteBuffer {
 
   bool empty() const { return size_ == 0; }
 
+  // Returns true if no other buffer shares the data, so MutableData() does
+  // not copy.
+  bool HasOneRef() const { return !buffer_ || buffer_.use_count() == 1; }
+
   size_t size() const {
     AVE_DCHECK(IsConsistent());
     return size_;
@@ -9,6 +9,7 @@
 #define AVE_COUNT_DOWN_LATCH_H
 
 #include <condition_variable>
+#include <memory>
 #include <mutex>
 
 #include "noncopyable.h"
@@ -30,6 +31,13 @@ class CountDownLatch : noncopyable {
   int count_;
 };
 
+// Counts the latch down when released, so a waiter also wakes up if the
+// work it waits for is dropped instead of run.
+struct CountDownOnRelease {
+  void operator()(CountDownLatch* latch) const { latch->CountDown(); }
+};
+using ScopedCountDown = std::unique_ptr<CountDownLatch, CountDownOnRelease>;
+
 }  // namespace base
 }  // namespace ave
 
@@ -10,7 +10,9 @@
 
 #include <cstddef>
 #include <cstdint>
+#include <span>
 
+#include "base/copy_on_write_buffer.h"
 #include "base/net/socket_address.h"
 #include "base/third_party/sigslot/sigslot.h"
 
@@ -23,6 +25,34 @@ enum class PacketSocketOption {
   kDontFragment,
   kRecvBuf,
   kSendBuf,
+  // UDP only. Segment size for UDP_SEGMENT (GSO), 0 to disable. A send larger
+  // than the segment size goes out as packets of that size, the last one may
+  // be shorter. Emulated with batched sends if the kernel lacks support.
+  kUdpSegment,
+  // UDP only. Non-zero enables UDP_GRO, packets coalesced by the kernel are
+  // split again before delivery. Without kernel support packets simply
+  // arrive one by one.
+  kUdpGro,
+  // TCP only. Non-zero lets large Send(CopyOnWriteBuffer) calls go out with
+  // MSG_ZEROCOPY. Reads back as 0 once the kernel reports it had to copy
+  // anyway, as on loopback, from then on sends are copied again.
+  kZeroCopy,
+};
+
+// One piece of a SendV() packet. Made from a CopyOnWriteBuffer it holds a
+// reference, so a socket that has to queue the data does not copy it. Plain
+// data only needs to outlive the call.
+struct PacketSegment {
+  PacketSegment(const void* data, size_t size)
+      : data(static_cast<const uint8_t*>(data), size) {}
+  PacketSegment(std::span<const uint8_t> data)  // NOLINT: runtime/explicit
+      : data(data) {}
+  PacketSegment(const CopyOnWriteBuffer& buffer)  // NOLINT: runtime/explicit
+      : data(buffer.data(), buffer.size()), buffer(buffer) {}
+
+  std::span<const uint8_t> data;
+  // Empty for plain data.
+  CopyOnWriteBuffer buffer;
 };
 
 // AsyncPacketSocket is the user-facing interface for asynchronous
@@ -55,6 +85,13 @@ class AsyncPacketSocket : public sigslot::has_slots<> {
                          size_t size,
                          const SocketAddress& addr) = 0;
 
+  // Send `segments` as one packet, as if they were joined, without copying
+  // them into one buffer first.
+  // Returns the number of bytes sent, or -1 on error.
+  virtual int32_t SendV(std::span<const PacketSegment> segments) = 0;
+  virtual int32_t SendToV(std::span<const PacketSegment> segments,
+                          const SocketAddress& addr) = 0;
+
   // Close the socket.
   virtual int32_t Close() = 0;
 
@@ -77,6 +114,16 @@ class AsyncPacketSocket : public sigslot::has_slots<> {
                    int64_t>
       SignalReadPacket;
 
+  // Emitted for every received packet like SignalReadPacket, right before
+  // it, with the packet in a buffer the receiver may keep without copying.
+  // Either signal or both may be connected.
+  // Parameters: socket, data, remote_addr, timestamp (microseconds)
+  sigslot::signal4<AsyncPacketSocket*,
+                   const CopyOnWriteBuffer&,
+                   const SocketAddress&,
+                   int64_t>
+      SignalReadBuffer;
+
   // Signal emitted when the socket is ready to send data.
   sigslot::signal1<AsyncPacketSocket*> SignalReadyToSend;
 
@@ -6,6 +6,8 @@
  */
 
 #include <cstring>
+#include <string>
+#include <vector>
 
 #include "base/net/async_udp_socket.h"
 #include "base/net/physical_socket_server.h"
@@ -105,6 +107,273 @@ TEST_F(AsyncSocketTest, UdpLoopback) {
   delete receiver;
 }
 
+TEST_F(AsyncSocketTest, UdpSendVGathersOneDatagram) {
+  std::unique_ptr<AsyncUDPSocket> sender(AsyncUDPSocket::Create(
+      socket_server_->CreateSocket(AF_INET, SOCK_DGRAM),
+      SocketAddress("127.0.0.1", 0)));
+  std::unique_ptr<AsyncUDPSocket> receiver(AsyncUDPSocket::Create(
+      socket_server_->CreateSocket(AF_INET, SOCK_DGRAM),
+      SocketAddress("127.0.0.1", 0)));
+  ASSERT_TRUE(sender && receiver);
+  PacketReceiver packet_receiver;
+  receiver->SignalReadPacket.connect(&packet_receiver,
+                                     &PacketReceiver::OnPacketReceived);
+
+  const char header[] = "header:";
+  CopyOnWriteBuffer payload(std::string_view("payload"));
+  PacketSegment segments[] = {{header, strlen(header)}, payload};
+  EXPECT_EQ(sender->SendToV(segments, receiver->GetLocalAddress()), 14);
+
+  for (int i = 0; i < 100 && !packet_receiver.received(); ++i) {
+    socket_server_->Wait(10);
+  }
+  EXPECT_EQ(packet_receiver.received_data(), "header:payload");
+}
+
+TEST_F(AsyncSocketTest, UdpSendVGathersOneDatagramIPv6) {
+  std::unique_ptr<AsyncUDPSocket> sender(AsyncUDPSocket::Create(
+      socket_server_->CreateSocket(AF_INET6, SOCK_DGRAM),
+      SocketAddress("::1", 0)));
+  std::unique_ptr<AsyncUDPSocket> receiver(AsyncUDPSocket::Create(
+      socket_server_->CreateSocket(AF_INET6, SOCK_DGRAM),
+      SocketAddress("::1", 0)));
+  if (!sender || !receiver) {
+    GTEST_SKIP() << "No IPv6 loopback";
+  }
+  PacketReceiver packet_receiver;
+  receiver->SignalReadPacket.connect(&packet_receiver,
+                                     &PacketReceiver::OnPacketReceived);
+
+  const char header[] = "header:";
+  CopyOnWriteBuffer payload(std::string_view("payload"));
+  PacketSegment segments[] = {{header, strlen(header)}, payload};
+  EXPECT_EQ(sender->SendToV(segments, receiver->GetLocalAddress()), 14);
+
+  for (int i = 0; i < 100 && !packet_receiver.received(); ++i) {
+    socket_server_->Wait(10);
+  }
+  EXPECT_EQ(packet_receiver.received_data(), "header:payload");
+  EXPECT_EQ(packet_receiver.received_from(), sender->GetLocalAddress());
+}
+
+TEST_F(AsyncSocketTest, UdpBatchLoopback) {
+  Socket* sender_sock = socket_server_->CreateSocket(AF_INET, SOCK_DGRAM);
+  auto* sender =
+      AsyncUDPSocket::Create(sender_sock, SocketAddress("127.0.0.1", 0));
+  ASSERT_NE(sender, nullptr);
+  Socket* receiver_sock = socket_server_->CreateSocket(AF_INET, SOCK_DGRAM);
+  auto* receiver =
+      AsyncUDPSocket::Create(receiver_sock, SocketAddress("127.0.0.1", 0));
+  ASSERT_NE(receiver, nullptr);
+
+  class BatchReceiver : public sigslot::has_slots<> {
+   public:
+    void OnBatch(AsyncUDPSocket* socket [[maybe_unused]],
+                 const ReceivedDatagram* datagrams,
+                 size_t count) {
+      ++batches;
+      for (size_t i = 0; i < count; ++i) {
+        received.emplace_back(reinterpret_cast<const char*>(datagrams[i].data),
+                              datagrams[i].size);
+      }
+    }
+
+    int batches = 0;
+    std::vector<std::string> received;
+  } batch_receiver;
+  receiver->SignalReadPacketBatch.connect(&batch_receiver,
+                                          &BatchReceiver::OnBatch);
+
+  // Kept buffers, emitted next to the batches.
+  class BufferReceiver : public sigslot::has_slots<> {
+   public:
+    void OnBuffer(AsyncPacketSocket* socket [[maybe_unused]],
+                  const CopyOnWriteBuffer& data,
+                  const SocketAddress& addr [[maybe_unused]],
+                  int64_t timestamp [[maybe_unused]]) {
+      buffers.push_back(data);
+    }
+
+    std::vector<CopyOnWriteBuffer> buffers;
+  } buffer_receiver;
+  receiver->SignalReadBuffer.connect(&buffer_receiver,
+                                     &BufferReceiver::OnBuffer);
+
+  constexpr size_t kCount = 40;
+  std::vector<std::string> payloads;
+  std::vector<OutgoingDatagram> datagrams;
+  for (size_t i = 0; i < kCount; ++i) {
+    payloads.push_back("datagram " + std::to_string(i));
+  }
+  for (const std::string& payload : payloads) {
+    datagrams.push_back(
+        {payload.data(), payload.size(), receiver->GetLocalAddress()});
+  }
+  EXPECT_EQ(sender->SendBatch(datagrams.data(), datagrams.size()),
+            static_cast<int32_t>(kCount));
+
+  for (int i = 0; i < 100 && batch_receiver.received.size() < kCount; ++i) {
+    socket_server_->Wait(10);
+  }
+
+  EXPECT_EQ(batch_receiver.received, payloads);
+  EXPECT_LT(batch_receiver.batches, static_cast<int>(kCount));
+  std::vector<std::string> kept;
+  for (const CopyOnWriteBuffer& buffer : buffer_receiver.buffers) {
+    kept.emplace_back(buffer.data<char>(), buffer.size());
+  }
+  EXPECT_EQ(kept, payloads);
+
+  delete sender;
+  delete receiver;
+}
+
+TEST_F(AsyncSocketTest, UdpBatchLoopbackIPv6) {
+  std::unique_ptr<AsyncUDPSocket> sender(AsyncUDPSocket::Create(
+      socket_server_->CreateSocket(AF_INET6, SOCK_DGRAM),
+      SocketAddress("::1", 0)));
+  std::unique_ptr<AsyncUDPSocket> receiver(AsyncUDPSocket::Create(
+      socket_server_->CreateSocket(AF_INET6, SOCK_DGRAM),
+      SocketAddress("::1", 0)));
+  if (!sender || !receiver) {
+    GTEST_SKIP() << "No IPv6 loopback";
+  }
+
+  class BatchReceiver : public sigslot::has_slots<> {
+   public:
+    void OnBatch(AsyncUDPSocket* socket [[maybe_unused]],
+                 const ReceivedDatagram* datagrams,
+                 size_t count) {
+      for (size_t i = 0; i < count; ++i) {
+        received.emplace_back(reinterpret_cast<const char*>(datagrams[i].data),
+                              datagrams[i].size);
+        from.push_back(datagrams[i].addr);
+      }
+    }
+
+    std::vector<std::string> received;
+    std::vector<SocketAddress> from;
+  } batch_receiver;
+  receiver->SignalReadPacketBatch.connect(&batch_receiver,
+                                          &BatchReceiver::OnBatch);
+
+  std::vector<std::string> payloads = {"first", "second", "third"};
+  std::vector<OutgoingDatagram> datagrams;
+  for (const std::string& payload : payloads) {
+    datagrams.push_back(
+        {payload.data(), payload.size(), receiver->GetLocalAddress()});
+  }
+  EXPECT_EQ(receiver->GetLocalAddress().family(), AF_INET6);
+  EXPECT_EQ(sender->SendBatch(datagrams.data(), datagrams.size()), 3);
+
+  for (int i = 0; i < 100 && batch_receiver.received.size() < 3; ++i) {
+    socket_server_->Wait(10);
+  }
+
+  EXPECT_EQ(batch_receiver.received, payloads);
+  for (const SocketAddress& addr : batch_receiver.from) {
+    EXPECT_EQ(addr, sender->GetLocalAddress());
+  }
+}
+
+TEST_F(AsyncSocketTest, UdpReadEventDrainsSocket) {
+  Socket* sender_sock = socket_server_->CreateSocket(AF_INET, SOCK_DGRAM);
+  auto* sender =
+      AsyncUDPSocket::Create(sender_sock, SocketAddress("127.0.0.1", 0));
+  ASSERT_NE(sender, nullptr);
+  Socket* receiver_sock = socket_server_->CreateSocket(AF_INET, SOCK_DGRAM);
+  auto* receiver =
+      AsyncUDPSocket::Create(receiver_sock, SocketAddress("127.0.0.1", 0));
+  ASSERT_NE(receiver, nullptr);
+
+  class CountingReceiver : public sigslot::has_slots<> {
+   public:
+    void OnPacket(AsyncPacketSocket* socket [[maybe_unused]],
+                  const uint8_t* data [[maybe_unused]],
+                  size_t size [[maybe_unused]],
+                  const SocketAddress& addr [[maybe_unused]],
+                  int64_t timestamp [[maybe_unused]]) {
+      ++count;
+    }
+
+    size_t count = 0;
+  } counting_receiver;
+  receiver->SignalReadPacket.connect(&counting_receiver,
+                                     &CountingReceiver::OnPacket);
+
+  // More than one batch queued before the single edge triggered event.
+  constexpr size_t kCount = AsyncUDPSocket::kRecvBatchSize * 3 + 1;
+  const char payload[] = "burst";
+  for (size_t i = 0; i < kCount; ++i) {
+    EXPECT_GT(
+        sender->SendTo(payload, sizeof(payload), receiver->GetLocalAddress()),
+        0);
+  }
+
+  for (int i = 0; i < 100 && counting_receiver.count < kCount; ++i) {
+    socket_server_->Wait(10);
+  }
+  EXPECT_EQ(counting_receiver.count, kCount);
+
+  delete sender;
+  delete receiver;
+}
+
+TEST_F(AsyncSocketTest, UdpSegmentationOffload) {
+  Socket* sender_sock = socket_server_->CreateSocket(AF_INET, SOCK_DGRAM);
+  auto* sender =
+      AsyncUDPSocket::Create(sender_sock, SocketAddress("127.0.0.1", 0));
+  ASSERT_NE(sender, nullptr);
+  Socket* receiver_sock = socket_server_->CreateSocket(AF_INET, SOCK_DGRAM);
+  auto* receiver =
+      AsyncUDPSocket::Create(receiver_sock, SocketAddress("127.0.0.1", 0));
+  ASSERT_NE(receiver, nullptr);
+
+  // Both fall back to per-packet I/O without kernel support, the packets
+  // seen by the receiver are the same either way.
+  EXPECT_EQ(sender->SetOption(PacketSocketOption::kUdpSegment, 1000), 0);
+  EXPECT_EQ(receiver->SetOption(PacketSocketOption::kUdpGro, 1), 0);
+  int32_t segment_size = 0;
+  EXPECT_EQ(sender->GetOption(PacketSocketOption::kUdpSegment, &segment_size),
+            0);
+  EXPECT_EQ(segment_size, 1000);
+
+  class SegmentReceiver : public sigslot::has_slots<> {
+   public:
+    void OnPacket(AsyncPacketSocket* socket [[maybe_unused]],
+                  const uint8_t* data,
+                  size_t size,
+                  const SocketAddress& addr [[maybe_unused]],
+                  int64_t timestamp [[maybe_unused]]) {
+      packets.emplace_back(reinterpret_cast<const char*>(data), size);
+    }
+
+    std::vector<std::string> packets;
+  } segment_receiver;
+  receiver->SignalReadPacket.connect(&segment_receiver,
+                                     &SegmentReceiver::OnPacket);
+
+  std::string payload;
+  for (char c : {'a', 'b', 'c'}) {
+    payload.append(c == 'c' ? 500 : 1000, c);
+  }
+  EXPECT_EQ(sender->SendTo(payload.data(), payload.size(),
+                           receiver->GetLocalAddress()),
+            static_cast<int32_t>(payload.size()));
+
+  for (int i = 0; i < 100 && segment_receiver.packets.size() < 3; ++i) {
+    socket_server_->Wait(10);
+  }
+
+  ASSERT_EQ(segment_receiver.packets.size(), 3u);
+  EXPECT_EQ(segment_receiver.packets[0], std::string(1000, 'a'));
+  EXPECT_EQ(segment_receiver.packets[1], std::string(1000, 'b'));
+  EXPECT_EQ(segment_receiver.packets[2], std::string(500, 'c'));
+
+  delete sender;
+  delete receiver;
+}
+
 }  // namespace net
 }  // namespace base
 }  // namespace ave
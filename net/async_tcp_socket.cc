@@ -6,8 +6,9 @@
  */
 
 #include "base/net/async_tcp_socket.h"
-#include <array>
 
+#include <algorithm>
+#include <array>
 #include <cstring>
 #include <utility>
 
@@ -19,15 +20,25 @@ namespace net {
 
 namespace {
 constexpr size_t kMaxTCPReadSize = 64 * 1024;
+// Buffers kept by receivers that are reused once released.
+constexpr size_t kMaxPooledReadBuffers = 4;
+// Queued segments handed to one writev.
+constexpr size_t kMaxWriteIovCount = 64;
 }  // namespace
 
 AsyncTCPSocket::AsyncTCPSocket(Socket* socket)
-    : socket_(socket), connected_(false) {
+    : socket_(socket),
+      recv_pool_(kMaxTCPReadSize, kMaxPooledReadBuffers),
+      connected_(false),
+      write_blocked_(false),
+      zerocopy_(false),
+      alive_(PendingTaskFlag::Create()) {
   if (socket_) {
     socket_->SignalReadEvent.connect(this, &AsyncTCPSocket::OnReadEvent);
     socket_->SignalWriteEvent.connect(this, &AsyncTCPSocket::OnWriteEvent);
     socket_->SignalConnectEvent.connect(this, &AsyncTCPSocket::OnConnectEvent);
     socket_->SignalCloseEvent.connect(this, &AsyncTCPSocket::OnCloseEvent);
+    socket_->SignalZeroCopyDone.connect(this, &AsyncTCPSocket::OnZeroCopyDone);
 
     if (socket_->GetState() == Socket::CS_CONNECTED) {
       connected_ = true;
@@ -36,11 +47,13 @@ AsyncTCPSocket::AsyncTCPSocket(Socket* socket)
 }
 
 AsyncTCPSocket::~AsyncTCPSocket() {
+  alive_->SetNotAlive();
   if (socket_) {
     socket_->SignalReadEvent.disconnect(this);
     socket_->SignalWriteEvent.disconnect(this);
     socket_->SignalConnectEvent.disconnect(this);
     socket_->SignalCloseEvent.disconnect(this);
+    socket_->SignalZeroCopyDone.disconnect(this);
   }
 }
 
@@ -90,38 +103,48 @@ int32_t AsyncTCPSocket::Send(const void* data, size_t size) {
   if (!socket_) {
     return -1;
   }
+  if (size == 0) {
+    return 0;
+  }
 
-  if (!connected_) {
-    // Buffer data until connected
-    write_buffer_.AppendData(static_cast<const uint8_t*>(data), size);
+  // Try to send directly
+  if (connected_ && write_queue_.empty() && !write_blocked_) {
+    int32_t sent = socket_->Send(data, size);
+    if (sent < 0) {
+      if (!socket_->IsBlocking()) {
+        return -1;
+      }
+      write_blocked_ = true;
+      sent = 0;
+    }
+    if (std::cmp_less(sent, size)) {
+      QueueCopy(static_cast<const uint8_t*>(data) + sent, size - sent);
+      FlushWriteQueue();
+    }
     return static_cast<int32_t>(size);
   }
 
-  // If we have buffered data, buffer this too and try to flush
-  if (!write_buffer_.empty()) {
-    write_buffer_.AppendData(static_cast<const uint8_t*>(data), size);
-    FlushWriteBuffer();
-    return static_cast<int32_t>(size);
+  // Queue behind earlier data, or until connected
+  QueueCopy(data, size);
+  if (connected_ && !write_blocked_) {
+    FlushWriteQueue();
   }
+  return static_cast<int32_t>(size);
+}
 
-  // Try to send directly
-  int32_t sent = socket_->Send(data, size);
-  if (sent < 0) {
-    if (socket_->IsBlocking()) {
-      // Buffer the data and try again later
-      write_buffer_.AppendData(static_cast<const uint8_t*>(data), size);
-      return static_cast<int32_t>(size);
-    }
+int32_t AsyncTCPSocket::Send(const CopyOnWriteBuffer& data) {
+  if (data.size() < kZeroCopyMinSize) {
+    return Send(data.data(), data.size());
+  }
+  if (!socket_) {
     return -1;
   }
 
-  // If not all data was sent, buffer the rest
-  if (std::cmp_less(sent, size)) {
-    write_buffer_.AppendData(static_cast<const uint8_t*>(data) + sent,
-                             size - sent);
+  write_queue_.push_back({data, false});
+  if (connected_ && !write_blocked_) {
+    FlushWriteQueue();
   }
-
-  return static_cast<int32_t>(size);
+  return static_cast<int32_t>(data.size());
 }
 
 int32_t AsyncTCPSocket::SendTo(const void* data,
@@ -132,9 +155,67 @@ int32_t AsyncTCPSocket::SendTo(const void* data,
   return Send(data, size);
 }
 
+int32_t AsyncTCPSocket::SendV(std::span<const PacketSegment> segments) {
+  if (!socket_) {
+    return -1;
+  }
+
+  size_t size = 0;
+  for (const PacketSegment& segment : segments) {
+    size += segment.data.size();
+  }
+
+  // Try to send directly, zero-copy segments go through the queue
+  size_t sent = 0;
+  if (connected_ && write_queue_.empty() && !write_blocked_ && !zerocopy_) {
+    std::array<iovec, kMaxWriteIovCount> iov;
+    size_t count = 0;
+    for (const PacketSegment& segment : segments) {
+      if (count == iov.size()) {
+        break;
+      }
+      iov[count++] = {const_cast<uint8_t*>(segment.data.data()),
+                      segment.data.size()};
+    }
+    int32_t len = socket_->SendV(iov.data(), count);
+    if (len < 0) {
+      if (!socket_->IsBlocking()) {
+        return -1;
+      }
+      write_blocked_ = true;
+    } else {
+      sent = static_cast<size_t>(len);
+    }
+  }
+  if (sent == size) {
+    return static_cast<int32_t>(size);
+  }
+
+  // Queue the rest
+  for (const PacketSegment& segment : segments) {
+    if (sent >= segment.data.size()) {
+      sent -= segment.data.size();
+      continue;
+    }
+    QueueSegment(segment, sent);
+    sent = 0;
+  }
+  if (connected_ && !write_blocked_) {
+    FlushWriteQueue();
+  }
+  return static_cast<int32_t>(size);
+}
+
+int32_t AsyncTCPSocket::SendToV(std::span<const PacketSegment> segments,
+                                const SocketAddress& addr) {
+  // TCP is connection-oriented, SendToV is the same as SendV
+  (void)addr;
+  return SendV(segments);
+}
+
 int32_t AsyncTCPSocket::Close() {
-  write_buffer_.Clear();
-  read_buffer_.Clear();
+  write_queue_.clear();
+  write_blocked_ = false;
   connected_ = false;
   if (socket_) {
     return socket_->Close();
@@ -175,6 +256,9 @@ int32_t AsyncTCPSocket::GetOption(PacketSocketOption opt, int32_t* value) {
     case PacketSocketOption::kDontFragment:
       sock_opt = Socket::OPT_DONTFRAGMENT;
       break;
+    case PacketSocketOption::kZeroCopy:
+      *value = zerocopy_ ? 1 : 0;
+      return 0;
     default:
       return -1;
   }
@@ -197,6 +281,12 @@ int32_t AsyncTCPSocket::SetOption(PacketSocketOption opt, int32_t value) {
     case PacketSocketOption::kDontFragment:
       sock_opt = Socket::OPT_DONTFRAGMENT;
       break;
+    case PacketSocketOption::kZeroCopy:
+      if (socket_->SetOption(Socket::OPT_ZEROCOPY, value) < 0) {
+        return -1;
+      }
+      zerocopy_ = value != 0;
+      return 0;
     default:
       return -1;
   }
@@ -211,39 +301,72 @@ int32_t AsyncTCPSocket::GetError() const {
 }
 
 void AsyncTCPSocket::OnReadEvent(Socket* socket [[maybe_unused]]) {
-  std::array<uint8_t, kMaxTCPReadSize> buf{};
-  int64_t timestamp = -1;
+  if (recv_buffer_.empty()) {
+    recv_buffer_ = recv_pool_.Get();
+  }
+  const SocketAddress remote_addr = socket_->GetRemoteAddress();
+  // A receiver may delete this socket from its handler.
+  const std::shared_ptr<PendingTaskFlag> alive = alive_;
+
+  // Readiness is edge triggered, read until the socket would block.
+  for (;;) {
+    int64_t timestamp = -1;
+    int32_t len = socket_->Recv(recv_buffer_.MutableData(),
+                                recv_buffer_.size(), &timestamp);
+    if (len == 0) {
+      // Connection closed by peer
+      SignalClose(this, 0);
+      return;
+    }
+    if (len < 0) {
+      if (!socket_->IsBlocking()) {
+        SignalClose(this, socket_->GetError());
+      }
+      return;
+    }
 
-  int32_t len = socket_->Recv(buf.data(), buf.size(), &timestamp);
-  if (len > 0) {
     // For TCP, we receive raw bytes. The caller can interpret as packets.
-    SignalReadPacket(this, buf.data(), static_cast<size_t>(len),
-                     socket_->GetRemoteAddress(), timestamp);
-  } else if (len == 0) {
-    // Connection closed by peer
-    SignalClose(this, 0);
-  } else if (!socket_->IsBlocking()) {
-    SignalClose(this, socket_->GetError());
+    if (!SignalReadBuffer.is_empty()) {
+      SignalReadBuffer(this, recv_buffer_.Slice(0, len), remote_addr,
+                       timestamp);
+      if (!alive->Alive()) {
+        return;
+      }
+    }
+    SignalReadPacket(this, recv_buffer_.data(), static_cast<size_t>(len),
+                     remote_addr, timestamp);
+    if (!alive->Alive()) {
+      return;
+    }
+    if (!recv_buffer_.HasOneRef()) {
+      recv_pool_.Return(std::move(recv_buffer_));
+      recv_buffer_ = recv_pool_.Get();
+    }
+    // A receiver may have closed the socket.
+    if (!socket_ || socket_->GetState() == Socket::CS_CLOSED) {
+      return;
+    }
   }
 }
 
 void AsyncTCPSocket::OnWriteEvent(Socket* socket [[maybe_unused]]) {
-  if (!write_buffer_.empty()) {
-    FlushWriteBuffer();
-  }
-  if (write_buffer_.empty()) {
+  write_blocked_ = false;
+  FlushWriteQueue();
+  if (write_queue_.empty()) {
     SignalReadyToSend(this);
   }
 }
 
 void AsyncTCPSocket::OnConnectEvent(Socket* socket [[maybe_unused]]) {
   connected_ = true;
+  const std::shared_ptr<PendingTaskFlag> alive = alive_;
   SignalConnect(this);
-
-  // Flush any buffered data
-  if (!write_buffer_.empty()) {
-    FlushWriteBuffer();
+  if (!alive->Alive()) {
+    return;
   }
+
+  // Flush any queued data
+  FlushWriteQueue();
 }
 
 void AsyncTCPSocket::OnCloseEvent(Socket* socket [[maybe_unused]],
@@ -252,20 +375,81 @@ void AsyncTCPSocket::OnCloseEvent(Socket* socket [[maybe_unused]],
   SignalClose(this, error);
 }
 
-void AsyncTCPSocket::FlushWriteBuffer() {
-  if (write_buffer_.empty() || !socket_) {
+void AsyncTCPSocket::OnZeroCopyDone(Socket* socket [[maybe_unused]],
+                                    uint32_t first [[maybe_unused]],
+                                    uint32_t last [[maybe_unused]],
+                                    bool copied) {
+  // The socket holds the data until the kernel is done, past Close().
+  if (copied && zerocopy_) {
+    AVE_LOG(LS_INFO) << "Zero-copy send fell back to copying, disabling it";
+    zerocopy_ = false;
+  }
+}
+
+void AsyncTCPSocket::QueueCopy(const void* data, size_t size) {
+  const auto* bytes = static_cast<const uint8_t*>(data);
+  if (!write_queue_.empty() && write_queue_.back().owned &&
+      write_queue_.back().data.size() + size <= kWriteSegmentSize) {
+    write_queue_.back().data.AppendData(bytes, size);
     return;
   }
+  write_queue_.push_back(
+      {CopyOnWriteBuffer(bytes, size, std::max(size, kWriteSegmentSize)),
+       true});
+}
+
+void AsyncTCPSocket::QueueSegment(const PacketSegment& segment,
+                                  size_t offset) {
+  size_t size = segment.data.size() - offset;
+  if (!segment.buffer.empty() && size >= kZeroCopyMinSize) {
+    write_queue_.push_back({segment.buffer.Slice(offset, size), false});
+  } else {
+    QueueCopy(segment.data.data() + offset, size);
+  }
+}
+
+void AsyncTCPSocket::FlushWriteQueue() {
+  // Stop only once a send would block, after a short one an edge triggered
+  // loop may not report the socket writable again.
+  while (socket_ && !write_queue_.empty()) {
+    const Segment& front = write_queue_.front();
+    int32_t sent = -1;
+    if (IsZeroCopy(front)) {
+      uint32_t id = 0;
+      sent = socket_->SendZeroCopy(front.data, &id);
+      if (sent < 0 && socket_->GetError() == ENOBUFS) {
+        // Out of memory for notifications, copy this one
+        sent = socket_->Send(front.data.data(), front.data.size());
+      }
+    } else {
+      // Gather up to the next zero-copy segment
+      std::array<iovec, kMaxWriteIovCount> iov;
+      size_t count = 0;
+      for (const Segment& segment : write_queue_) {
+        if (count == iov.size() || (count > 0 && IsZeroCopy(segment))) {
+          break;
+        }
+        iov[count++] = {const_cast<uint8_t*>(segment.data.data()),
+                        segment.data.size()};
+      }
+      sent = socket_->SendV(iov.data(), count);
+    }
 
-  int32_t sent = socket_->Send(write_buffer_.data(), write_buffer_.size());
-  if (sent > 0) {
-    // Remove sent data from buffer
-    size_t remaining = write_buffer_.size() - sent;
-    if (remaining > 0) {
-      std::memmove(write_buffer_.data(), write_buffer_.data() + sent,
-                   remaining);
+    if (sent < 0) {
+      write_blocked_ = socket_->IsBlocking();
+      return;
+    }
+
+    // Drop the sent data
+    auto left = static_cast<size_t>(sent);
+    while (!write_queue_.empty() && left >= write_queue_.front().data.size()) {
+      left -= write_queue_.front().data.size();
+      write_queue_.pop_front();
+    }
+    if (left > 0) {
+      CopyOnWriteBuffer& data = write_queue_.front().data;
+      data = data.Slice(left, data.size() - left);
     }
-    write_buffer_.SetSize(remaining);
   }
 }
 
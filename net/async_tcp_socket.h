@@ -9,11 +9,15 @@
 #define BASE_NET_ASYNC_TCP_SOCKET_H
 
 #include <cstdint>
+#include <deque>
 #include <memory>
 
 #include "base/buffer.h"
+#include "base/copy_on_write_buffer.h"
 #include "base/net/async_packet_socket.h"
+#include "base/net/receive_buffer_pool.h"
 #include "base/net/socket.h"
+#include "base/task_util/pending_task_flag.h"
 
 namespace ave {
 namespace base {
@@ -37,13 +41,28 @@ class AsyncTCPSocket : public AsyncPacketSocket {
                                 const SocketAddress& bind_addr,
                                 const SocketAddress& remote_addr);
 
+  // Smaller sends are copied even with kZeroCopy, pinning the pages and
+  // reading the notification would cost more than the copy.
+  static constexpr size_t kZeroCopyMinSize = 10 * 1024;
+  // Data copied into the write queue is gathered in segments of this size.
+  static constexpr size_t kWriteSegmentSize = 64 * 1024;
+
   // AsyncPacketSocket interface
   SocketAddress GetLocalAddress() const override;
   SocketAddress GetRemoteAddress() const override;
   int32_t Send(const void* data, size_t size) override;
+  // Like Send(), but a large `data` is queued by reference instead of copied
+  // and, with kZeroCopy enabled, transmitted by the kernel in place. The
+  // reference is held until the kernel is done.
+  int32_t Send(const CopyOnWriteBuffer& data);
   int32_t SendTo(const void* data,
                  size_t size,
                  const SocketAddress& addr) override;
+  // Large segments made from a CopyOnWriteBuffer are queued by reference,
+  // like Send(const CopyOnWriteBuffer&).
+  int32_t SendV(std::span<const PacketSegment> segments) override;
+  int32_t SendToV(std::span<const PacketSegment> segments,
+                  const SocketAddress& addr) override;
   int32_t Close() override;
   State GetState() const override;
   int32_t GetOption(PacketSocketOption opt, int32_t* value) override;
@@ -56,14 +75,43 @@ class AsyncTCPSocket : public AsyncPacketSocket {
   void OnWriteEvent(Socket* socket);
   void OnConnectEvent(Socket* socket);
   void OnCloseEvent(Socket* socket, int32_t error);
+  void OnZeroCopyDone(Socket* socket,
+                      uint32_t first,
+                      uint32_t last,
+                      bool copied);
+
+  // Appends a copy of `data` to the write queue
+  void QueueCopy(const void* data, size_t size);
+  // Appends `segment` from `offset` on to the write queue
+  void QueueSegment(const PacketSegment& segment, size_t offset);
+  // Sends queued data with writev until it is all sent or the socket would
+  // block
+  void FlushWriteQueue();
+
+  // Data not sent yet. `owned` segments hold data copied in by Send() and
+  // take more, the others are shared with the caller.
+  struct Segment {
+    CopyOnWriteBuffer data;
+    bool owned;
+  };
 
-  // Flush pending data in the write buffer
-  void FlushWriteBuffer();
+  bool IsZeroCopy(const Segment& segment) const {
+    return zerocopy_ && !segment.owned &&
+           segment.data.size() >= kZeroCopyMinSize;
+  }
 
   std::unique_ptr<Socket> socket_;
-  base::Buffer read_buffer_;
-  base::Buffer write_buffer_;
+  // Read into, replaced from the pool when a receiver keeps it.
+  ReceiveBufferPool recv_pool_;
+  CopyOnWriteBuffer recv_buffer_;
+  std::deque<Segment> write_queue_;
   bool connected_;
+  // The last send would block, nothing is sent before the write event.
+  bool write_blocked_;
+  bool zerocopy_;
+  // Cleared by the destructor, checked after each signal a receiver may
+  // delete the socket from.
+  const std::shared_ptr<PendingTaskFlag> alive_;
 };
 
 }  // namespace net
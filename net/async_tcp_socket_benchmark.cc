@@ -0,0 +1,141 @@
+/*
+ * async_tcp_socket_benchmark.cc
+ * Copyright (C) 2026 youfa <vsyfar@gmail.com>
+ *
+ * Distributed under terms of the GPLv2 license.
+ */
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "base/net/async_tcp_socket.h"
+#include "base/net/physical_socket_server.h"
+#include "benchmark/benchmark.h"
+
+namespace ave {
+namespace base {
+namespace net {
+namespace {
+
+constexpr int64_t kBytesPerIteration = 8 << 20;
+
+// Reads 4 KB at a time through a small receive buffer, so the sender backs
+// up and most of each burst waits in its write queue.
+class SlowReader : public sigslot::has_slots<> {
+ public:
+  void OnAccept(Socket* listener) {
+    socket.reset(listener->Accept(nullptr));
+    if (socket) {
+      socket->SetOption(Socket::OPT_RCVBUF, 64 * 1024);
+      socket->SignalReadEvent.connect(this, &SlowReader::OnRead);
+    }
+  }
+
+  void OnRead(Socket* s [[maybe_unused]]) {
+    uint8_t buf[4096];
+    int len;
+    while ((len = socket->Recv(buf, sizeof(buf), nullptr)) > 0) {
+      bytes += len;
+    }
+  }
+
+  std::unique_ptr<Socket> socket;
+  int64_t bytes = 0;
+};
+
+// Sends 8 MB in `state.range(0)` byte messages, then runs the loop until the
+// reader has all of it.
+void BM_TcpSendToSlowReader(benchmark::State& state) {
+  PhysicalSocketServer server;
+  std::unique_ptr<Socket> listener(server.CreateSocket(AF_INET, SOCK_STREAM));
+  listener->Bind(SocketAddress("127.0.0.1", 0));
+  listener->Listen(1);
+  SlowReader reader;
+  listener->SignalReadEvent.connect(&reader, &SlowReader::OnAccept);
+
+  std::unique_ptr<AsyncTCPSocket> sender(
+      AsyncTCPSocket::Create(server.CreateSocket(AF_INET, SOCK_STREAM),
+                             SocketAddress(), listener->GetLocalAddress()));
+  sender->SetOption(PacketSocketOption::kSendBuf, 64 * 1024);
+  while (!reader.socket ||
+         sender->GetState() != AsyncPacketSocket::STATE_CONNECTED) {
+    server.Wait(100);
+  }
+
+  const int64_t message_size = state.range(0);
+  std::vector<uint8_t> message(message_size);
+  for (auto _ : state) {
+    const int64_t target = reader.bytes + kBytesPerIteration;
+    for (int64_t sent = 0; sent < kBytesPerIteration; sent += message_size) {
+      sender->Send(message.data(), message.size());
+    }
+    while (reader.bytes < target) {
+      server.Wait(100);
+    }
+  }
+  state.SetBytesProcessed(state.iterations() * kBytesPerIteration);
+}
+
+class ByteCounter : public sigslot::has_slots<> {
+ public:
+  void OnPacket(AsyncPacketSocket* socket [[maybe_unused]],
+                const uint8_t* data [[maybe_unused]],
+                size_t size,
+                const SocketAddress& addr [[maybe_unused]],
+                int64_t timestamp [[maybe_unused]]) {
+    bytes += static_cast<int64_t>(size);
+  }
+
+  int64_t bytes = 0;
+};
+
+// Writes `state.range(0)` bytes per iteration from a plain socket and reads
+// them through AsyncTCPSocket.
+void BM_TcpReceive(benchmark::State& state) {
+  PhysicalSocketServer server;
+  std::unique_ptr<Socket> listener(server.CreateSocket(AF_INET, SOCK_STREAM));
+  listener->Bind(SocketAddress("127.0.0.1", 0));
+  listener->Listen(1);
+  std::unique_ptr<AsyncTCPSocket> receiver;
+  std::unique_ptr<Socket> sender(server.CreateSocket(AF_INET, SOCK_STREAM));
+  sender->Connect(listener->GetLocalAddress());
+  while (!receiver) {
+    server.Wait(100);
+    if (Socket* accepted = listener->Accept(nullptr)) {
+      receiver = std::make_unique<AsyncTCPSocket>(accepted);
+    }
+  }
+  ByteCounter counter;
+  receiver->SignalReadPacket.connect(&counter, &ByteCounter::OnPacket);
+
+  const int64_t size = state.range(0);
+  std::vector<uint8_t> chunk(256 * 1024);
+  for (auto _ : state) {
+    const int64_t target = counter.bytes + size;
+    for (int64_t sent = 0; sent < size;) {
+      int len = sender->Send(
+          chunk.data(), std::min<int64_t>(chunk.size(), size - sent));
+      if (len > 0) {
+        sent += len;
+      } else {
+        server.Wait(0);
+      }
+    }
+    while (counter.bytes < target) {
+      server.Wait(100);
+    }
+  }
+  state.SetBytesProcessed(state.iterations() * size);
+}
+
+BENCHMARK(BM_TcpSendToSlowReader)->Arg(1024)->Arg(64 * 1024);
+BENCHMARK(BM_TcpReceive)->Arg(4 << 20);
+
+}  // namespace
+}  // namespace net
+}  // namespace base
+}  // namespace ave
+
+BENCHMARK_MAIN();
@@ -7,7 +7,9 @@
 
 #include "base/net/async_udp_socket.h"
 
+#include <algorithm>
 #include <array>
+#include <cerrno>
 #include <cstring>
 
 #include "base/logging.h"
@@ -20,7 +22,10 @@ namespace {
 constexpr size_t kMaxUDPPacketSize = 65535;
 }  // namespace
 
-AsyncUDPSocket::AsyncUDPSocket(Socket* socket) : socket_(socket) {
+AsyncUDPSocket::AsyncUDPSocket(Socket* socket)
+    : socket_(socket),
+      recv_pool_(kMaxUDPPacketSize, kRecvBatchSize),
+      alive_(PendingTaskFlag::Create()) {
   if (socket_) {
     socket_->SignalReadEvent.connect(this, &AsyncUDPSocket::OnReadEvent);
     socket_->SignalWriteEvent.connect(this, &AsyncUDPSocket::OnWriteEvent);
@@ -28,6 +33,7 @@ AsyncUDPSocket::AsyncUDPSocket(Socket* socket) : socket_(socket) {
 }
 
 AsyncUDPSocket::~AsyncUDPSocket() {
+  alive_->SetNotAlive();
   if (socket_) {
     socket_->SignalReadEvent.disconnect(this);
     socket_->SignalWriteEvent.disconnect(this);
@@ -68,7 +74,7 @@ int32_t AsyncUDPSocket::Send(const void* data, size_t size) {
   if (!socket_) {
     return -1;
   }
-  return socket_->Send(data, size);
+  return SendPacket(data, size, SocketAddress());
 }
 
 int32_t AsyncUDPSocket::SendTo(const void* data,
@@ -77,7 +83,51 @@ int32_t AsyncUDPSocket::SendTo(const void* data,
   if (!socket_) {
     return -1;
   }
-  return socket_->SendTo(data, size, addr);
+  return SendPacket(data, size, addr);
+}
+
+int32_t AsyncUDPSocket::SendV(std::span<const PacketSegment> segments) {
+  return SendToV(segments, SocketAddress());
+}
+
+int32_t AsyncUDPSocket::SendToV(std::span<const PacketSegment> segments,
+                                const SocketAddress& addr) {
+  if (!socket_) {
+    return -1;
+  }
+
+  size_t size = 0;
+  for (const PacketSegment& segment : segments) {
+    size += segment.data.size();
+  }
+  bool segmented = segment_size_ != 0 && size > segment_size_;
+  if (segments.size() > kMaxSendSegments ||
+      (segmented && emulate_segmentation_)) {
+    return SendJoined(segments, addr);
+  }
+
+  std::array<iovec, kMaxSendSegments> iov;
+  for (size_t i = 0; i < segments.size(); ++i) {
+    iov[i] = {const_cast<uint8_t*>(segments[i].data.data()),
+              segments[i].data.size()};
+  }
+  int32_t sent = addr.IsNil()
+                     ? socket_->SendV(iov.data(), segments.size())
+                     : socket_->SendToV(iov.data(), segments.size(), addr);
+  // As in SendPacket()
+  if (sent < 0 && segmented &&
+      (socket_->GetError() == EIO || socket_->GetError() == EINVAL)) {
+    return SendJoined(segments, addr);
+  }
+  return sent;
+}
+
+int32_t AsyncUDPSocket::SendBatch(const OutgoingDatagram* datagrams,
+                                  size_t count) {
+  if (!socket_) {
+    return -1;
+  }
+  return socket_->SendToBatch(datagrams, count);
 }
 
 int32_t AsyncUDPSocket::Close() {
@@ -111,6 +161,12 @@ int32_t AsyncUDPSocket::GetOption(PacketSocketOption opt, int32_t* value) {
     case PacketSocketOption::kDontFragment:
       sock_opt = Socket::OPT_DONTFRAGMENT;
       break;
+    case PacketSocketOption::kUdpSegment:
+      *value = static_cast<int32_t>(segment_size_);
+      return 0;
+    case PacketSocketOption::kUdpGro:
+      sock_opt = Socket::OPT_UDP_GRO;
+      break;
     default:
       return -1;
   }
@@ -133,6 +189,24 @@ int32_t AsyncUDPSocket::SetOption(PacketSocketOption opt, int32_t value) {
     case PacketSocketOption::kDontFragment:
       sock_opt = Socket::OPT_DONTFRAGMENT;
       break;
+    case PacketSocketOption::kUdpSegment:
+      if (value < 0 || static_cast<size_t>(value) > kMaxUDPPacketSize) {
+        return -1;
+      }
+      segment_size_ = static_cast<size_t>(value);
+      emulate_segmentation_ =
+          socket_->SetOption(Socket::OPT_UDP_SEGMENT, value) < 0 && value > 0;
+      if (emulate_segmentation_) {
+        AVE_LOG(LS_INFO) << "UDP GSO unavailable (" << socket_->GetError()
+                         << "), sending segments in batches";
+      }
+      return 0;
+    case PacketSocketOption::kUdpGro:
+      if (socket_->SetOption(Socket::OPT_UDP_GRO, value) < 0) {
+        AVE_LOG(LS_INFO) << "UDP GRO unavailable (" << socket_->GetError()
+                         << "), receiving packets one by one";
+      }
+      return 0;
     default:
       return -1;
   }
@@ -146,18 +220,180 @@ int32_t AsyncUDPSocket::GetError() const {
   return 0;
 }
 
+int32_t AsyncUDPSocket::SendPacket(const void* data,
+                                   size_t size,
+                                   const SocketAddress& addr) {
+  if (segment_size_ == 0 || size <= segment_size_) {
+    return addr.IsNil() ? socket_->Send(data, size)
+                        : socket_->SendTo(data, size, addr);
+  }
+  if (emulate_segmentation_) {
+    return SendSegments(data, size, addr);
+  }
+
+  int32_t sent = addr.IsNil() ? socket_->Send(data, size)
+                              : socket_->SendTo(data, size, addr);
+  // EIO: the device cannot checksum segments. EINVAL: more segments than
+  // the kernel takes at once.
+  if (sent < 0 &&
+      (socket_->GetError() == EIO || socket_->GetError() == EINVAL)) {
+    return SendSegments(data, size, addr);
+  }
+  return sent;
+}
+
+int32_t AsyncUDPSocket::SendJoined(std::span<const PacketSegment> segments,
+                                   const SocketAddress& addr) {
+  std::vector<uint8_t> joined;
+  for (const PacketSegment& segment : segments) {
+    joined.insert(joined.end(), segment.data.begin(), segment.data.end());
+  }
+  return SendPacket(joined.data(), joined.size(), addr);
+}
+
+int32_t AsyncUDPSocket::SendSegments(const void* data,
+                                     size_t size,
+                                     const SocketAddress& addr) {
+  const auto* bytes = static_cast<const uint8_t*>(data);
+  send_segments_.clear();
+  for (size_t offset = 0; offset < size; offset += segment_size_) {
+    send_segments_.push_back(
+        {bytes + offset, std::min(segment_size_, size - offset), addr});
+  }
+
+  int32_t sent =
+      socket_->SendToBatch(send_segments_.data(), send_segments_.size());
+  if (sent < 0) {
+    return -1;
+  }
+  size_t sent_bytes = 0;
+  for (int32_t i = 0; i < sent; ++i) {
+    sent_bytes += send_segments_[i].size;
+  }
+  return static_cast<int32_t>(sent_bytes);
+}
+
+void AsyncUDPSocket::SplitSegments(size_t count) {
+  recv_segments_.clear();
+  for (size_t i = 0; i < count; ++i) {
+    const ReceivedDatagram& datagram = recv_batch_[i];
+    if (datagram.segment_size == 0) {
+      recv_segments_.push_back(datagram);
+      continue;
+    }
+    for (size_t offset = 0; offset < datagram.size;
+         offset += datagram.segment_size) {
+      ReceivedDatagram& segment = recv_segments_.emplace_back();
+      segment.data = datagram.data + offset;
+      segment.size = std::min(datagram.segment_size, datagram.size - offset);
+      segment.capacity = segment.size;
+      segment.addr = datagram.addr;
+      segment.timestamp = datagram.timestamp;
+    }
+  }
+}
+
 void AsyncUDPSocket::OnReadEvent(Socket* socket [[maybe_unused]]) {
-  std::array<uint8_t, kMaxUDPPacketSize> buf{};
-  SocketAddress remote_addr;
-  int64_t timestamp = -1;
-
-  int32_t len =
-      socket_->RecvFrom(buf.data(), buf.size(), &remote_addr, &timestamp);
-  if (len > 0) {
-    SignalReadPacket(this, buf.data(), static_cast<size_t>(len), remote_addr,
-                     timestamp);
-  } else if (len < 0 && !socket_->IsBlocking()) {
-    SignalClose(this, socket_->GetError());
+  if (recv_buffers_.empty()) {
+    // Not zero filled, only received bytes are handed out.
+    recv_batch_.resize(kRecvBatchSize);
+    for (size_t i = 0; i < kRecvBatchSize; ++i) {
+      recv_buffers_.push_back(recv_pool_.Get());
+      recv_batch_[i].data = recv_buffers_[i].MutableData();
+      recv_batch_[i].capacity = kMaxUDPPacketSize;
+    }
+  }
+  // A receiver may delete this socket from its handler.
+  const std::shared_ptr<PendingTaskFlag> alive = alive_;
+
+  // Readiness is edge triggered, read until the queue is empty.
+  for (;;) {
+    int32_t received =
+        socket_->RecvFromBatch(recv_batch_.data(), recv_batch_.size());
+    if (received < 0) {
+      if (!socket_->IsBlocking()) {
+        SignalClose(this, socket_->GetError());
+      }
+      return;
+    }
+
+    const size_t count = static_cast<size_t>(received);
+    if (!SignalReadBuffer.is_empty() && !DeliverBuffers(count, *alive)) {
+      return;
+    }
+    if (!DeliverPackets(count, *alive)) {
+      return;
+    }
+    ReplaceKeptBuffers(count);
+    if (count < recv_batch_.size()) {
+      return;
+    }
+  }
+}
+
+bool AsyncUDPSocket::DeliverBuffers(size_t count,
+                                    const PendingTaskFlag& alive) {
+  for (size_t i = 0; i < count; ++i) {
+    const ReceivedDatagram& datagram = recv_batch_[i];
+    if (datagram.size == 0) {
+      continue;
+    }
+    // Packets coalesced by GRO are slices of one buffer.
+    size_t segment_size =
+        datagram.segment_size > 0 ? datagram.segment_size : datagram.size;
+    for (size_t offset = 0; offset < datagram.size; offset += segment_size) {
+      SignalReadBuffer(
+          this,
+          recv_buffers_[i].Slice(offset,
+                                 std::min(segment_size, datagram.size - offset)),
+          datagram.addr, datagram.timestamp);
+      if (!alive.Alive()) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+bool AsyncUDPSocket::DeliverPackets(size_t count,
+                                    const PendingTaskFlag& alive) {
+  if (SignalReadPacketBatch.is_empty() && SignalReadPacket.is_empty()) {
+    return true;
+  }
+  const ReceivedDatagram* packets = recv_batch_.data();
+  if (std::any_of(recv_batch_.begin(), recv_batch_.begin() + count,
+                  [](const ReceivedDatagram& datagram) {
+                    return datagram.segment_size > 0;
+                  })) {
+    SplitSegments(count);
+    packets = recv_segments_.data();
+    count = recv_segments_.size();
+  }
+
+  if (!SignalReadPacketBatch.is_empty()) {
+    SignalReadPacketBatch(this, packets, count);
+    return alive.Alive();
+  }
+  for (size_t i = 0; i < count; ++i) {
+    const ReceivedDatagram& datagram = packets[i];
+    if (datagram.size > 0) {
+      SignalReadPacket(this, datagram.data, datagram.size, datagram.addr,
+                       datagram.timestamp);
+      if (!alive.Alive()) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+void AsyncUDPSocket::ReplaceKeptBuffers(size_t count) {
+  for (size_t i = 0; i < count; ++i) {
+    if (!recv_buffers_[i].HasOneRef()) {
+      recv_pool_.Return(std::move(recv_buffers_[i]));
+      recv_buffers_[i] = recv_pool_.Get();
+      recv_batch_[i].data = recv_buffers_[i].MutableData();
+    }
   }
 }
 
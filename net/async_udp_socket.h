@@ -10,9 +10,12 @@
 
 #include <cstdint>
 #include <memory>
+#include <vector>
 
 #include "base/net/async_packet_socket.h"
+#include "base/net/receive_buffer_pool.h"
 #include "base/net/socket.h"
+#include "base/task_util/pending_task_flag.h"
 
 namespace ave {
 namespace base {
@@ -42,18 +45,72 @@ class AsyncUDPSocket : public AsyncPacketSocket {
   int32_t SendTo(const void* data,
                  size_t size,
                  const SocketAddress& addr) override;
+  // One sendmsg() with a piece per segment, up to kMaxSendSegments. More
+  // segments, or kUdpSegment emulation, join them first.
+  int32_t SendV(std::span<const PacketSegment> segments) override;
+  int32_t SendToV(std::span<const PacketSegment> segments,
+                  const SocketAddress& addr) override;
   int32_t Close() override;
   State GetState() const override;
   int32_t GetOption(PacketSocketOption opt, int32_t* value) override;
   int32_t SetOption(PacketSocketOption opt, int32_t value) override;
   int32_t GetError() const override;
 
+  // Sends `datagrams` in order with as few system calls as possible. Returns
+  // how many were sent, or -1 if none was.
+  int32_t SendBatch(const OutgoingDatagram* datagrams, size_t count);
+
+  // Each read drains the socket in batches of up to kRecvBatchSize
+  // datagrams. While this signal is connected it is emitted once per batch
+  // instead of SignalReadPacket once per datagram. Packets coalesced by GRO
+  // are split first, each entry is one packet. The datagrams are only valid
+  // during the call.
+  sigslot::signal3<AsyncUDPSocket*, const ReceivedDatagram*, size_t>
+      SignalReadPacketBatch;
+
+  static constexpr size_t kRecvBatchSize = 16;
+  static constexpr size_t kMaxSendSegments = 64;
+
  private:
   // Socket signal handlers
   void OnReadEvent(Socket* socket);
   void OnWriteEvent(Socket* socket);
 
+  // Send() and SendTo() with kUdpSegment applied, a nil `addr` sends to the
+  // connected peer.
+  int32_t SendPacket(const void* data, size_t size, const SocketAddress& addr);
+  // SendV() and SendToV() with a copy of `segments` in one buffer.
+  int32_t SendJoined(std::span<const PacketSegment> segments,
+                     const SocketAddress& addr);
+  // Sends `data` as segment sized packets with one SendToBatch().
+  int32_t SendSegments(const void* data,
+                       size_t size,
+                       const SocketAddress& addr);
+  // Fills `recv_segments_` with the packets of the first `count` entries of
+  // `recv_batch_`, pointing into the receive buffers.
+  void SplitSegments(size_t count);
+  // Emit SignalReadBuffer, and SignalReadPacketBatch or SignalReadPacket,
+  // for the first `count` entries of `recv_batch_`. Return false if a
+  // receiver deleted the socket.
+  bool DeliverBuffers(size_t count, const PendingTaskFlag& alive);
+  bool DeliverPackets(size_t count, const PendingTaskFlag& alive);
+  // Replaces the receive buffers that receivers kept.
+  void ReplaceKeptBuffers(size_t count);
+
   std::unique_ptr<Socket> socket_;
+  // kRecvBatchSize maximum sized buffers, allocated on the first read and
+  // reused. Pages are only touched as far as datagrams fill them.
+  ReceiveBufferPool recv_pool_;
+  std::vector<CopyOnWriteBuffer> recv_buffers_;
+  std::vector<ReceivedDatagram> recv_batch_;
+  std::vector<ReceivedDatagram> recv_segments_;
+  std::vector<OutgoingDatagram> send_segments_;
+  // kUdpSegment, and whether the kernel refused it.
+  size_t segment_size_ = 0;
+  bool emulate_segmentation_ = false;
+  // Cleared by the destructor, checked after each signal a receiver may
+  // delete the socket from.
+  const std::shared_ptr<PendingTaskFlag> alive_;
 };
 
 }  // namespace net
@@ -0,0 +1,155 @@
+/*
+ * async_udp_socket_benchmark.cc
+ * Copyright (C) 2026 youfa <vsyfar@gmail.com>
+ *
+ * Distributed under terms of the GPLv2 license.
+ */
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "base/net/async_udp_socket.h"
+#include "base/net/physical_socket.h"
+#include "base/net/physical_socket_server.h"
+#include "benchmark/benchmark.h"
+
+namespace ave {
+namespace base {
+namespace net {
+namespace {
+
+constexpr size_t kPayloadSize = 200;
+
+class PacketCounter : public sigslot::has_slots<> {
+ public:
+  void OnPacket(AsyncPacketSocket* socket [[maybe_unused]],
+                const uint8_t* data [[maybe_unused]],
+                size_t size [[maybe_unused]],
+                const SocketAddress& addr [[maybe_unused]],
+                int64_t timestamp [[maybe_unused]]) {
+    ++count;
+  }
+
+  int64_t count = 0;
+};
+
+enum class SendMode { kSendTo, kSendBatch, kSegmented };
+
+// Sends `state.range(0)` datagrams over loopback, with one SendTo() each, one
+// SendBatch() or one segmented SendTo() with GSO and GRO enabled, and
+// receives them through the socket server.
+void RunLoopback(benchmark::State& state, SendMode mode) {
+  PhysicalSocketServer server;
+  std::unique_ptr<AsyncUDPSocket> sender(AsyncUDPSocket::Create(
+      server.CreateSocket(AF_INET, SOCK_DGRAM), SocketAddress("127.0.0.1", 0)));
+  std::unique_ptr<AsyncUDPSocket> receiver(AsyncUDPSocket::Create(
+      server.CreateSocket(AF_INET, SOCK_DGRAM), SocketAddress("127.0.0.1", 0)));
+  receiver->SetOption(PacketSocketOption::kRecvBuf, 4 << 20);
+  PacketCounter counter;
+  receiver->SignalReadPacket.connect(&counter, &PacketCounter::OnPacket);
+
+  const int64_t count = state.range(0);
+  const SocketAddress to = receiver->GetLocalAddress();
+  std::vector<uint8_t> payload(kPayloadSize);
+  std::vector<uint8_t> segmented(count * kPayloadSize);
+  if (mode == SendMode::kSegmented) {
+    sender->SetOption(PacketSocketOption::kUdpSegment, kPayloadSize);
+    receiver->SetOption(PacketSocketOption::kUdpGro, 1);
+  }
+  std::vector<OutgoingDatagram> datagrams(count,
+                                          {payload.data(), payload.size(), to});
+
+  for (auto _ : state) {
+    counter.count = 0;
+    switch (mode) {
+      case SendMode::kSendTo:
+        for (int64_t i = 0; i < count; ++i) {
+          sender->SendTo(payload.data(), payload.size(), to);
+        }
+        break;
+      case SendMode::kSendBatch:
+        sender->SendBatch(datagrams.data(), datagrams.size());
+        break;
+      case SendMode::kSegmented:
+        sender->SendTo(segmented.data(), segmented.size(), to);
+        break;
+    }
+    while (counter.count < count) {
+      server.Wait(10);
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * count);
+}
+
+void BM_UdpLoopbackSendTo(benchmark::State& state) {
+  RunLoopback(state, SendMode::kSendTo);
+}
+
+void BM_UdpLoopbackSendBatch(benchmark::State& state) {
+  RunLoopback(state, SendMode::kSendBatch);
+}
+
+void BM_UdpLoopbackSegmented(benchmark::State& state) {
+  RunLoopback(state, SendMode::kSegmented);
+}
+
+// Queues `state.range(0)` datagrams on a plain socket and drains them with
+// one RecvFrom() each or with RecvFromBatch().
+void RunRecv(benchmark::State& state, bool batch) {
+  PhysicalSocketServer server;
+  std::unique_ptr<Socket> sender(server.CreateSocket(AF_INET, SOCK_DGRAM));
+  std::unique_ptr<Socket> receiver(server.CreateSocket(AF_INET, SOCK_DGRAM));
+  sender->Bind(SocketAddress("127.0.0.1", 0));
+  receiver->Bind(SocketAddress("127.0.0.1", 0));
+
+  const int64_t count = state.range(0);
+  std::vector<uint8_t> payload(kPayloadSize);
+  std::vector<OutgoingDatagram> datagrams(
+      count, {payload.data(), payload.size(), receiver->GetLocalAddress()});
+  std::vector<uint8_t> buffer(PhysicalSocket::kMaxBatchSize * kPayloadSize);
+  std::vector<ReceivedDatagram> received(PhysicalSocket::kMaxBatchSize);
+  for (size_t i = 0; i < received.size(); ++i) {
+    received[i].data = buffer.data() + i * kPayloadSize;
+    received[i].capacity = kPayloadSize;
+  }
+
+  for (auto _ : state) {
+    state.PauseTiming();
+    sender->SendToBatch(datagrams.data(), datagrams.size());
+    state.ResumeTiming();
+    int64_t left = count;
+    while (left > 0) {
+      if (batch) {
+        left -= std::max(
+            receiver->RecvFromBatch(received.data(), received.size()), 0);
+      } else if (receiver->RecvFrom(buffer.data(), kPayloadSize, nullptr,
+                                    nullptr) >= 0) {
+        --left;
+      }
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * count);
+}
+
+void BM_UdpRecvFrom(benchmark::State& state) {
+  RunRecv(state, false);
+}
+
+void BM_UdpRecvFromBatch(benchmark::State& state) {
+  RunRecv(state, true);
+}
+
+BENCHMARK(BM_UdpLoopbackSendTo)->Arg(16)->Arg(64);
+BENCHMARK(BM_UdpLoopbackSendBatch)->Arg(16)->Arg(64);
+BENCHMARK(BM_UdpLoopbackSegmented)->Arg(16)->Arg(64);
+BENCHMARK(BM_UdpRecvFrom)->Arg(16)->Arg(64);
+BENCHMARK(BM_UdpRecvFromBatch)->Arg(16)->Arg(64);
+
+}  // namespace
+}  // namespace net
+}  // namespace base
+}  // namespace ave
+
+BENCHMARK_MAIN();
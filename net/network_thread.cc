@@ -64,8 +64,8 @@ void NetworkThread::Run() {
     // Process pending tasks
     ProcessTasks();
 
-    // Wait for network events (100ms timeout)
-    socket_server_->Wait(100);
+    // Wait for network events, PostTask() and Stop() wake us up
+    socket_server_->Wait(SocketServer::kForever);
   }
 
   // Process any remaining tasks before exit
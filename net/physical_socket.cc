@@ -8,10 +8,16 @@
 #include "base/net/physical_socket.h"
 
 #include <fcntl.h>
+#include <linux/errqueue.h>
 #include <netinet/tcp.h>
+#include <netinet/udp.h>
+#include <poll.h>
 #include <sys/socket.h>
 #include <unistd.h>
+#include <algorithm>
+#include <array>
 #include <cerrno>
+#include <cstring>
 
 #include "base/logging.h"
 
@@ -89,9 +95,7 @@ SocketAddress PhysicalSocket::GetLocalAddress() const {
   }
 
   SocketAddress result;
-  if (addr->sa_family == AF_INET) {
-    result.FromSockAddr(*reinterpret_cast<sockaddr_in*>(addr));
-  }
+  SocketAddressFromSockAddrStorage(addr_storage, &result);
   return result;
 }
 
@@ -105,18 +109,16 @@ SocketAddress PhysicalSocket::GetRemoteAddress() const {
   }
 
   SocketAddress result;
-  if (addr->sa_family == AF_INET) {
-    result.FromSockAddr(*reinterpret_cast<sockaddr_in*>(addr));
-  }
+  SocketAddressFromSockAddrStorage(addr_storage, &result);
   return result;
 }
 
 int32_t PhysicalSocket::Bind(const SocketAddress& addr) {
-  sockaddr_in saddr{};
-  addr.ToSockAddr(&saddr);
+  sockaddr_storage saddr{};
+  size_t len = addr.ToSockAddrStorage(&saddr);
 
-  int32_t err =
-      ::bind(socket_fd_, reinterpret_cast<sockaddr*>(&saddr), sizeof(saddr));
+  int32_t err = ::bind(socket_fd_, reinterpret_cast<sockaddr*>(&saddr),
+                       static_cast<socklen_t>(len));
   if (err < 0) {
     error_ = errno;
     return -1;
@@ -126,11 +128,11 @@ int32_t PhysicalSocket::Bind(const SocketAddress& addr) {
 }
 
 int32_t PhysicalSocket::Connect(const SocketAddress& addr) {
-  sockaddr_in saddr{};
-  addr.ToSockAddr(&saddr);
+  sockaddr_storage saddr{};
+  size_t len = addr.ToSockAddrStorage(&saddr);
 
-  int32_t err =
-      ::connect(socket_fd_, reinterpret_cast<sockaddr*>(&saddr), sizeof(saddr));
+  int32_t err = ::connect(socket_fd_, reinterpret_cast<sockaddr*>(&saddr),
+                          static_cast<socklen_t>(len));
   if (err == 0) {
     state_ = CS_CONNECTED;
     remote_addr_ = addr;
@@ -156,14 +158,122 @@ int32_t PhysicalSocket::Send(const void* pv, size_t cb) {
   return static_cast<int32_t>(sent);
 }
 
+int32_t PhysicalSocket::SendV(const iovec* iov, size_t count) {
+  msghdr msg{};
+  msg.msg_iov = const_cast<iovec*>(iov);
+  msg.msg_iovlen = std::min(count, kMaxIovCount);
+  ssize_t sent = ::sendmsg(socket_fd_, &msg, MSG_NOSIGNAL);
+  if (sent < 0) {
+    error_ = errno;
+    return -1;
+  }
+  return static_cast<int32_t>(sent);
+}
+
+int32_t PhysicalSocket::SendToV(const iovec* iov,
+                                size_t count,
+                                const SocketAddress& addr) {
+  if (count > kMaxIovCount) {
+    return Socket::SendToV(iov, count, addr);
+  }
+  sockaddr_storage saddr{};
+  size_t len = addr.ToSockAddrStorage(&saddr);
+
+  // No address sends to the connected peer.
+  msghdr msg{};
+  msg.msg_name = len > 0 ? &saddr : nullptr;
+  msg.msg_namelen = static_cast<socklen_t>(len);
+  msg.msg_iov = const_cast<iovec*>(iov);
+  msg.msg_iovlen = count;
+  ssize_t sent = ::sendmsg(socket_fd_, &msg, MSG_NOSIGNAL);
+  if (sent < 0) {
+    error_ = errno;
+    return -1;
+  }
+  return static_cast<int32_t>(sent);
+}
+
+int32_t PhysicalSocket::SendZeroCopy(const CopyOnWriteBuffer& data,
+                                     uint32_t* id) {
+  if (!zerocopy_) {
+    error_ = EOPNOTSUPP;
+    return -1;
+  }
+  ssize_t sent = ::send(socket_fd_, data.data(), data.size(),
+                        MSG_NOSIGNAL | MSG_ZEROCOPY);
+  if (sent < 0) {
+    // The kernel takes the id back on failure.
+    error_ = errno;
+    return -1;
+  }
+  *id = zerocopy_next_id_++;
+  zerocopy_sends_.push_back({*id, false, data});
+  return static_cast<int32_t>(sent);
+}
+
+bool PhysicalSocket::ReadZeroCopyNotifications() {
+  if (!zerocopy_ || socket_fd_ < 0) {
+    return false;
+  }
+
+  bool notified = false;
+  while (true) {
+    alignas(cmsghdr) uint8_t control[CMSG_SPACE(sizeof(sock_extended_err))];
+    msghdr msg{};
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+    if (::recvmsg(socket_fd_, &msg, MSG_ERRQUEUE | MSG_DONTWAIT) < 0) {
+      break;
+    }
+    cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+    if (!cmsg || !((cmsg->cmsg_level == SOL_IP &&
+                    cmsg->cmsg_type == IP_RECVERR) ||
+                   (cmsg->cmsg_level == SOL_IPV6 &&
+                    cmsg->cmsg_type == IPV6_RECVERR))) {
+      continue;
+    }
+    sock_extended_err err{};
+    memcpy(&err, CMSG_DATA(cmsg), sizeof(err));
+    if (err.ee_origin != SO_EE_ORIGIN_ZEROCOPY || err.ee_errno != 0) {
+      continue;
+    }
+    notified = true;
+    uint32_t first = err.ee_info;
+    uint32_t last = err.ee_data;
+    for (ZeroCopySend& send : zerocopy_sends_) {
+      // Ids wrap around
+      if (send.id - first <= last - first) {
+        send.done = true;
+      }
+    }
+    while (!zerocopy_sends_.empty() && zerocopy_sends_.front().done) {
+      zerocopy_sends_.pop_front();
+    }
+    SignalZeroCopyDone(this, err.ee_info, err.ee_data,
+                       (err.ee_code & SO_EE_CODE_ZEROCOPY_COPIED) != 0);
+    if (socket_fd_ < 0) {
+      return false;
+    }
+  }
+  if (!notified) {
+    return false;
+  }
+
+  // A real socket error comes with its own event, a hangup may not.
+  pollfd pfd{socket_fd_, 0, 0};
+  return ::poll(&pfd, 1, 0) == 0 || !(pfd.revents & POLLHUP);
+}
+
 int32_t PhysicalSocket::SendTo(const void* pv,
                                size_t cb,
                                const SocketAddress& addr) {
-  sockaddr_in saddr{};
-  addr.ToSockAddr(&saddr);
+  sockaddr_storage saddr{};
+  size_t len = addr.ToSockAddrStorage(&saddr);
 
-  ssize_t sent = ::sendto(socket_fd_, pv, cb, MSG_NOSIGNAL,
-                          reinterpret_cast<sockaddr*>(&saddr), sizeof(saddr));
+  // No address sends to the connected peer.
+  auto* name = len > 0 ? reinterpret_cast<sockaddr*>(&saddr) : nullptr;
+  ssize_t sent = ::sendto(socket_fd_, pv, cb, MSG_NOSIGNAL, name,
+                          static_cast<socklen_t>(len));
   if (sent < 0) {
     error_ = errno;
     return -1;
@@ -191,7 +301,7 @@ int32_t PhysicalSocket::RecvFrom(void* pv,
     *timestamp = -1;
   }
 
-  sockaddr_in saddr{};
+  sockaddr_storage saddr{};
   socklen_t addr_len = sizeof(saddr);
 
   ssize_t received = ::recvfrom(socket_fd_, pv, cb, 0,
@@ -202,11 +312,97 @@ int32_t PhysicalSocket::RecvFrom(void* pv,
   }
 
   if (paddr) {
-    paddr->FromSockAddr(saddr);
+    SocketAddressFromSockAddrStorage(saddr, paddr);
   }
   return static_cast<int32_t>(received);
 }
 
+int32_t PhysicalSocket::RecvFromBatch(ReceivedDatagram* datagrams,
+                                      size_t count) {
+  count = std::min(count, kMaxBatchSize);
+  // Only the first `count` entries are set up and used.
+  std::array<mmsghdr, kMaxBatchSize> msgs;
+  std::array<iovec, kMaxBatchSize> iovs;
+  std::array<sockaddr_storage, kMaxBatchSize> saddrs;
+  // One UDP_GRO control message per datagram.
+  alignas(cmsghdr) char control[kMaxBatchSize][CMSG_SPACE(sizeof(int))];
+  for (size_t i = 0; i < count; ++i) {
+    iovs[i].iov_base = datagrams[i].data;
+    iovs[i].iov_len = datagrams[i].capacity;
+    msgs[i].msg_hdr = {};
+    msgs[i].msg_hdr.msg_iov = &iovs[i];
+    msgs[i].msg_hdr.msg_iovlen = 1;
+    msgs[i].msg_hdr.msg_name = &saddrs[i];
+    msgs[i].msg_hdr.msg_namelen = sizeof(saddrs[i]);
+    if (udp_gro_) {
+      msgs[i].msg_hdr.msg_control = control[i];
+      msgs[i].msg_hdr.msg_controllen = sizeof(control[i]);
+    }
+  }
+
+  int32_t received = ::recvmmsg(socket_fd_, msgs.data(),
+                                static_cast<unsigned int>(count), 0, nullptr);
+  if (received < 0) {
+    error_ = errno;
+    return -1;
+  }
+  for (int32_t i = 0; i < received; ++i) {
+    datagrams[i].size = msgs[i].msg_len;
+    datagrams[i].addr.Clear();
+    SocketAddressFromSockAddrStorage(saddrs[i], &datagrams[i].addr);
+    datagrams[i].timestamp = -1;
+    datagrams[i].segment_size = 0;
+    for (cmsghdr* cmsg = CMSG_FIRSTHDR(&msgs[i].msg_hdr); cmsg;
+         cmsg = CMSG_NXTHDR(&msgs[i].msg_hdr, cmsg)) {
+      if (cmsg->cmsg_level == SOL_UDP && cmsg->cmsg_type == UDP_GRO) {
+        int segment_size = 0;
+        memcpy(&segment_size, CMSG_DATA(cmsg), sizeof(segment_size));
+        if (segment_size > 0 &&
+            static_cast<size_t>(segment_size) < datagrams[i].size) {
+          datagrams[i].segment_size = static_cast<size_t>(segment_size);
+        }
+      }
+    }
+  }
+  return received;
+}
+
+int32_t PhysicalSocket::SendToBatch(const OutgoingDatagram* datagrams,
+                                    size_t count) {
+  std::array<mmsghdr, kMaxBatchSize> msgs;
+  std::array<iovec, kMaxBatchSize> iovs;
+  std::array<sockaddr_storage, kMaxBatchSize> saddrs;
+  size_t sent = 0;
+  while (sent < count) {
+    size_t n = std::min(count - sent, kMaxBatchSize);
+    for (size_t i = 0; i < n; ++i) {
+      const OutgoingDatagram& datagram = datagrams[sent + i];
+      iovs[i].iov_base = const_cast<void*>(datagram.data);
+      iovs[i].iov_len = datagram.size;
+      msgs[i].msg_hdr = {};
+      msgs[i].msg_hdr.msg_iov = &iovs[i];
+      msgs[i].msg_hdr.msg_iovlen = 1;
+      if (!datagram.addr.IsNil()) {
+        msgs[i].msg_hdr.msg_name = &saddrs[i];
+        msgs[i].msg_hdr.msg_namelen =
+            static_cast<socklen_t>(datagram.addr.ToSockAddrStorage(&saddrs[i]));
+      }
+    }
+
+    int32_t result = ::sendmmsg(socket_fd_, msgs.data(),
+                                static_cast<unsigned int>(n), MSG_NOSIGNAL);
+    if (result < 0) {
+      error_ = errno;
+      break;
+    }
+    sent += static_cast<size_t>(result);
+    if (static_cast<size_t>(result) < n) {
+      break;
+    }
+  }
+  return sent > 0 || count == 0 ? static_cast<int32_t>(sent) : -1;
+}
+
 int32_t PhysicalSocket::Listen(int32_t backlog) {
   int32_t err = ::listen(socket_fd_, backlog);
   if (err < 0) {
@@ -218,7 +414,7 @@ int32_t PhysicalSocket::Listen(int32_t backlog) {
 }
 
 Socket* PhysicalSocket::Accept(SocketAddress* paddr) {
-  sockaddr_in saddr{};
+  sockaddr_storage saddr{};
   socklen_t addr_len = sizeof(saddr);
 
   int32_t new_fd =
@@ -229,7 +425,7 @@ Socket* PhysicalSocket::Accept(SocketAddress* paddr) {
   }
 
   if (paddr) {
-    paddr->FromSockAddr(saddr);
+    SocketAddressFromSockAddrStorage(saddr, paddr);
   }
 
   return new PhysicalSocket(socket_server_, new_fd, family_, type_);
@@ -240,6 +436,7 @@ int32_t PhysicalSocket::Close() {
     ::close(socket_fd_);
     socket_fd_ = -1;
   }
+  zerocopy_sends_.clear();
   state_ = CS_CLOSED;
   return 0;
 }
@@ -275,6 +472,17 @@ int32_t PhysicalSocket::GetOption(Option opt, int32_t* value) {
       level = IPPROTO_IPV6;
       optname = IPV6_V6ONLY;
       break;
+    case OPT_UDP_SEGMENT:
+      level = SOL_UDP;
+      optname = UDP_SEGMENT;
+      break;
+    case OPT_UDP_GRO:
+      level = SOL_UDP;
+      optname = UDP_GRO;
+      break;
+    case OPT_ZEROCOPY:
+      optname = SO_ZEROCOPY;
+      break;
     default:
       return -1;
   }
@@ -307,6 +515,17 @@ int32_t PhysicalSocket::SetOption(Option opt, int32_t value) {
       level = IPPROTO_IPV6;
       optname = IPV6_V6ONLY;
       break;
+    case OPT_UDP_SEGMENT:
+      level = SOL_UDP;
+      optname = UDP_SEGMENT;
+      break;
+    case OPT_UDP_GRO:
+      level = SOL_UDP;
+      optname = UDP_GRO;
+      break;
+    case OPT_ZEROCOPY:
+      optname = SO_ZEROCOPY;
+      break;
     default:
       return -1;
   }
@@ -316,6 +535,12 @@ int32_t PhysicalSocket::SetOption(Option opt, int32_t value) {
     error_ = errno;
     return -1;
   }
+  if (opt == OPT_UDP_GRO) {
+    udp_gro_ = value != 0;
+  }
+  if (opt == OPT_ZEROCOPY) {
+    zerocopy_ = value != 0;
+  }
   return 0;
 }
 
@@ -9,7 +9,9 @@
 #define BASE_NET_PHYSICAL_SOCKET_H
 
 #include <cstdint>
+#include <deque>
 
+#include "base/copy_on_write_buffer.h"
 #include "base/net/socket.h"
 #include "base/net/socket_address.h"
 
@@ -41,6 +43,18 @@ class PhysicalSocket : public Socket {
                    size_t cb,
                    SocketAddress* paddr,
                    int64_t* timestamp) override;
+  // recvmmsg()/sendmmsg() based, up to kMaxBatchSize datagrams per call.
+  // Reports GRO segment sizes once OPT_UDP_GRO is enabled, RecvFrom() does
+  // not.
+  int32_t RecvFromBatch(ReceivedDatagram* datagrams, size_t count) override;
+  int32_t SendToBatch(const OutgoingDatagram* datagrams,
+                      size_t count) override;
+  // sendmsg() based, up to kMaxIovCount pieces per call.
+  int32_t SendV(const iovec* iov, size_t count) override;
+  int32_t SendToV(const iovec* iov,
+                  size_t count,
+                  const SocketAddress& addr) override;
+  int32_t SendZeroCopy(const CopyOnWriteBuffer& data, uint32_t* id) override;
   int32_t Listen(int32_t backlog) override;
   Socket* Accept(SocketAddress* paddr) override;
   int32_t Close() override;
@@ -50,9 +64,21 @@ class PhysicalSocket : public Socket {
   int32_t GetOption(Option opt, int32_t* value) override;
   int32_t SetOption(Option opt, int32_t value) override;
 
+  static constexpr size_t kMaxBatchSize = 64;
+  static constexpr size_t kMaxIovCount = 64;
+
   // Returns the underlying socket file descriptor
   int32_t GetSocketFD() const { return socket_fd_; }
 
+  // Reads the MSG_ZEROCOPY notifications queued on the error queue, releases
+  // the data of the sends they cover and emits SignalZeroCopyDone for them.
+  // Returns true if there were some and the socket has no real error or
+  // hangup pending besides.
+  bool ReadZeroCopyNotifications();
+
+  // Whether the kernel may still read from data given to SendZeroCopy().
+  bool HasZeroCopySends() const { return !zerocopy_sends_.empty(); }
+
  protected:
   // For subclasses to create socket with an existing fd
   PhysicalSocket(PhysicalSocketServer* ss,
@@ -80,6 +106,18 @@ class PhysicalSocket : public Socket {
   ConnState state_;
   SocketAddress local_addr_;
   SocketAddress remote_addr_;
+  bool udp_gro_ = false;
+  bool zerocopy_ = false;
+  // Id of the next SendZeroCopy(), the kernel counts the same way.
+  uint32_t zerocopy_next_id_ = 0;
+
+  // A SendZeroCopy() whose data the kernel may still read from.
+  struct ZeroCopySend {
+    uint32_t id;
+    bool done;
+    CopyOnWriteBuffer data;
+  };
+  std::deque<ZeroCopySend> zerocopy_sends_;
 };
 
 }  // namespace net
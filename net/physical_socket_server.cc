@@ -9,6 +9,8 @@
 
 #include <sys/epoll.h>
 #include <sys/eventfd.h>
+#include <sys/syscall.h>
+#include <sys/timerfd.h>
 #include <unistd.h>
 #include <array>
 #include <cerrno>
@@ -56,13 +58,28 @@ uint32_t EpollEventsToDispatcherEvents(uint32_t epoll_events) {
 }  // namespace
 
 PhysicalSocketServer::PhysicalSocketServer()
-    : epoll_fd_(-1), wakeup_fd_(-1), processing_(false) {
+    : epoll_fd_(-1),
+      wakeup_fd_(-1),
+      wakeup_pending_(false),
+      timer_fd_(-1),
+      timer_armed_(false),
+#if defined(SYS_epoll_pwait2)
+      has_epoll_pwait2_(true),
+#else
+      has_epoll_pwait2_(false),
+#endif
+      processing_(false) {
   if (!InitEpoll()) {
     AVE_LOG(LS_ERROR) << "Failed to initialize epoll";
   }
 }
 
 PhysicalSocketServer::~PhysicalSocketServer() {
+  // Unregisters them while `epoll_fd_` is still open.
+  lingering_.clear();
+  if (timer_fd_ >= 0) {
+    ::close(timer_fd_);
+  }
   if (wakeup_fd_ >= 0) {
     ::close(wakeup_fd_);
   }
@@ -107,6 +124,65 @@ Socket* PhysicalSocketServer::CreateSocket(int32_t family, int32_t type) {
 }
 
 bool PhysicalSocketServer::Wait(int32_t cms) {
+  return WaitUs(cms == kForever ? kForever : static_cast<int64_t>(cms) * 1000);
+}
+
+int32_t PhysicalSocketServer::EpollWait(struct epoll_event* events,
+                                        int32_t max_events,
+                                        int64_t timeout_us) {
+  if (timeout_us <= 0) {
+    if (timer_armed_) {
+      struct itimerspec disarm {};
+      ::timerfd_settime(timer_fd_, 0, &disarm, nullptr);
+      timer_armed_ = false;
+    }
+    return ::epoll_wait(epoll_fd_, events, max_events,
+                        timeout_us < 0 ? -1 : 0);
+  }
+
+  struct timespec timeout {};
+  timeout.tv_sec = static_cast<time_t>(timeout_us / 1000000);
+  timeout.tv_nsec = static_cast<long>(timeout_us % 1000000) * 1000;
+#if defined(SYS_epoll_pwait2)
+  if (has_epoll_pwait2_) {
+    auto nfds = static_cast<int32_t>(::syscall(SYS_epoll_pwait2, epoll_fd_,
+                                               events, max_events, &timeout,
+                                               nullptr, 0));
+    if (nfds >= 0 || errno != ENOSYS) {
+      return nfds;
+    }
+    has_epoll_pwait2_ = false;
+  }
+#endif
+
+  if (timer_fd_ < 0) {
+    timer_fd_ = ::timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    struct epoll_event ev {};
+    ev.events = EPOLLIN;
+    ev.data.ptr = &timer_fd_;
+    if (timer_fd_ < 0 ||
+        ::epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, timer_fd_, &ev) < 0) {
+      AVE_LOG(LS_WARNING) << "timerfd unavailable, rounding timeouts to ms: "
+                          << strerror(errno);
+      if (timer_fd_ >= 0) {
+        ::close(timer_fd_);
+        timer_fd_ = -1;
+      }
+    }
+  }
+  if (timer_fd_ < 0) {
+    return ::epoll_wait(epoll_fd_, events, max_events,
+                        static_cast<int32_t>((timeout_us + 999) / 1000));
+  }
+
+  struct itimerspec expiry {};
+  expiry.it_value = timeout;
+  ::timerfd_settime(timer_fd_, 0, &expiry, nullptr);
+  timer_armed_ = true;
+  return ::epoll_wait(epoll_fd_, events, max_events, -1);
+}
+
+bool PhysicalSocketServer::WaitUs(int64_t timeout_us) {
   if (epoll_fd_ < 0) {
     return false;
   }
@@ -115,15 +191,13 @@ bool PhysicalSocketServer::Wait(int32_t cms) {
   ProcessPendingOperations();
 
   std::array<struct epoll_event, kMaxEpollEvents> events{};
-  int32_t timeout_ms = cms;
 
   {
     std::scoped_lock lock(mutex_);
     processing_ = true;
   }
 
-  int32_t nfds =
-      ::epoll_wait(epoll_fd_, events.data(), kMaxEpollEvents, timeout_ms);
+  int32_t nfds = EpollWait(events.data(), kMaxEpollEvents, timeout_us);
 
   {
     std::scoped_lock lock(mutex_);
@@ -144,9 +218,18 @@ bool PhysicalSocketServer::Wait(int32_t cms) {
 
   for (int32_t i = 0; i < nfds; ++i) {
     if (events[i].data.ptr == nullptr) {
-      // Wakeup event - drain the eventfd
+      // Wakeup event - drain the eventfd. Whoever posts after this writes
+      // again, whoever posted before is seen by the caller once we return.
       uint64_t val{};
       ::read(wakeup_fd_, &val, sizeof(val));
+      wakeup_pending_.store(false, std::memory_order_release);
+      continue;
+    }
+    if (events[i].data.ptr == &timer_fd_) {
+      // The timeout of a timerfd wait expired.
+      uint64_t expirations{};
+      ::read(timer_fd_, &expirations, sizeof(expirations));
+      timer_armed_ = false;
       continue;
     }
 
@@ -177,17 +260,42 @@ bool PhysicalSocketServer::Wait(int32_t cms) {
 
   // Process any pending operations that occurred during event processing
   ProcessPendingOperations();
+  ReapLingering();
 
   return true;
 }
 
 void PhysicalSocketServer::WakeUp() {
+  if (wakeup_pending_.exchange(true, std::memory_order_acq_rel)) {
+    return;
+  }
   if (wakeup_fd_ >= 0) {
     uint64_t val = 1;
     ::write(wakeup_fd_, &val, sizeof(val));
   }
 }
 
+void PhysicalSocketServer::Linger(SocketDispatcher* dispatcher) {
+  std::scoped_lock lock(mutex_);
+  lingering_.emplace_back(dispatcher);
+}
+
+void PhysicalSocketServer::ReapLingering() {
+  std::vector<std::unique_ptr<SocketDispatcher>> done;
+  {
+    std::scoped_lock lock(mutex_);
+    for (auto it = lingering_.begin(); it != lingering_.end();) {
+      if ((*it)->HasZeroCopySends()) {
+        ++it;
+        continue;
+      }
+      done.push_back(std::move(*it));
+      it = lingering_.erase(it);
+    }
+  }
+  // Destroyed outside the lock, they unregister themselves.
+}
+
 void PhysicalSocketServer::Add(Dispatcher* dispatcher) {
   if (!dispatcher) {
     return;
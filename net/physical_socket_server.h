@@ -8,7 +8,11 @@
 #ifndef BASE_NET_PHYSICAL_SOCKET_SERVER_H
 #define BASE_NET_PHYSICAL_SOCKET_SERVER_H
 
+#include <sys/epoll.h>
+
+#include <atomic>
 #include <cstdint>
+#include <memory>
 #include <mutex>
 #include <set>
 #include <vector>
@@ -19,6 +23,8 @@ namespace ave {
 namespace base {
 namespace net {
 
+class SocketDispatcher;
+
 // PhysicalSocketServer implements SocketServer using Linux epoll.
 // It provides the event loop for monitoring socket I/O events.
 class PhysicalSocketServer : public SocketServer {
@@ -35,11 +41,21 @@ class PhysicalSocketServer : public SocketServer {
 
   // SocketServer interface
   bool Wait(int32_t cms) override;
+  // Sleeps with epoll_pwait2() where the kernel has it, and on a timerfd
+  // otherwise, so timeouts are not rounded to milliseconds.
+  bool WaitUs(int64_t timeout_us) override;
+  // Writes the eventfd only if no wakeup is pending yet, so a burst of posts
+  // costs one syscall per loop iteration.
   void WakeUp() override;
   void Add(Dispatcher* dispatcher) override;
   void Remove(Dispatcher* dispatcher) override;
   void Update(Dispatcher* dispatcher) override;
 
+  // Takes a closed socket whose zero-copy sends the kernel may still read
+  // from and destroys it, closing its descriptor, once they are all done.
+  // Sockets still lingering when the server goes are closed with it.
+  void Linger(SocketDispatcher* dispatcher);
+
  private:
   // Initialize epoll and eventfd
   bool InitEpoll();
@@ -53,14 +69,30 @@ class PhysicalSocketServer : public SocketServer {
   // Process pending dispatcher operations
   void ProcessPendingOperations();
 
+  // Destroys the lingering sockets that are done.
+  void ReapLingering();
+
+  // epoll_wait() with a timeout in microseconds.
+  int32_t EpollWait(struct epoll_event* events,
+                    int32_t max_events,
+                    int64_t timeout_us);
+
   int32_t epoll_fd_;
   int32_t wakeup_fd_;  // eventfd for WakeUp()
+  // Set by the WakeUp() that writes `wakeup_fd_`, cleared once Wait() has
+  // drained it.
+  std::atomic<bool> wakeup_pending_;
+  // Fallback for kernels without epoll_pwait2(), created on first use.
+  int32_t timer_fd_;
+  bool timer_armed_;
+  bool has_epoll_pwait2_;
 
   mutable std::mutex mutex_;
   std::set<Dispatcher*> dispatchers_;
   std::vector<Dispatcher*> pending_add_;
   std::vector<Dispatcher*> pending_remove_;
   bool processing_;  // True when processing events
+  std::vector<std::unique_ptr<SocketDispatcher>> lingering_;
 };
 
 }  // namespace net
@@ -0,0 +1,55 @@
+/*
+ * receive_buffer_pool.cc
+ * Copyright (C) 2026 youfa <vsyfar@gmail.com>
+ *
+ * Distributed under terms of the GPLv2 license.
+ */
+
+#include "base/net/receive_buffer_pool.h"
+
+#include <utility>
+
+namespace ave {
+namespace base {
+namespace net {
+
+ReceiveBufferPool::ReceiveBufferPool(size_t buffer_size, size_t max_buffers)
+    : buffer_size_(buffer_size), max_buffers_(max_buffers) {
+  buffers_.reserve(max_buffers_);
+}
+
+ReceiveBufferPool::~ReceiveBufferPool() = default;
+
+CopyOnWriteBuffer ReceiveBufferPool::Get() {
+  for (size_t i = 0; i < buffers_.size(); ++i) {
+    if (buffers_[i].HasOneRef()) {
+      CopyOnWriteBuffer buffer = std::move(buffers_[i]);
+      buffers_[i] = std::move(buffers_.back());
+      buffers_.pop_back();
+      buffer.SetSize(buffer_size_);
+      return buffer;
+    }
+  }
+  // Uninitialized
+  return CopyOnWriteBuffer(buffer_size_, buffer_size_);
+}
+
+void ReceiveBufferPool::Return(CopyOnWriteBuffer buffer) {
+  if (buffer.capacity() < buffer_size_) {
+    return;
+  }
+  if (buffers_.size() < max_buffers_) {
+    buffers_.push_back(std::move(buffer));
+    return;
+  }
+  for (CopyOnWriteBuffer& held : buffers_) {
+    if (!held.HasOneRef()) {
+      held = std::move(buffer);
+      return;
+    }
+  }
+}
+
+}  // namespace net
+}  // namespace base
+}  // namespace ave
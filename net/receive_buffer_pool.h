@@ -0,0 +1,65 @@
+/*
+ * receive_buffer_pool.h
+ * Copyright (C) 2026 youfa <vsyfar@gmail.com>
+ *
+ * Distributed under terms of the GPLv2 license.
+ */
+
+#ifndef BASE_NET_RECEIVE_BUFFER_POOL_H
+#define BASE_NET_RECEIVE_BUFFER_POOL_H
+
+#include <cstddef>
+#include <vector>
+
+#include "base/copy_on_write_buffer.h"
+
+namespace ave {
+namespace base {
+namespace net {
+
+// ReceiveBufferPool hands out receive buffers of one size without zero
+// filling them. A socket reads into a buffer, delivers it, and keeps reusing
+// it as long as no receiver holds a reference. A buffer a receiver kept is
+// given back with Return() and comes out of Get() again once the receiver
+// drops it.
+//
+//   ReceiveBufferPool pool(64 * 1024, 4);
+//   CopyOnWriteBuffer buffer = pool.Get();
+//   ... read into buffer.MutableData() and deliver ...
+//   if (!buffer.HasOneRef()) {
+//     pool.Return(std::move(buffer));
+//     buffer = pool.Get();
+//   }
+//
+// Not thread safe, it belongs to the socket's thread.
+class ReceiveBufferPool {
+ public:
+  // Keeps up to `max_buffers` returned buffers of `buffer_size` bytes.
+  ReceiveBufferPool(size_t buffer_size, size_t max_buffers);
+  ~ReceiveBufferPool();
+
+  // Disallow copy
+  ReceiveBufferPool(const ReceiveBufferPool&) = delete;
+  ReceiveBufferPool& operator=(const ReceiveBufferPool&) = delete;
+
+  // Returns an unshared buffer of buffer_size() bytes, the contents are
+  // undefined.
+  CopyOnWriteBuffer Get();
+
+  // Takes `buffer` back, for reuse once no one else references it. If the
+  // pool is full it replaces a buffer that is still referenced elsewhere.
+  void Return(CopyOnWriteBuffer buffer);
+
+  size_t buffer_size() const { return buffer_size_; }
+
+ private:
+  const size_t buffer_size_;
+  const size_t max_buffers_;
+  std::vector<CopyOnWriteBuffer> buffers_;
+};
+
+}  // namespace net
+}  // namespace base
+}  // namespace ave
+
+#endif /* !BASE_NET_RECEIVE_BUFFER_POOL_H */
@@ -0,0 +1,58 @@
+/*
+ * receive_buffer_pool_unittest.cc
+ * Copyright (C) 2026 youfa <vsyfar@gmail.com>
+ *
+ * Distributed under terms of the GPLv2 license.
+ */
+
+#include "base/net/receive_buffer_pool.h"
+
+#include <utility>
+
+#include <gtest/gtest.h>
+
+namespace ave {
+namespace base {
+namespace net {
+namespace {
+
+TEST(ReceiveBufferPoolTest, GetReturnsFullSizeUnsharedBuffer) {
+  ReceiveBufferPool pool(1024, 2);
+  CopyOnWriteBuffer buffer = pool.Get();
+  EXPECT_EQ(buffer.size(), 1024u);
+  EXPECT_TRUE(buffer.HasOneRef());
+}
+
+TEST(ReceiveBufferPoolTest, ReusesBufferOnceReleased) {
+  ReceiveBufferPool pool(1024, 2);
+  CopyOnWriteBuffer buffer = pool.Get();
+  const uint8_t* data = buffer.data();
+  CopyOnWriteBuffer kept = buffer.Slice(0, 10);
+  pool.Return(std::move(buffer));
+
+  // Still referenced by `kept`.
+  CopyOnWriteBuffer other = pool.Get();
+  EXPECT_NE(other.data(), data);
+
+  kept = CopyOnWriteBuffer();
+  CopyOnWriteBuffer reused = pool.Get();
+  EXPECT_EQ(reused.data(), data);
+  EXPECT_EQ(reused.size(), 1024u);
+}
+
+TEST(ReceiveBufferPoolTest, FullPoolReplacesReferencedBuffer) {
+  ReceiveBufferPool pool(1024, 1);
+  CopyOnWriteBuffer first = pool.Get();
+  CopyOnWriteBuffer kept = first;
+  pool.Return(std::move(first));
+
+  CopyOnWriteBuffer second = pool.Get();
+  const uint8_t* data = second.data();
+  pool.Return(std::move(second));
+  EXPECT_EQ(pool.Get().data(), data);
+}
+
+}  // namespace
+}  // namespace net
+}  // namespace base
+}  // namespace ave
@@ -7,8 +7,73 @@
 
 #include "socket.h"
 
+#include <cstring>
+#include <vector>
+
 namespace ave {
 namespace base {
-namespace net {}  // namespace net
+namespace net {
+
+int Socket::RecvFromBatch(ReceivedDatagram* datagrams, size_t count) {
+  size_t received = 0;
+  for (; received < count; ++received) {
+    ReceivedDatagram& datagram = datagrams[received];
+    int len = RecvFrom(datagram.data, datagram.capacity, &datagram.addr,
+                       &datagram.timestamp);
+    if (len < 0) {
+      break;
+    }
+    datagram.size = static_cast<size_t>(len);
+  }
+  return received > 0 || count == 0 ? static_cast<int>(received) : -1;
+}
+
+int Socket::SendToBatch(const OutgoingDatagram* datagrams, size_t count) {
+  size_t sent = 0;
+  for (; sent < count; ++sent) {
+    const OutgoingDatagram& datagram = datagrams[sent];
+    int len = datagram.addr.IsNil()
+                  ? Send(datagram.data, datagram.size)
+                  : SendTo(datagram.data, datagram.size, datagram.addr);
+    if (len < 0) {
+      break;
+    }
+  }
+  return sent > 0 || count == 0 ? static_cast<int>(sent) : -1;
+}
+
+int Socket::SendV(const iovec* iov, size_t count) {
+  size_t sent = 0;
+  for (size_t i = 0; i < count; ++i) {
+    int len = Send(iov[i].iov_base, iov[i].iov_len);
+    if (len < 0) {
+      return sent > 0 ? static_cast<int>(sent) : -1;
+    }
+    sent += static_cast<size_t>(len);
+    if (static_cast<size_t>(len) < iov[i].iov_len) {
+      break;
+    }
+  }
+  return static_cast<int>(sent);
+}
+
+int Socket::SendToV(const iovec* iov,
+                    size_t count,
+                    const SocketAddress& addr) {
+  std::vector<uint8_t> joined;
+  for (size_t i = 0; i < count; ++i) {
+    const auto* data = static_cast<const uint8_t*>(iov[i].iov_base);
+    joined.insert(joined.end(), data, data + iov[i].iov_len);
+  }
+  return SendTo(joined.data(), joined.size(), addr);
+}
+
+int Socket::SendZeroCopy(const CopyOnWriteBuffer& data [[maybe_unused]],
+                         uint32_t* id [[maybe_unused]]) {
+  SetError(EOPNOTSUPP);
+  return -1;
+}
+
+}  // namespace net
 }  // namespace base
 }  // namespace ave
@@ -14,7 +14,11 @@
 #include <netinet/in.h>
 #include <sys/socket.h>
 #include <sys/types.h>
+#include <sys/uio.h>
+#include <cstddef>
+#include <cstdint>
 
+#include "base/copy_on_write_buffer.h"
 #include "base/net/socket_address.h"
 #include "base/third_party/sigslot/sigslot.h"
 
@@ -26,6 +30,28 @@ inline bool IsBlockingError(int e) {
   return (e == EWOULDBLOCK) || (e == EAGAIN) || (e == EINPROGRESS);
 }
 
+// One datagram of Socket::RecvFromBatch(). `data` and `capacity` describe the
+// caller's buffer, the rest is filled in on receive.
+struct ReceivedDatagram {
+  uint8_t* data = nullptr;
+  size_t capacity = 0;
+  size_t size = 0;
+  SocketAddress addr;
+  // In units of microseconds, -1 if unknown.
+  int64_t timestamp = -1;
+  // Non-zero if the kernel coalesced several packets of this size (UDP GRO),
+  // the last one may be shorter.
+  size_t segment_size = 0;
+};
+
+// One datagram of Socket::SendToBatch(). A nil `addr` sends to the connected
+// peer.
+struct OutgoingDatagram {
+  const void* data = nullptr;
+  size_t size = 0;
+  SocketAddress addr;
+};
+
 // General interface for the socket implementations of various networks.  The
 // methods match those of normal UNIX sockets very closely.
 class Socket {
@@ -53,6 +79,29 @@ class Socket {
                        size_t cb,
                        SocketAddress* paddr,
                        int64_t* timestamp) = 0;
+  // Receives up to `count` datagrams with as few system calls as the
+  // implementation can. Returns the number received, or -1 if none was and
+  // the error is set. The default calls RecvFrom() until it would block.
+  virtual int RecvFromBatch(ReceivedDatagram* datagrams, size_t count);
+  // Sends `datagrams` in order. Returns how many were sent, or -1 if none was
+  // and the error is set. The default calls SendTo() or Send() for each.
+  virtual int SendToBatch(const OutgoingDatagram* datagrams, size_t count);
+
+  // Sends the `count` pieces in `iov` in order, like one Send() of them all.
+  // Returns the number of bytes sent. The default calls Send() for each piece
+  // until one is short.
+  virtual int SendV(const iovec* iov, size_t count);
+  // Sends the pieces in `iov` as one datagram to `addr`. The default joins
+  // them in a temporary buffer for SendTo().
+  virtual int SendToV(const iovec* iov,
+                      size_t count,
+                      const SocketAddress& addr);
+
+  // Sends like Send(), but the kernel reads `data` in place instead of
+  // copying it (MSG_ZEROCOPY). The socket holds a reference to `data` until
+  // SignalZeroCopyDone covers `*id`, past Close() if need be. Requires
+  // OPT_ZEROCOPY. The default fails with EOPNOTSUPP.
+  virtual int SendZeroCopy(const CopyOnWriteBuffer& data, uint32_t* id);
   virtual int Listen(int backlog) = 0;
   virtual Socket* Accept(SocketAddress* paddr) = 0;
   virtual int Close() = 0;
@@ -73,6 +122,9 @@ class Socket {
     OPT_RTP_SENDTIME_EXTN_ID,  // This is a non-traditional socket option param.
                                // This is specific to libjingle and will be used
                                // if SendTime option is needed at socket level.
+    OPT_UDP_SEGMENT,           // UDP GSO segment size, 0 disables
+    OPT_UDP_GRO,               // whether UDP GRO is enabled
+    OPT_ZEROCOPY,              // whether SendZeroCopy() is allowed
   };
   virtual int GetOption(Option opt, int* value) = 0;
   virtual int SetOption(Option opt, int value) = 0;
@@ -87,6 +139,9 @@ class Socket {
   sigslot::signal1<Socket*, sigslot::multi_threaded_local> SignalWriteEvent;
   sigslot::signal1<Socket*> SignalConnectEvent;     // connected
   sigslot::signal2<Socket*, int> SignalCloseEvent;  // closed
+  // SendZeroCopy() ids `first` to `last` are done with their data. `copied`
+  // if the kernel copied it after all, as it does on loopback.
+  sigslot::signal4<Socket*, uint32_t, uint32_t, bool> SignalZeroCopyDone;
 
  protected:
   Socket() {}
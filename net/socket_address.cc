@@ -282,6 +282,43 @@ bool SocketAddress::FromSockAddr(const sockaddr_in& saddr) {
   return true;
 }
 
+size_t SocketAddress::ToSockAddrStorage(sockaddr_storage* saddr) const {
+  memset(saddr, 0, sizeof(*saddr));
+  if (ip_.family() == AF_INET) {
+    auto* saddr4 = reinterpret_cast<sockaddr_in*>(saddr);
+    saddr4->sin_family = AF_INET;
+    saddr4->sin_port = HostToNetwork16(port_);
+    saddr4->sin_addr = ip_.ipv4();
+    return sizeof(sockaddr_in);
+  }
+  if (ip_.family() == AF_INET6) {
+    auto* saddr6 = reinterpret_cast<sockaddr_in6*>(saddr);
+    saddr6->sin6_family = AF_INET6;
+    saddr6->sin6_port = HostToNetwork16(port_);
+    saddr6->sin6_addr = ip_.ipv6();
+    saddr6->sin6_scope_id = scope_id_;
+    return sizeof(sockaddr_in6);
+  }
+  saddr->ss_family = AF_UNSPEC;
+  return 0;
+}
+
+bool SocketAddressFromSockAddrStorage(const sockaddr_storage& saddr,
+                                      SocketAddress* out) {
+  if (saddr.ss_family == AF_INET) {
+    const auto* saddr4 = reinterpret_cast<const sockaddr_in*>(&saddr);
+    return out->FromSockAddr(*saddr4);
+  }
+  if (saddr.ss_family == AF_INET6) {
+    const auto* saddr6 = reinterpret_cast<const sockaddr_in6*>(&saddr);
+    *out = SocketAddress(IPAddress(saddr6->sin6_addr),
+                         NetworkToHost16(saddr6->sin6_port));
+    out->SetScopeID(static_cast<int>(saddr6->sin6_scope_id));
+    return true;
+  }
+  return false;
+}
+
 SocketAddress EmptySocketAddressWithFamily(int family) {
   if (family == AF_INET) {
     return SocketAddress(IPAddress(INADDR_ANY), 0);
@@ -131,6 +131,10 @@ class SocketAddress {
   // Read this address from a sockaddr_in.
   bool FromSockAddr(const sockaddr_in& saddr);
 
+  // Write this address to a sockaddr_in or sockaddr_in6, as fits the IP
+  // family. Returns the length to pass to the kernel, 0 if the IP is unset.
+  size_t ToSockAddrStorage(sockaddr_storage* saddr) const;
+
  private:
   std::string hostname_;
   IPAddress ip_;
@@ -139,6 +143,11 @@ class SocketAddress {
   bool literal_{};  // Indicates that 'hostname_' contains a literal IP string.
 };
 
+// Reads `out` from an IPv4 or IPv6 address, returns false for any other
+// family.
+bool SocketAddressFromSockAddrStorage(const sockaddr_storage& saddr,
+                                      SocketAddress* out);
+
 SocketAddress EmptySocketAddressWithFamily(int family);
 
 }  // namespace net
@@ -7,6 +7,8 @@
 
 #include "base/net/socket_dispatcher.h"
 
+#include <sys/socket.h>
+
 #include <cerrno>
 
 #include "base/net/physical_socket_server.h"
@@ -27,7 +29,7 @@ SocketDispatcher::SocketDispatcher(PhysicalSocketServer* ss,
     : PhysicalSocket(ss, socket_fd, family, type), registered_(false) {}
 
 SocketDispatcher::~SocketDispatcher() {
-  RemoveFromServer();
+  Close();
 }
 
 int32_t SocketDispatcher::Bind(const SocketAddress& addr) {
@@ -48,14 +50,17 @@ int32_t SocketDispatcher::Connect(const SocketAddress& addr) {
 
 int32_t SocketDispatcher::Listen(int32_t backlog) {
   int32_t result = PhysicalSocket::Listen(backlog);
-  if (result == 0) {
+  if (result == 0 && registered_) {
+    // Bind() registered it before it wanted any events.
+    socket_server_->Update(this);
+  } else if (result == 0) {
     MaybeAddToServer();
   }
   return result;
 }
 
 Socket* SocketDispatcher::Accept(SocketAddress* paddr) {
-  sockaddr_in saddr{};
+  sockaddr_storage saddr{};
   socklen_t addr_len = sizeof(saddr);
 
   int32_t new_fd =
@@ -66,7 +71,7 @@ Socket* SocketDispatcher::Accept(SocketAddress* paddr) {
   }
 
   if (paddr) {
-    paddr->FromSockAddr(saddr);
+    SocketAddressFromSockAddrStorage(saddr, paddr);
   }
 
   auto* dispatcher =
@@ -77,6 +82,25 @@ Socket* SocketDispatcher::Accept(SocketAddress* paddr) {
 
 int32_t SocketDispatcher::Close() {
   RemoveFromServer();
+  if (HasZeroCopySends() && socket_fd_ >= 0 && socket_server_ &&
+      !lingering_) {
+    // close() does not cancel queued data, the kernel may still transmit
+    // from the pinned pages. Hand the descriptor and the data to a dispatcher
+    // the server keeps until the last notification.
+    auto* linger =
+        new SocketDispatcher(socket_server_, socket_fd_, family_, type_);
+    linger->lingering_ = true;
+    linger->zerocopy_ = true;
+    linger->zerocopy_next_id_ = zerocopy_next_id_;
+    linger->zerocopy_sends_ = std::move(zerocopy_sends_);
+    zerocopy_sends_.clear();
+    ::shutdown(socket_fd_, SHUT_WR);
+    socket_fd_ = -1;
+    linger->MaybeAddToServer();
+    // Some may have arrived already.
+    linger->ReadZeroCopyNotifications();
+    socket_server_->Linger(linger);
+  }
   return PhysicalSocket::Close();
 }
 
@@ -90,6 +114,10 @@ bool SocketDispatcher::IsDescriptorClosed() {
 
 uint32_t SocketDispatcher::GetRequestedEvents() {
   uint32_t events = 0;
+  if (lingering_) {
+    // The error queue is reported regardless.
+    return events;
+  }
 
   if (GetState() == CS_CONNECTING) {
     // For connecting sockets, we need both read and write events
@@ -107,6 +135,16 @@ uint32_t SocketDispatcher::GetRequestedEvents() {
 }
 
 void SocketDispatcher::OnEvent(uint32_t events, int32_t error) {
+  if (lingering_) {
+    ReadZeroCopyNotifications();
+    return;
+  }
+
+  // MSG_ZEROCOPY notifications on the error queue are reported as an error.
+  if ((events & DE_CLOSE) && error == 0 && ReadZeroCopyNotifications()) {
+    events &= ~DE_CLOSE;
+  }
+
   if (error != 0) {
     SetError(error);
     SignalCloseEvent(this, error);
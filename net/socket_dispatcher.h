@@ -54,6 +54,9 @@ class SocketDispatcher : public PhysicalSocket, public Dispatcher {
   void RemoveFromServer();
 
   bool registered_;
+  // Closed with zero-copy sends in flight, kept by the server and only
+  // reading their notifications, see PhysicalSocketServer::Linger().
+  bool lingering_ = false;
 };
 
 }  // namespace net
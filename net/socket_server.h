@@ -30,6 +30,16 @@ class SocketServer : public SocketFactory {
   // Returns true if events were processed, false on timeout or error.
   virtual bool Wait(int32_t cms) = 0;
 
+  // Like Wait() with a timeout in microseconds, kForever waits forever.
+  // The default rounds the timeout up to whole milliseconds.
+  virtual bool WaitUs(int64_t timeout_us) {
+    if (timeout_us < 0) {
+      return Wait(kForever);
+    }
+    int64_t cms = (timeout_us + 999) / 1000;
+    return Wait(cms > INT32_MAX ? INT32_MAX : static_cast<int32_t>(cms));
+  }
+
   // Wakes up the Wait() call from another thread.
   virtual void WakeUp() = 0;
 
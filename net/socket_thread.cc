@@ -7,8 +7,11 @@
 
 #include "base/net/socket_thread.h"
 
-#include <chrono>
+#include <algorithm>
+#include <cstdint>
+#include <limits>
 
+#include "base/count_down_latch.h"
 #include "base/logging.h"
 #include "base/net/physical_socket_server.h"
 
@@ -31,7 +34,9 @@ SocketThread::SocketThread()
 SocketThread::SocketThread(std::unique_ptr<SocketServer> socket_server)
     : socket_server_(std::move(socket_server)),
       running_(false),
-      owned_thread_(false) {}
+      owned_thread_(false),
+      watchdog_(TaskWatchdog::Register("SocketThread")),
+      stats_("SocketThread") {}
 
 SocketThread::~SocketThread() {
   Stop();
@@ -42,6 +47,10 @@ void SocketThread::Start() {
     return;
   }
   running_ = true;
+  {
+    std::scoped_lock lock(task_mutex_);
+    stopped_ = false;
+  }
   owned_thread_ = true;
   thread_ = std::thread(&SocketThread::RunInternal, this);
 }
@@ -51,60 +60,268 @@ void SocketThread::Stop() {
     return;
   }
   running_ = false;
+  {
+    std::scoped_lock lock(task_mutex_);
+    stopped_ = true;
+    space_cv_.notify_all();
+  }
   socket_server_->WakeUp();
 
   if (owned_thread_ && thread_.joinable()) {
     thread_.join();
   }
+
+  // Queued tasks will not run any more. Destroy them outside the lock, which
+  // also releases callers waiting in Invoke() or PostDelayedTaskAndWait().
+  std::deque<PendingTask> dropped;
+  std::priority_queue<DelayedTask, std::vector<DelayedTask>, std::greater<>>
+      dropped_delayed;
+  {
+    std::scoped_lock lock(task_mutex_);
+    dropped.swap(tasks_);
+    dropped_delayed.swap(delayed_tasks_);
+  }
 }
 
-bool SocketThread::IsCurrent() const {
-  return std::this_thread::get_id() == thread_id_;
+bool SocketThread::PostTask(std::function<void()> task,
+                            std::source_location location) {
+  return Post({.task = std::move(task), .location = location}, 0);
 }
 
-void SocketThread::PostTask(std::function<void()> task) {
+bool SocketThread::PostDroppableTask(std::function<void()> task,
+                                     std::source_location location) {
+  return Post(
+      {.task = std::move(task), .location = location, .droppable = true}, 0);
+}
+
+size_t SocketThread::PostTasks(std::vector<std::function<void()>> tasks,
+                               std::source_location location) {
+  if (tasks.empty()) {
+    return 0;
+  }
+  size_t accepted = 0;
+  bool high = false;
+  std::vector<PendingTask> dropped;
   {
-    std::scoped_lock lock(task_mutex_);
-    tasks_.push(std::move(task));
+    std::unique_lock<std::mutex> lock(task_mutex_);
+    if (stopped_) {
+      return 0;
+    }
+    uint64_t now_us = TaskRunnerStatsRecorder::kEnabled ? NowUs() : 0;
+    for (auto& task : tasks) {
+      if (Enqueue(lock,
+                  {.task = std::move(task), .location = location,
+                   .ready_us = now_us},
+                  &high, &dropped)) {
+        ++accepted;
+      }
+    }
   }
   socket_server_->WakeUp();
+  if (high) {
+    limits_.on_high();
+  }
+  return accepted;
 }
 
-void SocketThread::PostDelayedTask(std::function<void()> task,
-                                   int64_t delay_ms) {
-  DelayedTask delayed;
-  delayed.task = std::move(task);
-  delayed.run_time_ms = CurrentTimeMs() + delay_ms;
+void SocketThread::SetQueueLimits(TaskQueueLimits limits) {
+  std::scoped_lock lock(task_mutex_);
+  limits_ = std::move(limits);
+}
 
+void SocketThread::Destruct() {
+  Stop();
+  delete this;
+}
+
+void SocketThread::PostTask(std::unique_ptr<Task> task) {
+  PostDelayedTaskAndWait(std::move(task), 0, false);
+}
+
+void SocketThread::PostDelayedTask(std::unique_ptr<Task> task,
+                                   uint64_t delay_us) {
+  PostDelayedTaskAndWait(std::move(task), delay_us, false);
+}
+
+void SocketThread::PostDelayedTaskAndWait(std::unique_ptr<Task> task,
+                                          uint64_t delay_us,
+                                          bool wait) {
+  CountDownLatch done(1);
+  PendingTask pending;
+  if (wait) {
+    pending.task = [task = InlineTask(std::move(task)),
+                    done = ScopedCountDown(&done)]() mutable {
+      std::move(task).Run();
+    };
+  } else {
+    pending.task = InlineTask(std::move(task));
+  }
+  if (Post(std::move(pending), delay_us) && wait) {
+    done.Wait();
+  }
+}
+
+void SocketThread::PostInlineTask(InlineTask task, uint64_t delay_us) {
+  Post({.task = std::move(task)}, delay_us);
+}
+
+bool SocketThread::PostTaskWithOptions(InlineTask task, PostOptions options) {
+  PendingTask pending{.task = std::move(task),
+                      .location = options.location,
+                      .droppable = options.droppable};
+  if (options.deadline_us > 0) {
+    pending.deadline_us = NowUs() + options.deadline_us;
+    if (options.on_late) {
+      pending.on_late =
+          std::make_unique<InlineTask>(std::move(options.on_late));
+    }
+  }
+  return Post(std::move(pending), options.delay_us, options.slack_us);
+}
+
+TaskRunnerStats SocketThread::GetStats() const {
+  return stats_.Get();
+}
+
+bool SocketThread::Post(PendingTask task,
+                        uint64_t delay_us,
+                        uint64_t slack_us) {
+  bool high = false;
+  std::vector<PendingTask> dropped;
   {
-    std::scoped_lock lock(task_mutex_);
-    delayed_tasks_.push(std::move(delayed));
+    std::unique_lock<std::mutex> lock(task_mutex_);
+    if (stopped_) {
+      return false;
+    }
+    if (delay_us > 0) {
+      uint64_t now_us = NowUs();
+      delayed_tasks_.push({.pending = std::move(task),
+                           .run_time_us = DueTimeUs(now_us, delay_us, slack_us),
+                           .order = delayed_order_++});
+    } else {
+      task.ready_us = TaskRunnerStatsRecorder::kEnabled ? NowUs() : 0;
+      if (!Enqueue(lock, std::move(task), &high, &dropped)) {
+        return false;
+      }
+    }
   }
   socket_server_->WakeUp();
+  if (high) {
+    limits_.on_high();
+  }
+  return true;
 }
 
-void SocketThread::Invoke(std::function<void()> task) {
-  if (IsCurrent()) {
-    // Already on this thread, just run it
-    task();
-    return;
+bool SocketThread::Enqueue(std::unique_lock<std::mutex>& lock,
+                           PendingTask task,
+                           bool* high,
+                           std::vector<PendingTask>* dropped) {
+  if (limits_.capacity > 0 && Depth() >= limits_.capacity) {
+    switch (limits_.policy) {
+      case QueueFullPolicy::kReject:
+        stats_.OnOverflow();
+        dropped->push_back(std::move(task));
+        return false;
+
+      case QueueFullPolicy::kDropOldest: {
+        auto oldest = std::find_if(
+            tasks_.begin(), tasks_.end(),
+            [](const PendingTask& queued) { return queued.droppable; });
+        stats_.OnOverflow();
+        if (oldest == tasks_.end()) {
+          dropped->push_back(std::move(task));
+          return false;
+        }
+        dropped->push_back(std::move(*oldest));
+        tasks_.erase(oldest);
+        stats_.OnDropped(1);
+        break;
+      }
+
+      case QueueFullPolicy::kBlock:
+      default:
+        // Waiting on our own thread would never end.
+        if (IsCurrent()) {
+          break;
+        }
+        // Tasks posted before the wait may still be unseen by the thread.
+        socket_server_->WakeUp();
+        ++blocked_posters_;
+        space_cv_.wait(lock, [this] {
+          return !running_ || Depth() < limits_.capacity;
+        });
+        --blocked_posters_;
+        if (!running_) {
+          dropped->push_back(std::move(task));
+          return false;
+        }
+        break;
+    }
+  }
+
+  tasks_.push_back(std::move(task));
+  stats_.OnQueued(1);
+  CheckHighWatermark(high);
+  return true;
+}
+
+void SocketThread::MoveDueTasks(uint64_t now_us, bool* high) {
+  size_t moved = 0;
+  while (!delayed_tasks_.empty() &&
+         delayed_tasks_.top().run_time_us <= now_us) {
+    // TODO(youfa): remove const_cast by changing the priority_queue to hold
+    // non-const DelayedTask
+    // NOLINTBEGIN(cppcoreguidelines-pro-type-const-cast)
+    auto& top = const_cast<DelayedTask&>(delayed_tasks_.top());
+    // NOLINTEND(cppcoreguidelines-pro-type-const-cast)
+    top.pending.ready_us = top.run_time_us;
+    tasks_.push_back(std::move(top.pending));
+    delayed_tasks_.pop();
+    ++moved;
+  }
+  if (moved > 0) {
+    stats_.OnQueued(moved);
+    CheckHighWatermark(high);
+  }
+}
+
+void SocketThread::CheckHighWatermark(bool* high) {
+  if (limits_.high_watermark > 0 && !above_high_ &&
+      Depth() >= limits_.high_watermark) {
+    above_high_ = true;
+    *high = *high || static_cast<bool>(limits_.on_high);
   }
+}
 
-  // Post task and wait for completion
-  std::atomic<bool> done{false};
+void SocketThread::PostDelayedTask(std::function<void()> task,
+                                   int64_t delay_ms,
+                                   std::source_location location) {
+  Post({.task = std::move(task), .location = location},
+       static_cast<uint64_t>(std::max<int64_t>(delay_ms, 0)) * 1000);
+}
 
-  PostTask([&]() {
+bool SocketThread::Invoke(std::function<void()> task,
+                          std::source_location location) {
+  if (IsCurrent()) {
+    // Already on this thread, just run it
     task();
-    {
-      std::scoped_lock lock(invoke_mutex_);
-      done = true;
-    }
-    invoke_cv_.notify_one();
-  });
+    return true;
+  }
 
-  // Wait for task to complete
-  std::unique_lock<std::mutex> lock(invoke_mutex_);
-  invoke_cv_.wait(lock, [&]() { return done.load(); });
+  // Counts down once the task has run, or is destroyed without running.
+  CountDownLatch done(1);
+  bool ran = false;
+  PendingTask pending{
+      .task = [&task, &ran, done = ScopedCountDown(&done)]() {
+        task();
+        ran = true;
+      },
+      .location = location};
+  if (!Post(std::move(pending), 0)) {
+    return false;
+  }
+  done.Wait();
+  return ran;
 }
 
 Socket* SocketThread::CreateSocket(int32_t family, int32_t type) {
@@ -112,14 +329,13 @@ Socket* SocketThread::CreateSocket(int32_t family, int32_t type) {
 }
 
 void SocketThread::Run() {
-  thread_id_ = std::this_thread::get_id();
   g_current_thread = this;
   running_ = true;
 
   AVE_LOG(LS_INFO) << "SocketThread running";
 
   while (running_) {
-    ProcessMessages(100);
+    ProcessMessages(SocketServer::kForever);
   }
 
   g_current_thread = nullptr;
@@ -130,19 +346,22 @@ bool SocketThread::ProcessMessages(int32_t wait_ms) {
   if (!running_) {
     return false;
   }
+  // Socket callbacks run on this thread too.
+  CurrentTaskRunnerSetter set_current(this);
 
   // Process pending tasks first
   ProcessTasks();
 
-  // Calculate actual wait time based on delayed tasks
-  int64_t next_delay = GetNextDelayMs();
-  int32_t actual_wait = wait_ms;
-  if (next_delay >= 0 && next_delay < wait_ms) {
-    actual_wait = static_cast<int32_t>(next_delay);
+  // Sleep until the next delayed task is due at the latest
+  int64_t wait_us = GetNextDelayUs();
+  if (wait_ms != SocketServer::kForever &&
+      (wait_us == SocketServer::kForever ||
+       wait_us > static_cast<int64_t>(wait_ms) * 1000)) {
+    wait_us = static_cast<int64_t>(wait_ms) * 1000;
   }
 
   // Wait for network events or wakeup
-  socket_server_->Wait(actual_wait);
+  socket_server_->WaitUs(wait_us);
 
   // Process tasks again (might have been woken up by new task)
   ProcessTasks();
@@ -152,7 +371,8 @@ bool SocketThread::ProcessMessages(int32_t wait_ms) {
 
 std::unique_ptr<SocketThread> SocketThread::WrapCurrent() {
   auto thread = std::make_unique<SocketThread>();
-  thread->thread_id_ = std::this_thread::get_id();
+  thread->wrapped_current_ =
+      std::make_unique<CurrentTaskRunnerSetter>(thread.get());
   thread->owned_thread_ = false;
   thread->running_ = true;
   g_current_thread = thread.get();
@@ -160,13 +380,12 @@ std::unique_ptr<SocketThread> SocketThread::WrapCurrent() {
 }
 
 void SocketThread::RunInternal() {
-  thread_id_ = std::this_thread::get_id();
   g_current_thread = this;
 
   AVE_LOG(LS_INFO) << "SocketThread started";
 
   while (running_) {
-    ProcessMessages(100);
+    ProcessMessages(SocketServer::kForever);
   }
 
   g_current_thread = nullptr;
@@ -174,55 +393,82 @@ void SocketThread::RunInternal() {
 }
 
 void SocketThread::ProcessTasks() {
-  // Process immediate tasks
-  std::queue<std::function<void()>> tasks_to_run;
+  // Immediate tasks, then the delayed tasks that are due
+  std::deque<PendingTask> tasks_to_run;
+  bool high = false;
+  bool bounded = false;
   {
     std::scoped_lock lock(task_mutex_);
+    MoveDueTasks(NowUs(), &high);
     tasks_to_run.swap(tasks_);
+    bounded = limits_.capacity > 0 || limits_.high_watermark > 0;
+    if (bounded) {
+      picked_up_ = tasks_to_run.size();
+    }
+  }
+  if (high) {
+    limits_.on_high();
   }
 
   while (!tasks_to_run.empty()) {
-    auto& task = tasks_to_run.front();
-    task();
-    tasks_to_run.pop();
+    if (bounded) {
+      StartPickedUpTask();
+    }
+    RunTask(tasks_to_run.front());
+    tasks_to_run.pop_front();
   }
+}
 
-  // Process delayed tasks that are ready
-  int64_t now = CurrentTimeMs();
-  std::vector<std::function<void()>> ready_tasks;
-
+void SocketThread::StartPickedUpTask() {
+  bool low = false;
   {
     std::scoped_lock lock(task_mutex_);
-    while (!delayed_tasks_.empty() && delayed_tasks_.top().run_time_ms <= now) {
-      // TODO(youfa): remove const_cast by changing the priority_queue to hold
-      // non-const DelayedTask
-      // NOLINTBEGIN(cppcoreguidelines-pro-type-const-cast)
-      ready_tasks.push_back(
-          std::move(const_cast<DelayedTask&>(delayed_tasks_.top()).task));
-      // NOLINTEND(cppcoreguidelines-pro-type-const-cast)
-      delayed_tasks_.pop();
+    --picked_up_;
+    if (blocked_posters_ > 0) {
+      space_cv_.notify_all();
     }
+    if (above_high_ && Depth() <= limits_.low_watermark) {
+      above_high_ = false;
+      low = static_cast<bool>(limits_.on_low);
+    }
+  }
+  if (low) {
+    limits_.on_low();
   }
+}
 
-  for (auto& task : ready_tasks) {
-    task();
+void SocketThread::RunTask(PendingTask& task) {
+  if (task.deadline_us > 0 && NowUs() > task.deadline_us) {
+    stats_.OnLate();
+    if (task.on_late) {
+      std::move(*task.on_late).Run();
+    }
+    return;
   }
+
+  watchdog_->OnTaskStart(task.location);
+#if defined(AVE_TASK_RUNNER_STATS)
+  uint64_t start_us = NowUs();
+  std::move(task.task).Run();
+  stats_.OnRun(task.ready_us, start_us, NowUs());
+#else
+  std::move(task.task).Run();
+#endif
+  watchdog_->OnTaskEnd();
 }
 
-int64_t SocketThread::GetNextDelayMs() {
+int64_t SocketThread::GetNextDelayUs() {
   std::scoped_lock lock(task_mutex_);
   if (delayed_tasks_.empty()) {
-    return -1;
+    return SocketServer::kForever;
   }
-  int64_t delay = delayed_tasks_.top().run_time_ms - CurrentTimeMs();
-  return delay > 0 ? delay : 0;
-}
-
-int64_t SocketThread::CurrentTimeMs() {
-  auto now = std::chrono::steady_clock::now();
-  return std::chrono::duration_cast<std::chrono::milliseconds>(
-             now.time_since_epoch())
-      .count();
+  uint64_t now = NowUs();
+  uint64_t due = delayed_tasks_.top().run_time_us;
+  if (due <= now) {
+    return 0;
+  }
+  return static_cast<int64_t>(std::min<uint64_t>(
+      due - now, std::numeric_limits<int64_t>::max()));
 }
 
 }  // namespace net
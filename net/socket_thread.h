@@ -10,6 +10,8 @@
  * - Wait() handles both network events AND posted tasks
  * - WakeUp() interrupts Wait() when new tasks arrive
  * - Single event loop for everything
+ * - Usable as a TaskRunnerBase, delayed tasks wake the loop to the
+ *   microsecond
  */
 
 #ifndef BASE_NET_SOCKET_THREAD_H
@@ -17,12 +19,20 @@
 
 #include <atomic>
 #include <condition_variable>
+#include <deque>
 #include <functional>
 #include <memory>
 #include <mutex>
 #include <queue>
+#include <source_location>
 #include <thread>
+#include <vector>
 
+#include "base/task_util/inline_task.h"
+#include "base/task_util/task.h"
+#include "base/task_util/task_runner_base.h"
+#include "base/task_util/task_runner_stats.h"
+#include "base/task_util/task_watchdog.h"
 #include "socket_server.h"
 
 namespace ave {
@@ -46,11 +56,18 @@ namespace net {
 //
 //   thread.Stop();
 //
-class SocketThread {
+// It is a TaskRunnerBase too, so a started thread can be handed to code
+// that posts through TaskRunner:
+//   auto* thread = new SocketThread();
+//   thread->Start();
+//   std::unique_ptr<TaskRunnerBase, TaskRunnerDeleter> owned(thread);
+//   TaskRunner runner(std::move(owned));
+//
+class SocketThread : public TaskRunnerBase {
  public:
   SocketThread();
   explicit SocketThread(std::unique_ptr<SocketServer> socket_server);
-  ~SocketThread();
+  ~SocketThread() override;
 
   // Disallow copy
   SocketThread(const SocketThread&) = delete;
@@ -59,21 +76,59 @@ class SocketThread {
   // Start the thread
   void Start();
 
-  // Stop the thread and wait for it to exit
+  // Stop the thread and wait for it to exit. Tasks still queued are
+  // destroyed without running, later posts are refused until Start().
   void Stop();
 
-  // Returns true if called from this thread
-  bool IsCurrent() const;
-
-  // Post a task to be executed on this thread
-  void PostTask(std::function<void()> task);
-
-  // Post a delayed task (approximate, depends on Wait timeout)
-  void PostDelayedTask(std::function<void()> task, int64_t delay_ms);
-
-  // Execute a task synchronously on this thread (blocks caller)
-  // WARNING: Do not call from the same thread (deadlock!)
-  void Invoke(std::function<void()> task);
+  // Post a task to be executed on this thread. `location` is reported by
+  // TaskWatchdog if the task runs too long. Returns false if the task was
+  // refused, see SetQueueLimits().
+  bool PostTask(
+      std::function<void()> task,
+      std::source_location location = std::source_location::current());
+
+  // Like PostTask(), but the task may be dropped for a newer one under
+  // QueueFullPolicy::kDropOldest.
+  bool PostDroppableTask(
+      std::function<void()> task,
+      std::source_location location = std::source_location::current());
+
+  // Post several tasks at once, they run in order. Takes the queue lock and
+  // wakes the thread once for the whole batch. Each task is subject to the
+  // queue limits on its own, returns how many were accepted.
+  size_t PostTasks(
+      std::vector<std::function<void()>> tasks,
+      std::source_location location = std::source_location::current());
+
+  // Post a delayed task, `delay_ms` after now.
+  void PostDelayedTask(
+      std::function<void()> task,
+      int64_t delay_ms,
+      std::source_location location = std::source_location::current());
+
+  // Execute a task synchronously on this thread (blocks caller), runs it
+  // right away if called from this thread. Returns false if the task was
+  // refused or dropped without running.
+  bool Invoke(std::function<void()> task,
+              std::source_location location = std::source_location::current());
+
+  // TaskRunnerBase implementation. Delays are in microseconds here, lanes
+  // are not supported and every task joins the one FIFO. Destruct() stops
+  // and deletes the thread, it must not be called from one of its tasks.
+  void Destruct() override;
+  void PostTask(std::unique_ptr<Task> task) override;
+  void PostDelayedTask(std::unique_ptr<Task> task, uint64_t delay_us) override;
+  void PostDelayedTaskAndWait(std::unique_ptr<Task> task,
+                              uint64_t delay_us,
+                              bool wait) override;
+  void PostInlineTask(InlineTask task, uint64_t delay_us) override;
+  bool PostTaskWithOptions(InlineTask task, PostOptions options) override;
+  TaskRunnerStats GetStats() const override;
+
+  // Bounds the tasks posted but not yet started by the thread, delayed
+  // tasks count once they are due, see TaskQueueLimits. Call before other
+  // threads post.
+  void SetQueueLimits(TaskQueueLimits limits) override;
 
   // Get the socket server (only use from this thread!)
   SocketServer* socket_server() { return socket_server_.get(); }
@@ -87,43 +142,92 @@ class SocketThread {
   // create a SocketThread for the current thread and call Run()
   void Run();
 
-  // Process one iteration of the event loop
-  // Returns false if Stop() was called
+  // Process one iteration of the event loop, waiting at most `wait_ms`
+  // (SocketServer::kForever for no limit) or until the next delayed task
+  // is due. Returns false if Stop() was called
   bool ProcessMessages(int32_t wait_ms);
 
-  // Wrap current thread (makes current thread a SocketThread)
+  // Wrap current thread (makes current thread a SocketThread). The thread
+  // stays Current() until the SocketThread is destroyed, which must happen
+  // on the same thread.
   static std::unique_ptr<SocketThread> WrapCurrent();
 
  private:
+  struct PendingTask {
+    InlineTask task;
+    std::source_location location;
+    bool droppable = false;
+    // Dropped instead of run once this has passed, 0 for none.
+    uint64_t deadline_us = 0;
+    std::unique_ptr<InlineTask> on_late;
+    uint64_t ready_us = 0;
+  };
+
   struct DelayedTask {
-    std::function<void()> task;
-    int64_t run_time_ms;
+    PendingTask pending;
+    uint64_t run_time_us;
+    // Keeps tasks due at the same time in post order.
+    uint64_t order;
 
     bool operator>(const DelayedTask& other) const {
-      return run_time_ms > other.run_time_ms;
+      if (run_time_us != other.run_time_us) {
+        return run_time_us > other.run_time_us;
+      }
+      return order > other.order;
     }
   };
 
+  // Queues `task` now or in `delay_us`. Returns false if it was refused.
+  bool Post(PendingTask task, uint64_t delay_us, uint64_t slack_us = 0);
   void RunInternal();
   void ProcessTasks();
-  int64_t GetNextDelayMs();
-
-  static int64_t CurrentTimeMs();
+  void RunTask(PendingTask& task);
+  // Queues `task` under `limits_`, with `lock` held on `task_mutex_`. Sets
+  // `high` if the high watermark was just reached. The task if refused, or
+  // the one dropped for it, is moved to `dropped`, for the caller to destroy
+  // once the lock is released.
+  bool Enqueue(std::unique_lock<std::mutex>& lock,
+               PendingTask task,
+               bool* high,
+               std::vector<PendingTask>* dropped);
+  // Moves the delayed tasks due by `now_us` to `tasks_`, with `task_mutex_`
+  // held. They count against `limits_` but are never refused.
+  void MoveDueTasks(uint64_t now_us, bool* high);
+  // Sets `high` if the depth just reached the high watermark.
+  void CheckHighWatermark(bool* high);
+  // Tasks counted against `limits_`, with `task_mutex_` held.
+  size_t Depth() const { return tasks_.size() + picked_up_; }
+  // Uncounts the next task of a bounded batch before it runs.
+  void StartPickedUpTask();
+  // Microseconds until the next delayed task, SocketServer::kForever if
+  // there is none.
+  int64_t GetNextDelayUs();
 
   std::unique_ptr<SocketServer> socket_server_;
   std::thread thread_;
-  std::thread::id thread_id_;
+  // Set by WrapCurrent().
+  std::unique_ptr<CurrentTaskRunnerSetter> wrapped_current_;
   std::atomic<bool> running_;
   bool owned_thread_;  // true if we created the thread
 
   std::mutex task_mutex_;
-  std::queue<std::function<void()>> tasks_;
+  std::deque<PendingTask> tasks_;
   std::priority_queue<DelayedTask, std::vector<DelayedTask>, std::greater<>>
       delayed_tasks_;
-
-  // For Invoke() synchronization
-  std::mutex invoke_mutex_;
-  std::condition_variable invoke_cv_;
+  uint64_t delayed_order_ = 0;
+  const std::shared_ptr<TaskWatchdogSlot> watchdog_;
+  TaskRunnerStatsRecorder stats_;
+
+  // Guarded by `task_mutex_`.
+  // Set by Stop(), posts are refused then.
+  bool stopped_ = false;
+  TaskQueueLimits limits_;
+  // Taken from `tasks_` by ProcessTasks() but not started yet, only counted
+  // while the thread is bounded.
+  size_t picked_up_ = 0;
+  bool above_high_ = false;
+  int blocked_posters_ = 0;
+  std::condition_variable space_cv_;
 };
 
 // Get the current thread's SocketThread (if any)
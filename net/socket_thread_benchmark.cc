@@ -0,0 +1,71 @@
+/*
+ * socket_thread_benchmark.cc
+ * Copyright (C) 2026 youfa <vsyfar@gmail.com>
+ *
+ * Distributed under terms of the GPLv2 license.
+ */
+
+#include <atomic>
+#include <cstdint>
+
+#include "base/net/socket_thread.h"
+#include "benchmark/benchmark.h"
+
+namespace ave {
+namespace base {
+namespace net {
+namespace {
+
+// Posts `state.range(0)` small tasks to an idle thread, so most posts have
+// to wake it out of epoll_wait().
+void BM_PostTaskToIdleSocketThread(benchmark::State& state) {
+  SocketThread thread;
+  thread.Start();
+  const int64_t count = state.range(0);
+  std::atomic<int64_t> done{0};
+
+  for (auto _ : state) {
+    for (int64_t i = 0; i < count; ++i) {
+      thread.PostTask([&done]() { done.fetch_add(1); });
+    }
+    thread.Invoke([]() {});
+  }
+  state.SetItemsProcessed(state.iterations() * count);
+  thread.Stop();
+}
+
+// Posts `state.range(0)` small tasks while the thread is still running a
+// task that waits for the last of them to be posted. Only the first post
+// after each loop iteration has to write the wakeup eventfd.
+void BM_PostTaskToBusySocketThread(benchmark::State& state) {
+  SocketThread thread;
+  thread.Start();
+  const int64_t count = state.range(0);
+  std::atomic<int64_t> done{0};
+  std::atomic<bool> posted{false};
+
+  for (auto _ : state) {
+    posted.store(false, std::memory_order_relaxed);
+    thread.PostTask([&posted]() {
+      while (!posted.load(std::memory_order_acquire)) {
+      }
+    });
+    for (int64_t i = 0; i < count; ++i) {
+      thread.PostTask([&done]() { done.fetch_add(1); });
+    }
+    posted.store(true, std::memory_order_release);
+    thread.Invoke([]() {});
+  }
+  state.SetItemsProcessed(state.iterations() * count);
+  thread.Stop();
+}
+
+BENCHMARK(BM_PostTaskToIdleSocketThread)->Arg(1)->Arg(64)->Arg(1024);
+BENCHMARK(BM_PostTaskToBusySocketThread)->Arg(1)->Arg(64)->Arg(1024);
+
+}  // namespace
+}  // namespace net
+}  // namespace base
+}  // namespace ave
+
+BENCHMARK_MAIN();
@@ -9,10 +9,16 @@
 
 #include <atomic>
 #include <chrono>
+#include <functional>
+#include <future>
+#include <memory>
 #include <thread>
+#include <vector>
 
 #include <gtest/gtest.h>
 
+#include "base/task_util/task_runner.h"
+
 namespace ave {
 namespace base {
 namespace net {
@@ -37,6 +43,25 @@ TEST(SocketThreadTest, PostTask) {
   thread.Stop();
 }
 
+TEST(SocketThreadTest, PostTasks) {
+  SocketThread thread;
+  thread.Start();
+
+  std::vector<int> order;
+  std::vector<std::function<void()>> tasks;
+  for (int i = 0; i < 10; ++i) {
+    tasks.emplace_back([&order, i]() { order.push_back(i); });
+  }
+  EXPECT_EQ(thread.PostTasks(std::move(tasks)), 10u);
+  thread.Invoke([]() {});
+
+  ASSERT_EQ(order.size(), 10u);
+  for (int i = 0; i < 10; ++i) {
+    EXPECT_EQ(order[i], i);
+  }
+  thread.Stop();
+}
+
 TEST(SocketThreadTest, PostDelayedTask) {
   SocketThread thread;
   thread.Start();
@@ -75,6 +100,166 @@ TEST(SocketThreadTest, Invoke) {
   thread.Stop();
 }
 
+TEST(SocketThreadTest, InvokeFailsWhenRefused) {
+  SocketThread thread;
+  thread.SetQueueLimits(
+      {.capacity = 1, .policy = QueueFullPolicy::kReject});
+  // Not started yet, so the queue stays full.
+  EXPECT_TRUE(thread.PostTask([]() {}));
+  bool ran = false;
+  EXPECT_FALSE(thread.Invoke([&ran]() { ran = true; }));
+
+  thread.Start();
+  thread.Stop();
+  EXPECT_FALSE(thread.Invoke([&ran]() { ran = true; }));
+  EXPECT_FALSE(ran);
+}
+
+TEST(SocketThreadTest, ConcurrentInvokes) {
+  SocketThread thread;
+  thread.Start();
+
+  std::atomic<int> count{0};
+  std::vector<std::thread> invokers;
+  for (int i = 0; i < 4; ++i) {
+    invokers.emplace_back([&thread, &count]() {
+      for (int j = 0; j < 200; ++j) {
+        EXPECT_TRUE(thread.Invoke([&count]() { ++count; }));
+      }
+    });
+  }
+  for (std::thread& invoker : invokers) {
+    invoker.join();
+  }
+  EXPECT_EQ(count.load(), 800);
+  thread.Stop();
+}
+
+TEST(SocketThreadTest, UsableAsTaskRunner) {
+  auto* thread = new SocketThread();
+  thread->Start();
+  std::unique_ptr<TaskRunnerBase, TaskRunnerDeleter> owned(thread);
+  TaskRunner runner(std::move(owned));
+
+  bool current = false;
+  runner.PostTaskAndWait([&current, thread]() {
+    current = TaskRunnerBase::Current() == thread && thread->IsCurrent();
+  });
+  EXPECT_TRUE(current);
+
+  // Timers wake the loop when due, not on a polling tick.
+  std::promise<std::chrono::steady_clock::time_point> ran;
+  auto posted = std::chrono::steady_clock::now();
+  runner.PostDelayedTask(
+      [&ran]() { ran.set_value(std::chrono::steady_clock::now()); }, 2000);
+  auto elapsed = ran.get_future().get() - posted;
+  EXPECT_GE(elapsed, std::chrono::microseconds(2000));
+  EXPECT_LT(elapsed, std::chrono::milliseconds(50));
+}
+
+TEST(SocketThreadTest, QueueLimits) {
+  SocketThread thread;
+  int high = 0;
+  thread.SetQueueLimits({.capacity = 2,
+                         .policy = QueueFullPolicy::kDropOldest,
+                         .high_watermark = 2,
+                         .on_high = [&high]() { ++high; }});
+
+  // Queued before Start(), so nothing runs until the checks are done.
+  std::vector<int> order;
+  EXPECT_TRUE(thread.PostDroppableTask([&order]() { order.push_back(1); }));
+  EXPECT_TRUE(thread.PostTask([&order]() { order.push_back(2); }));
+  EXPECT_EQ(high, 1);
+  std::promise<void> done;
+  EXPECT_TRUE(thread.PostTask([&order, &done]() {
+    order.push_back(3);
+    done.set_value();
+  }));
+  EXPECT_FALSE(thread.PostTask([&order]() { order.push_back(4); }));
+
+  thread.Start();
+  done.get_future().wait();
+  EXPECT_EQ(order, std::vector<int>({2, 3}));
+  thread.Stop();
+}
+
+TEST(SocketThreadTest, DelayedTasksCountOnceDue) {
+  SocketThread thread;
+  int high = 0;
+  thread.SetQueueLimits(
+      {.high_watermark = 2, .on_high = [&high]() { ++high; }});
+  thread.Start();
+
+  // Both fall due while the thread is busy and are queued together.
+  std::promise<void> done;
+  thread.Invoke([&thread, &done]() {
+    thread.PostDelayedTask([]() {}, 1);
+    thread.PostDelayedTask([&done]() { done.set_value(); }, 1);
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+  });
+  done.get_future().wait();
+  EXPECT_EQ(high, 1);
+  thread.Stop();
+}
+
+TEST(SocketThreadTest, RunningBatchCountsTowardsCapacity) {
+  SocketThread thread;
+  thread.SetQueueLimits(
+      {.capacity = 2, .policy = QueueFullPolicy::kReject});
+
+  // Picked up in one batch, the second task waits behind the first.
+  std::promise<void> started;
+  std::promise<void> release;
+  std::shared_future<void> released = release.get_future().share();
+  EXPECT_TRUE(thread.PostTask([&started, released]() {
+    started.set_value();
+    released.wait();
+  }));
+  EXPECT_TRUE(thread.PostTask([]() {}));
+  thread.Start();
+  started.get_future().wait();
+
+  // The second task is out of `tasks_` but not started, it still counts.
+  EXPECT_TRUE(thread.PostTask([]() {}));
+  EXPECT_FALSE(thread.PostTask([]() {}));
+  release.set_value();
+  thread.Stop();
+}
+
+TEST(SocketThreadTest, PostTasksCountsAccepted) {
+  SocketThread thread;
+  thread.SetQueueLimits(
+      {.capacity = 3, .policy = QueueFullPolicy::kReject});
+
+  // Not started yet, so only the first three fit.
+  std::vector<std::function<void()>> tasks(5, []() {});
+  EXPECT_EQ(thread.PostTasks(std::move(tasks)), 3u);
+
+  thread.Start();
+  thread.Stop();
+  EXPECT_EQ(thread.PostTasks({[]() {}}), 0u);
+}
+
+TEST(SocketThreadTest, DroppedTaskMayPostFromItsDestructor) {
+  SocketThread thread;
+  thread.SetQueueLimits(
+      {.capacity = 1, .policy = QueueFullPolicy::kDropOldest});
+
+  struct PostsOnDestruction {
+    ~PostsOnDestruction() { posted = thread->PostTask([]() {}); }
+    SocketThread* thread;
+    bool& posted;
+  };
+  bool posted = true;
+  auto guard = std::make_shared<PostsOnDestruction>(&thread, posted);
+  EXPECT_TRUE(thread.PostDroppableTask([guard]() {}));
+  guard.reset();
+
+  // Drops the first task, whose destructor posts to the still full queue.
+  EXPECT_TRUE(thread.PostTask([]() {}));
+  EXPECT_FALSE(posted);
+}
+
 }  // namespace
 }  // namespace net
 }  // namespace base
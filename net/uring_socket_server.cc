@@ -0,0 +1,1009 @@
+/*
+ * uring_socket_server.cc
+ * Copyright (C) 2026 youfa <vsyfar@gmail.com>
+ *
+ * Distributed under terms of the GPLv2 license.
+ */
+
+#include "base/net/uring_socket_server.h"
+
+#include <linux/io_uring.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <deque>
+#include <utility>
+
+#include "base/logging.h"
+#include "base/net/dispatcher.h"
+#include "base/net/physical_socket.h"
+#include "base/net/physical_socket_server.h"
+
+namespace ave {
+namespace base {
+namespace net {
+
+namespace {
+
+constexpr unsigned kRingEntries = 256;
+constexpr uint16_t kBufferGroup = 0;
+// Power of two. Buffers take the largest datagram, pages are only touched
+// as far as data fills them.
+constexpr uint16_t kBufferCount = 64;
+constexpr uint32_t kBufferSize = 64 * 1024;
+
+// The low bits of a request's user_data, the rest is the id of the socket
+// or dispatcher it belongs to. Id 0 is the server itself.
+enum Op : uint64_t {
+  kOpWakeup,
+  kOpRecv,
+  kOpAccept,
+  kOpPollOut,
+  kOpPoll,
+  kOpCancel,
+};
+constexpr int kOpBits = 3;
+
+uint64_t UserData(uint64_t id, Op op) {
+  return id << kOpBits | op;
+}
+
+template <typename T>
+T LoadAcquire(T* p) {
+  return std::atomic_ref<T>(*p).load(std::memory_order_acquire);
+}
+
+template <typename T>
+void StoreRelease(T* p, T value) {
+  std::atomic_ref<T>(*p).store(value, std::memory_order_release);
+}
+
+uint32_t DispatcherEventsToPollEvents(uint32_t dispatcher_events) {
+  uint32_t poll_events = 0;
+  if (dispatcher_events & DE_READ) {
+    poll_events |= POLLIN;
+  }
+  if (dispatcher_events & (DE_WRITE | DE_CONNECT)) {
+    poll_events |= POLLOUT;
+  }
+  return poll_events;
+}
+
+uint32_t PollEventsToDispatcherEvents(uint32_t poll_events) {
+  uint32_t dispatcher_events = 0;
+  if (poll_events & POLLIN) {
+    dispatcher_events |= DE_READ;
+  }
+  if (poll_events & POLLOUT) {
+    dispatcher_events |= DE_WRITE | DE_CONNECT;
+  }
+  if (poll_events & (POLLERR | POLLHUP)) {
+    dispatcher_events |= DE_CLOSE;
+  }
+  return dispatcher_events;
+}
+
+}  // namespace
+
+// The rings of one io_uring instance plus one provided buffer ring, over the
+// raw system calls.
+class UringRing {
+ public:
+  UringRing() = default;
+  ~UringRing();
+
+  UringRing(const UringRing&) = delete;
+  UringRing& operator=(const UringRing&) = delete;
+
+  bool Init(unsigned entries);
+  bool InitBuffers(uint16_t count, uint32_t size);
+
+  // Returns a zeroed SQE, submitting queued ones first if the ring is full.
+  // nullptr if even that fails.
+  io_uring_sqe* GetSqe();
+
+  // Submits queued SQEs and posts completions. If `wait` is set, also waits
+  // up to `timeout_us` (negative: no limit) for one. The first call enables
+  // the ring and makes its thread the only one allowed to submit. Returns
+  // -errno on failure.
+  int32_t Submit(bool wait, int64_t timeout_us);
+
+  // Calls `fn` for each available CQE.
+  template <typename Fn>
+  void ForEachCqe(Fn fn) {
+    unsigned head = *cq_head_;
+    unsigned tail = LoadAcquire(cq_tail_);
+    for (; head != tail; ++head) {
+      fn(cqes_[head & cq_mask_]);
+    }
+    StoreRelease(cq_head_, head);
+  }
+
+  uint8_t* Buffer(uint16_t bid) const {
+    return buffers_ + static_cast<size_t>(bid) * buffer_size_;
+  }
+  void RecycleBuffer(uint16_t bid);
+
+ private:
+  void AddBuffer(uint16_t bid);
+
+  int32_t fd_ = -1;
+  bool enabled_ = false;
+  void* sq_ring_ = nullptr;
+  size_t sq_ring_size_ = 0;
+  void* cq_ring_ = nullptr;
+  size_t cq_ring_size_ = 0;
+  io_uring_sqe* sqes_ = nullptr;
+  size_t sqes_size_ = 0;
+
+  unsigned* sq_head_ = nullptr;
+  unsigned* sq_tail_ = nullptr;
+  unsigned sq_mask_ = 0;
+  unsigned sq_entries_ = 0;
+  // SQEs handed out, published to `sq_tail_` on Submit().
+  unsigned sq_local_tail_ = 0;
+  unsigned* cq_head_ = nullptr;
+  unsigned* cq_tail_ = nullptr;
+  unsigned cq_mask_ = 0;
+  io_uring_cqe* cqes_ = nullptr;
+
+  io_uring_buf_ring* buffer_ring_ = nullptr;
+  size_t buffer_ring_size_ = 0;
+  uint8_t* buffers_ = nullptr;
+  uint16_t buffer_count_ = 0;
+  uint32_t buffer_size_ = 0;
+  uint16_t buffer_tail_ = 0;
+};
+
+UringRing::~UringRing() {
+  if (fd_ >= 0) {
+    ::close(fd_);
+  }
+  if (sqes_) {
+    ::munmap(sqes_, sqes_size_);
+  }
+  if (cq_ring_ && cq_ring_ != sq_ring_) {
+    ::munmap(cq_ring_, cq_ring_size_);
+  }
+  if (sq_ring_) {
+    ::munmap(sq_ring_, sq_ring_size_);
+  }
+  if (buffer_ring_) {
+    ::munmap(buffer_ring_, buffer_ring_size_);
+  }
+  if (buffers_) {
+    ::munmap(buffers_, static_cast<size_t>(buffer_count_) * buffer_size_);
+  }
+}
+
+bool UringRing::Init(unsigned entries) {
+  io_uring_params params{};
+  // Completion work runs when Submit() asks for it, not as an interrupt of
+  // whatever the thread is doing. The ring stays disabled until the thread
+  // running the loop first submits.
+  params.flags = IORING_SETUP_CQSIZE | IORING_SETUP_SINGLE_ISSUER |
+                 IORING_SETUP_DEFER_TASKRUN | IORING_SETUP_R_DISABLED;
+  // Multishot requests complete many times per submission.
+  params.cq_entries = entries * 4;
+  fd_ = static_cast<int32_t>(::syscall(__NR_io_uring_setup, entries, &params));
+  if (fd_ < 0) {
+    return false;
+  }
+  if (!(params.features & IORING_FEAT_EXT_ARG) ||
+      !(params.features & IORING_FEAT_NODROP)) {
+    return false;
+  }
+
+  sq_ring_size_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+  cq_ring_size_ = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+  bool single_mmap = params.features & IORING_FEAT_SINGLE_MMAP;
+  if (single_mmap) {
+    sq_ring_size_ = cq_ring_size_ = std::max(sq_ring_size_, cq_ring_size_);
+  }
+  sq_ring_ = ::mmap(nullptr, sq_ring_size_, PROT_READ | PROT_WRITE,
+                    MAP_SHARED | MAP_POPULATE, fd_, IORING_OFF_SQ_RING);
+  if (sq_ring_ == MAP_FAILED) {
+    sq_ring_ = nullptr;
+    return false;
+  }
+  cq_ring_ = sq_ring_;
+  if (!single_mmap) {
+    cq_ring_ = ::mmap(nullptr, cq_ring_size_, PROT_READ | PROT_WRITE,
+                      MAP_SHARED | MAP_POPULATE, fd_, IORING_OFF_CQ_RING);
+    if (cq_ring_ == MAP_FAILED) {
+      cq_ring_ = nullptr;
+      return false;
+    }
+  }
+  sqes_size_ = params.sq_entries * sizeof(io_uring_sqe);
+  void* sqes = ::mmap(nullptr, sqes_size_, PROT_READ | PROT_WRITE,
+                      MAP_SHARED | MAP_POPULATE, fd_, IORING_OFF_SQES);
+  if (sqes == MAP_FAILED) {
+    return false;
+  }
+  sqes_ = static_cast<io_uring_sqe*>(sqes);
+
+  auto* sq = static_cast<uint8_t*>(sq_ring_);
+  sq_head_ = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+  sq_tail_ = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+  sq_mask_ = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+  sq_entries_ = params.sq_entries;
+  auto* sq_array = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+  for (unsigned i = 0; i < sq_entries_; ++i) {
+    sq_array[i] = i;
+  }
+  sq_local_tail_ = *sq_tail_;
+
+  auto* cq = static_cast<uint8_t*>(cq_ring_);
+  cq_head_ = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+  cq_tail_ = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+  cq_mask_ = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+  cqes_ = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+  return true;
+}
+
+bool UringRing::InitBuffers(uint16_t count, uint32_t size) {
+  buffer_ring_size_ = count * sizeof(io_uring_buf);
+  void* ring = ::mmap(nullptr, buffer_ring_size_, PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (ring == MAP_FAILED) {
+    return false;
+  }
+  buffer_ring_ = static_cast<io_uring_buf_ring*>(ring);
+  void* buffers = ::mmap(nullptr, static_cast<size_t>(count) * size,
+                         PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS,
+                         -1, 0);
+  if (buffers == MAP_FAILED) {
+    return false;
+  }
+  buffers_ = static_cast<uint8_t*>(buffers);
+  buffer_count_ = count;
+  buffer_size_ = size;
+
+  io_uring_buf_reg reg{};
+  reg.ring_addr = reinterpret_cast<uint64_t>(buffer_ring_);
+  reg.ring_entries = count;
+  reg.bgid = kBufferGroup;
+  if (::syscall(__NR_io_uring_register, fd_, IORING_REGISTER_PBUF_RING, &reg,
+                1) < 0) {
+    return false;
+  }
+  for (uint16_t bid = 0; bid < count; ++bid) {
+    AddBuffer(bid);
+  }
+  StoreRelease(&buffer_ring_->tail, buffer_tail_);
+  return true;
+}
+
+void UringRing::AddBuffer(uint16_t bid) {
+  // Not through `bufs`, in C++ the flexible array macro of the uapi header
+  // moves it off offset 0.
+  io_uring_buf& buf = reinterpret_cast<io_uring_buf*>(
+      buffer_ring_)[buffer_tail_ & (buffer_count_ - 1)];
+  buf.addr = reinterpret_cast<uint64_t>(Buffer(bid));
+  buf.len = buffer_size_;
+  buf.bid = bid;
+  ++buffer_tail_;
+}
+
+void UringRing::RecycleBuffer(uint16_t bid) {
+  AddBuffer(bid);
+  StoreRelease(&buffer_ring_->tail, buffer_tail_);
+}
+
+io_uring_sqe* UringRing::GetSqe() {
+  if (sq_local_tail_ - LoadAcquire(sq_head_) >= sq_entries_) {
+    if (!enabled_) {
+      return nullptr;
+    }
+    Submit(false, 0);
+    if (sq_local_tail_ - LoadAcquire(sq_head_) >= sq_entries_) {
+      return nullptr;
+    }
+  }
+  io_uring_sqe* sqe = &sqes_[sq_local_tail_ & sq_mask_];
+  ++sq_local_tail_;
+  memset(sqe, 0, sizeof(*sqe));
+  return sqe;
+}
+
+int32_t UringRing::Submit(bool wait, int64_t timeout_us) {
+  if (!enabled_) {
+    if (::syscall(__NR_io_uring_register, fd_, IORING_REGISTER_ENABLE_RINGS,
+                  nullptr, 0) < 0) {
+      return -errno;
+    }
+    enabled_ = true;
+  }
+  StoreRelease(sq_tail_, sq_local_tail_);
+  unsigned to_submit = sq_local_tail_ - LoadAcquire(sq_head_);
+
+  // Even without waiting, GETEVENTS runs the deferred completion work.
+  io_uring_getevents_arg arg{};
+  __kernel_timespec ts{};
+  arg.sigmask_sz = _NSIG / 8;
+  if (wait && timeout_us >= 0) {
+    ts.tv_sec = timeout_us / 1000000;
+    ts.tv_nsec = (timeout_us % 1000000) * 1000;
+    arg.ts = reinterpret_cast<uint64_t>(&ts);
+  }
+  long ret = ::syscall(__NR_io_uring_enter, fd_, to_submit, wait ? 1 : 0,
+                       IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG, &arg,
+                       sizeof(arg));
+  return ret < 0 ? -errno : static_cast<int32_t>(ret);
+}
+
+// A PhysicalSocket whose reads complete through the server's ring.
+class UringSocket : public PhysicalSocket {
+ public:
+  UringSocket(UringSocketServer* server, int32_t family, int32_t type)
+      : PhysicalSocket(nullptr, family, type),
+        server_(server),
+        id_(server->Register(this)) {}
+
+  // An accepted, connected socket.
+  UringSocket(UringSocketServer* server,
+              int32_t socket_fd,
+              int32_t family,
+              int32_t type)
+      : PhysicalSocket(nullptr, socket_fd, family, type),
+        server_(server),
+        id_(server->Register(this)) {
+    ArmRecv();
+  }
+
+  ~UringSocket() override {
+    Close();
+    server_->Unregister(id_);
+  }
+
+  int32_t Bind(const SocketAddress& addr) override {
+    if (PhysicalSocket::Bind(addr) < 0) {
+      return -1;
+    }
+    if (type_ == SOCK_DGRAM) {
+      ArmRecv();
+    }
+    return 0;
+  }
+
+  int32_t Connect(const SocketAddress& addr) override {
+    if (PhysicalSocket::Connect(addr) < 0) {
+      return -1;
+    }
+    if (type_ == SOCK_DGRAM) {
+      ArmRecv();
+    } else {
+      connecting_ = true;
+      ArmPollOut();
+    }
+    return 0;
+  }
+
+  int32_t Send(const void* pv, size_t cb) override {
+    return AfterSend(PhysicalSocket::Send(pv, cb));
+  }
+
+  int32_t SendTo(const void* pv,
+                 size_t cb,
+                 const SocketAddress& addr) override {
+    return AfterSend(PhysicalSocket::SendTo(pv, cb, addr));
+  }
+
+  int32_t SendV(const iovec* iov, size_t count) override {
+    return AfterSend(PhysicalSocket::SendV(iov, count));
+  }
+
+  int32_t SendToV(const iovec* iov,
+                  size_t count,
+                  const SocketAddress& addr) override {
+    return AfterSend(PhysicalSocket::SendToV(iov, count, addr));
+  }
+
+  int32_t SendToBatch(const OutgoingDatagram* datagrams,
+                      size_t count) override {
+    return AfterSend(PhysicalSocket::SendToBatch(datagrams, count));
+  }
+
+  int32_t Recv(void* pv, size_t cb, int64_t* timestamp) override {
+    if (timestamp) {
+      *timestamp = -1;
+    }
+    return Read(pv, cb, nullptr);
+  }
+
+  int32_t RecvFrom(void* pv,
+                   size_t cb,
+                   SocketAddress* paddr,
+                   int64_t* timestamp) override {
+    if (timestamp) {
+      *timestamp = -1;
+    }
+    return Read(pv, cb, paddr);
+  }
+
+  // Nothing to batch, the data is already here.
+  int32_t RecvFromBatch(ReceivedDatagram* datagrams, size_t count) override {
+    return Socket::RecvFromBatch(datagrams, count);
+  }
+
+  int32_t Listen(int32_t backlog) override {
+    if (PhysicalSocket::Listen(backlog) < 0) {
+      return -1;
+    }
+    ArmAccept();
+    return 0;
+  }
+
+  Socket* Accept(SocketAddress* paddr) override {
+    if (accepted_.empty()) {
+      error_ = EWOULDBLOCK;
+      return nullptr;
+    }
+    int32_t fd = accepted_.front();
+    accepted_.pop_front();
+    auto* socket = new UringSocket(server_, fd, family_, type_);
+    if (paddr) {
+      *paddr = socket->GetRemoteAddress();
+    }
+    if (!accepted_.empty()) {
+      QueueRead();
+    }
+    return socket;
+  }
+
+  int32_t Close() override {
+    if (recv_armed_) {
+      server_->Cancel(UserData(id_, kOpRecv));
+      recv_armed_ = false;
+    }
+    if (accept_armed_) {
+      server_->Cancel(UserData(id_, kOpAccept));
+      accept_armed_ = false;
+    }
+    if (poll_out_armed_) {
+      server_->Cancel(UserData(id_, kOpPollOut));
+      poll_out_armed_ = false;
+    }
+    for (const Chunk& chunk : chunks_) {
+      server_->RecycleBuffer(chunk.bid);
+    }
+    chunks_.clear();
+    for (int32_t fd : accepted_) {
+      ::close(fd);
+    }
+    accepted_.clear();
+    connecting_ = false;
+    eof_ = false;
+    return PhysicalSocket::Close();
+  }
+
+  int32_t SetOption(Option opt, int32_t value) override {
+    if (opt == OPT_UDP_GRO || opt == OPT_ZEROCOPY) {
+      // Segment sizes are not reported through recvmsg multishot here, and
+      // the error queue is not watched.
+      error_ = ENOPROTOOPT;
+      return -1;
+    }
+    return PhysicalSocket::SetOption(opt, value);
+  }
+
+  void ArmRecv() {
+    if (recv_armed_ || socket_fd_ < 0) {
+      return;
+    }
+    io_uring_sqe* sqe = server_->GetSqe();
+    if (!sqe) {
+      server_->MarkStarved(id_);
+      return;
+    }
+    if (type_ == SOCK_DGRAM) {
+      recv_msg_ = {};
+      recv_msg_.msg_namelen = sizeof(sockaddr_in);
+      sqe->opcode = IORING_OP_RECVMSG;
+      sqe->addr = reinterpret_cast<uint64_t>(&recv_msg_);
+      sqe->len = 1;
+    } else {
+      sqe->opcode = IORING_OP_RECV;
+    }
+    sqe->fd = socket_fd_;
+    sqe->ioprio = IORING_RECV_MULTISHOT;
+    sqe->flags = IOSQE_BUFFER_SELECT;
+    sqe->buf_group = kBufferGroup;
+    sqe->user_data = UserData(id_, kOpRecv);
+    recv_armed_ = true;
+  }
+
+  void OnCompletion(Op op, const io_uring_cqe& cqe) {
+    switch (op) {
+      case kOpRecv:
+        OnRecv(cqe);
+        break;
+      case kOpAccept:
+        OnAccept(cqe);
+        break;
+      case kOpPollOut:
+        OnPollOut(cqe);
+        break;
+      default:
+        break;
+    }
+  }
+
+  void Emit(uint32_t events, int32_t error) {
+    read_queued_ = false;
+    if (socket_fd_ < 0) {
+      return;
+    }
+    if (events & DE_CONNECT) {
+      SignalConnectEvent(this);
+    } else if (events & DE_CLOSE) {
+      SignalCloseEvent(this, error);
+    } else if (events & DE_READ) {
+      SignalReadEvent(this);
+    } else if (events & DE_WRITE) {
+      SignalWriteEvent(this);
+    }
+  }
+
+ private:
+  // Received data not read yet, in a provided buffer.
+  struct Chunk {
+    uint16_t bid;
+    uint32_t offset;
+    uint32_t size;
+    SocketAddress addr;
+  };
+
+  int32_t AfterSend(int32_t result) {
+    if (result < 0 && IsBlockingError(error_)) {
+      ArmPollOut();
+    } else if (type_ == SOCK_DGRAM) {
+      // The first send binds an unbound socket.
+      ArmRecv();
+    }
+    return result;
+  }
+
+  int32_t Read(void* pv, size_t cb, SocketAddress* paddr) {
+    if (chunks_.empty()) {
+      if (eof_) {
+        return 0;
+      }
+      error_ = EWOULDBLOCK;
+      return -1;
+    }
+
+    if (paddr) {
+      *paddr = chunks_.front().addr;
+    }
+    auto* out = static_cast<uint8_t*>(pv);
+    size_t copied = 0;
+    while (copied < cb && !chunks_.empty()) {
+      Chunk& chunk = chunks_.front();
+      size_t n = std::min<size_t>(cb - copied, chunk.size);
+      memcpy(out + copied, server_->Buffer(chunk.bid) + chunk.offset, n);
+      copied += n;
+      chunk.offset += n;
+      chunk.size -= n;
+      // A datagram is read whole or truncated.
+      if (chunk.size == 0 || type_ == SOCK_DGRAM) {
+        server_->RecycleBuffer(chunk.bid);
+        chunks_.pop_front();
+        if (type_ == SOCK_DGRAM) {
+          break;
+        }
+      }
+    }
+    if (!chunks_.empty() || eof_) {
+      QueueRead();
+    }
+    return static_cast<int32_t>(copied);
+  }
+
+  void QueueRead() {
+    if (!read_queued_) {
+      read_queued_ = true;
+      server_->QueueEvent(id_, DE_READ, 0);
+    }
+  }
+
+  void OnRecv(const io_uring_cqe& cqe) {
+    bool more = cqe.flags & IORING_CQE_F_MORE;
+    if (!more) {
+      recv_armed_ = false;
+    }
+    if (cqe.flags & IORING_CQE_F_BUFFER) {
+      auto bid = static_cast<uint16_t>(cqe.flags >> IORING_CQE_BUFFER_SHIFT);
+      if (cqe.res > 0 && socket_fd_ >= 0) {
+        AddChunk(bid, static_cast<uint32_t>(cqe.res));
+        QueueRead();
+      } else {
+        server_->RecycleBuffer(bid);
+      }
+    }
+
+    if (cqe.res == 0 && type_ == SOCK_STREAM) {
+      eof_ = true;
+      QueueRead();
+      return;
+    }
+    if (cqe.res < 0) {
+      if (cqe.res == -ENOBUFS) {
+        server_->MarkStarved(id_);
+      } else if (cqe.res != -ECANCELED && socket_fd_ >= 0) {
+        error_ = -cqe.res;
+        server_->QueueEvent(id_, DE_CLOSE, error_);
+      }
+      return;
+    }
+    if (!more) {
+      // Ended by the kernel, e.g. on CQ overflow.
+      ArmRecv();
+    }
+  }
+
+  void AddChunk(uint16_t bid, uint32_t res) {
+    if (type_ != SOCK_DGRAM) {
+      chunks_.push_back({bid, 0, res, SocketAddress()});
+      return;
+    }
+    // io_uring_recvmsg_out, the address and the payload.
+    const uint8_t* buf = server_->Buffer(bid);
+    io_uring_recvmsg_out out{};
+    memcpy(&out, buf, sizeof(out));
+    uint32_t offset = sizeof(out) + recv_msg_.msg_namelen;
+    Chunk chunk{bid, offset, std::min(out.payloadlen, res - offset), {}};
+    if (out.namelen >= sizeof(sockaddr_in)) {
+      sockaddr_in saddr{};
+      memcpy(&saddr, buf + sizeof(out), sizeof(saddr));
+      chunk.addr.FromSockAddr(saddr);
+    }
+    chunks_.push_back(chunk);
+  }
+
+  void ArmAccept() {
+    if (accept_armed_ || socket_fd_ < 0) {
+      return;
+    }
+    io_uring_sqe* sqe = server_->GetSqe();
+    if (!sqe) {
+      return;
+    }
+    sqe->opcode = IORING_OP_ACCEPT;
+    sqe->fd = socket_fd_;
+    sqe->ioprio = IORING_ACCEPT_MULTISHOT;
+    sqe->accept_flags = SOCK_NONBLOCK | SOCK_CLOEXEC;
+    sqe->user_data = UserData(id_, kOpAccept);
+    accept_armed_ = true;
+  }
+
+  void OnAccept(const io_uring_cqe& cqe) {
+    bool more = cqe.flags & IORING_CQE_F_MORE;
+    if (!more) {
+      accept_armed_ = false;
+    }
+    if (cqe.res >= 0) {
+      if (socket_fd_ < 0) {
+        ::close(cqe.res);
+        return;
+      }
+      accepted_.push_back(cqe.res);
+      QueueRead();
+    } else if (cqe.res == -ECANCELED || socket_fd_ < 0) {
+      return;
+    }
+    if (!more) {
+      ArmAccept();
+    }
+  }
+
+  void ArmPollOut() {
+    if (poll_out_armed_ || socket_fd_ < 0) {
+      return;
+    }
+    io_uring_sqe* sqe = server_->GetSqe();
+    if (!sqe) {
+      return;
+    }
+    sqe->opcode = IORING_OP_POLL_ADD;
+    sqe->fd = socket_fd_;
+    sqe->poll32_events = POLLOUT;
+    sqe->user_data = UserData(id_, kOpPollOut);
+    poll_out_armed_ = true;
+  }
+
+  void OnPollOut(const io_uring_cqe& cqe) {
+    poll_out_armed_ = false;
+    if (cqe.res == -ECANCELED || socket_fd_ < 0) {
+      return;
+    }
+    if (!connecting_) {
+      server_->QueueEvent(id_, DE_WRITE, 0);
+      return;
+    }
+    connecting_ = false;
+    OnConnectComplete();
+    if (GetState() == CS_CONNECTED) {
+      ArmRecv();
+      server_->QueueEvent(id_, DE_CONNECT, 0);
+    } else {
+      server_->QueueEvent(id_, DE_CLOSE, GetError());
+    }
+  }
+
+  UringSocketServer* const server_;
+  const uint64_t id_;
+  std::deque<Chunk> chunks_;
+  std::deque<int32_t> accepted_;
+  // Template of the multishot recvmsg, read by the kernel on each receive.
+  msghdr recv_msg_{};
+  bool recv_armed_ = false;
+  bool accept_armed_ = false;
+  bool poll_out_armed_ = false;
+  bool connecting_ = false;
+  // The peer closed, Recv() returns 0 once the chunks are read.
+  bool eof_ = false;
+  bool read_queued_ = false;
+};
+
+// static
+std::unique_ptr<SocketServer> UringSocketServer::Create() {
+  std::unique_ptr<UringSocketServer> server(new UringSocketServer());
+  if (server->Init()) {
+    return server;
+  }
+  AVE_LOG(LS_INFO) << "io_uring unavailable, falling back to epoll";
+  return std::make_unique<PhysicalSocketServer>();
+}
+
+UringSocketServer::UringSocketServer()
+    : wakeup_fd_(-1),
+      wakeup_pending_(false),
+      next_id_(1),
+      free_buffers_(kBufferCount) {}
+
+UringSocketServer::~UringSocketServer() {
+  if (wakeup_fd_ >= 0) {
+    ::close(wakeup_fd_);
+  }
+}
+
+bool UringSocketServer::Init() {
+  // Fails before Linux 6.1 on IORING_SETUP_DEFER_TASKRUN, which also covers
+  // multishot recv and recvmsg.
+  ring_ = std::make_unique<UringRing>();
+  if (!ring_->Init(kRingEntries) ||
+      !ring_->InitBuffers(kBufferCount, kBufferSize)) {
+    return false;
+  }
+  wakeup_fd_ = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  if (wakeup_fd_ < 0) {
+    return false;
+  }
+  // Submitted by the first Wait().
+  ArmWakeup();
+  return true;
+}
+
+Socket* UringSocketServer::CreateSocket(int32_t family, int32_t type) {
+  auto* socket = new UringSocket(this, family, type);
+  if (socket->GetSocketFD() < 0) {
+    delete socket;
+    return nullptr;
+  }
+  return socket;
+}
+
+bool UringSocketServer::Wait(int32_t cms) {
+  return WaitUs(cms == kForever ? kForever : cms * int64_t{1000});
+}
+
+bool UringSocketServer::WaitUs(int64_t timeout_us) {
+  if (!starved_.empty() && free_buffers_ > 0) {
+    for (uint64_t id : std::exchange(starved_, {})) {
+      auto it = sockets_.find(id);
+      if (it != sockets_.end()) {
+        it->second->ArmRecv();
+      }
+    }
+  }
+
+  // Events left from the last iteration are due now.
+  int32_t ret = ring_->Submit(events_.empty(), timeout_us);
+  if (ret < 0 && ret != -ETIME && ret != -EINTR && ret != -EBUSY) {
+    AVE_LOG(LS_ERROR) << "io_uring_enter failed: " << strerror(-ret);
+    return false;
+  }
+  ring_->ForEachCqe([this](const io_uring_cqe& cqe) { OnCompletion(cqe); });
+
+  bool processed = !events_.empty();
+  DispatchEvents();
+  return processed;
+}
+
+void UringSocketServer::WakeUp() {
+  if (wakeup_pending_.exchange(true, std::memory_order_acq_rel)) {
+    return;
+  }
+  uint64_t val = 1;
+  ::write(wakeup_fd_, &val, sizeof(val));
+}
+
+void UringSocketServer::Add(Dispatcher* dispatcher) {
+  if (!dispatcher || dispatcher_ids_.count(dispatcher)) {
+    return;
+  }
+  uint64_t id = next_id_++;
+  dispatchers_[id] = dispatcher;
+  dispatcher_ids_[dispatcher] = id;
+  ArmPoll(id, dispatcher);
+}
+
+void UringSocketServer::Remove(Dispatcher* dispatcher) {
+  auto it = dispatcher_ids_.find(dispatcher);
+  if (it == dispatcher_ids_.end()) {
+    return;
+  }
+  Cancel(UserData(it->second, kOpPoll));
+  dispatchers_.erase(it->second);
+  dispatcher_ids_.erase(it);
+}
+
+void UringSocketServer::Update(Dispatcher* dispatcher) {
+  auto it = dispatcher_ids_.find(dispatcher);
+  if (it == dispatcher_ids_.end()) {
+    return;
+  }
+  // Submitted in order, the cancel only finds the old request.
+  Cancel(UserData(it->second, kOpPoll));
+  ArmPoll(it->second, dispatcher);
+}
+
+void UringSocketServer::OnCompletion(const io_uring_cqe& cqe) {
+  auto op = static_cast<Op>(cqe.user_data & ((1 << kOpBits) - 1));
+  uint64_t id = cqe.user_data >> kOpBits;
+  if (cqe.flags & IORING_CQE_F_BUFFER) {
+    --free_buffers_;
+  }
+
+  switch (op) {
+    case kOpWakeup: {
+      if (cqe.res > 0) {
+        uint64_t val{};
+        ::read(wakeup_fd_, &val, sizeof(val));
+        wakeup_pending_.store(false, std::memory_order_release);
+      }
+      if (!(cqe.flags & IORING_CQE_F_MORE)) {
+        ArmWakeup();
+      }
+      return;
+    }
+    case kOpPoll: {
+      auto it = dispatchers_.find(id);
+      if (it == dispatchers_.end() || cqe.res == -ECANCELED) {
+        return;
+      }
+      if (cqe.res > 0) {
+        QueueEvent(id, PollEventsToDispatcherEvents(cqe.res), 0);
+      }
+      if (!(cqe.flags & IORING_CQE_F_MORE)) {
+        ArmPoll(id, it->second);
+      }
+      return;
+    }
+    case kOpCancel:
+      return;
+    default:
+      break;
+  }
+
+  auto it = sockets_.find(id);
+  if (it != sockets_.end()) {
+    it->second->OnCompletion(op, cqe);
+  } else if (cqe.flags & IORING_CQE_F_BUFFER) {
+    RecycleBuffer(static_cast<uint16_t>(cqe.flags >> IORING_CQE_BUFFER_SHIFT));
+  } else if (op == kOpAccept && cqe.res >= 0) {
+    ::close(cqe.res);
+  }
+}
+
+void UringSocketServer::DispatchEvents() {
+  // Handlers may queue events for the next iteration.
+  std::vector<Event> events;
+  events.swap(events_);
+  for (const Event& event : events) {
+    if (auto it = sockets_.find(event.id); it != sockets_.end()) {
+      it->second->Emit(event.events, event.error);
+    } else if (auto dit = dispatchers_.find(event.id);
+               dit != dispatchers_.end()) {
+      dit->second->OnEvent(event.events, event.error);
+    }
+  }
+  if (events_.empty()) {
+    events.clear();
+    events_.swap(events);
+  }
+}
+
+void UringSocketServer::ArmWakeup() {
+  io_uring_sqe* sqe = GetSqe();
+  if (!sqe) {
+    return;
+  }
+  sqe->opcode = IORING_OP_POLL_ADD;
+  sqe->fd = wakeup_fd_;
+  sqe->poll32_events = POLLIN;
+  sqe->len = IORING_POLL_ADD_MULTI;
+  sqe->user_data = UserData(0, kOpWakeup);
+}
+
+void UringSocketServer::ArmPoll(uint64_t id, Dispatcher* dispatcher) {
+  if (dispatcher->GetDescriptor() < 0) {
+    return;
+  }
+  io_uring_sqe* sqe = GetSqe();
+  if (!sqe) {
+    return;
+  }
+  sqe->opcode = IORING_OP_POLL_ADD;
+  sqe->fd = dispatcher->GetDescriptor();
+  sqe->poll32_events =
+      DispatcherEventsToPollEvents(dispatcher->GetRequestedEvents());
+  sqe->len = IORING_POLL_ADD_MULTI;
+  sqe->user_data = UserData(id, kOpPoll);
+}
+
+uint64_t UringSocketServer::Register(UringSocket* socket) {
+  uint64_t id = next_id_++;
+  sockets_[id] = socket;
+  return id;
+}
+
+void UringSocketServer::Unregister(uint64_t id) {
+  sockets_.erase(id);
+}
+
+io_uring_sqe* UringSocketServer::GetSqe() {
+  return ring_->GetSqe();
+}
+
+void UringSocketServer::Cancel(uint64_t user_data) {
+  io_uring_sqe* sqe = GetSqe();
+  if (!sqe) {
+    return;
+  }
+  sqe->opcode = IORING_OP_ASYNC_CANCEL;
+  sqe->addr = user_data;
+  sqe->user_data = UserData(0, kOpCancel);
+}
+
+void UringSocketServer::QueueEvent(uint64_t id,
+                                   uint32_t events,
+                                   int32_t error) {
+  events_.push_back({id, events, error});
+}
+
+void UringSocketServer::MarkStarved(uint64_t id) {
+  starved_.push_back(id);
+}
+
+const uint8_t* UringSocketServer::Buffer(uint16_t bid) const {
+  return ring_->Buffer(bid);
+}
+
+void UringSocketServer::RecycleBuffer(uint16_t bid) {
+  ++free_buffers_;
+  ring_->RecycleBuffer(bid);
+}
+
+}  // namespace net
+}  // namespace base
+}  // namespace ave
@@ -0,0 +1,121 @@
+/*
+ * uring_socket_server.h
+ * Copyright (C) 2026 youfa <vsyfar@gmail.com>
+ *
+ * Distributed under terms of the GPLv2 license.
+ */
+
+#ifndef BASE_NET_URING_SOCKET_SERVER_H
+#define BASE_NET_URING_SOCKET_SERVER_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include "base/net/socket_server.h"
+
+struct io_uring_cqe;
+struct io_uring_sqe;
+
+namespace ave {
+namespace base {
+namespace net {
+
+class UringRing;
+class UringSocket;
+
+// UringSocketServer implements SocketServer on io_uring. Sockets it creates
+// keep a multishot recv, recvmsg (UDP) or accept request in flight, so data
+// arrives without a readiness round trip. The kernel picks receive buffers
+// from a registered provided buffer ring. Requests queued during one loop
+// iteration are submitted together with the wait for the next.
+//
+// Sends stay plain non-blocking system calls. Write readiness is only polled
+// for after a send would block.
+//
+// Like PhysicalSocketServer, sockets are edge triggered: SignalReadEvent is
+// emitted when data arrives, and again on the next Wait() if a read left
+// data behind. UDP GRO and zero-copy sends are not available on these
+// sockets.
+//
+// Everything but WakeUp() must be called on the thread running Wait(). The
+// first Wait() ties the ring to its thread for good.
+//
+//   SocketThread thread(UringSocketServer::Create());
+//
+class UringSocketServer : public SocketServer {
+ public:
+  // Returns a UringSocketServer if the kernel has what it needs (Linux 6.1
+  // or later), a PhysicalSocketServer otherwise.
+  static std::unique_ptr<SocketServer> Create();
+
+  ~UringSocketServer() override;
+
+  // Disallow copy
+  UringSocketServer(const UringSocketServer&) = delete;
+  UringSocketServer& operator=(const UringSocketServer&) = delete;
+
+  // SocketFactory interface
+  Socket* CreateSocket(int32_t family, int32_t type) override;
+
+  // SocketServer interface
+  bool Wait(int32_t cms) override;
+  bool WaitUs(int64_t timeout_us) override;
+  void WakeUp() override;
+  // Other dispatchers are watched with multishot poll requests.
+  void Add(Dispatcher* dispatcher) override;
+  void Remove(Dispatcher* dispatcher) override;
+  void Update(Dispatcher* dispatcher) override;
+
+ private:
+  friend class UringSocket;
+
+  // An event for a socket or dispatcher, emitted once the completions of a
+  // Wait() are processed.
+  struct Event {
+    uint64_t id;
+    uint32_t events;  // DispatcherEvent
+    int32_t error;
+  };
+
+  UringSocketServer();
+  bool Init();
+
+  void OnCompletion(const io_uring_cqe& cqe);
+  void DispatchEvents();
+  void ArmWakeup();
+  void ArmPoll(uint64_t id, Dispatcher* dispatcher);
+
+  // For UringSocket.
+  uint64_t Register(UringSocket* socket);
+  void Unregister(uint64_t id);
+  io_uring_sqe* GetSqe();
+  void Cancel(uint64_t user_data);
+  void QueueEvent(uint64_t id, uint32_t events, int32_t error);
+  // The socket's recv request ended for lack of buffers, it is re-armed
+  // once buffers are recycled.
+  void MarkStarved(uint64_t id);
+  const uint8_t* Buffer(uint16_t bid) const;
+  void RecycleBuffer(uint16_t bid);
+
+  std::unique_ptr<UringRing> ring_;
+  int32_t wakeup_fd_;
+  // Set by the WakeUp() that writes `wakeup_fd_`, cleared once drained.
+  std::atomic<bool> wakeup_pending_;
+
+  uint64_t next_id_;
+  std::unordered_map<uint64_t, UringSocket*> sockets_;
+  std::unordered_map<uint64_t, Dispatcher*> dispatchers_;
+  std::unordered_map<Dispatcher*, uint64_t> dispatcher_ids_;
+  std::vector<Event> events_;
+  std::vector<uint64_t> starved_;
+  size_t free_buffers_;
+};
+
+}  // namespace net
+}  // namespace base
+}  // namespace ave
+
+#endif /* !BASE_NET_URING_SOCKET_SERVER_H */
@@ -0,0 +1,141 @@
+/*
+ * uring_socket_server_benchmark.cc
+ * Copyright (C) 2026 youfa <vsyfar@gmail.com>
+ *
+ * Distributed under terms of the GPLv2 license.
+ */
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "base/net/async_udp_socket.h"
+#include "base/net/physical_socket_server.h"
+#include "base/net/uring_socket_server.h"
+#include "benchmark/benchmark.h"
+
+namespace ave {
+namespace base {
+namespace net {
+namespace {
+
+constexpr size_t kDatagramSize = 200;
+constexpr size_t kChunkSize = 16 * 1024;
+
+std::unique_ptr<SocketServer> CreateServer(bool uring) {
+  if (uring) {
+    return UringSocketServer::Create();
+  }
+  return std::make_unique<PhysicalSocketServer>();
+}
+
+class PacketCounter : public sigslot::has_slots<> {
+ public:
+  void OnPacket(AsyncPacketSocket* socket [[maybe_unused]],
+                const uint8_t* data [[maybe_unused]],
+                size_t size [[maybe_unused]],
+                const SocketAddress& addr [[maybe_unused]],
+                int64_t timestamp [[maybe_unused]]) {
+    ++count;
+  }
+
+  int64_t count = 0;
+};
+
+class StreamReader : public sigslot::has_slots<> {
+ public:
+  void OnAccept(Socket* listener) {
+    socket.reset(listener->Accept(nullptr));
+    if (socket) {
+      socket->SignalReadEvent.connect(this, &StreamReader::OnRead);
+    }
+  }
+
+  void OnRead(Socket* s [[maybe_unused]]) {
+    int len;
+    while ((len = socket->Recv(buffer.data(), buffer.size(), nullptr)) > 0) {
+      bytes += len;
+    }
+  }
+
+  std::unique_ptr<Socket> socket;
+  std::vector<uint8_t> buffer = std::vector<uint8_t>(64 * 1024);
+  int64_t bytes = 0;
+};
+
+// Sends `state.range(0)` datagrams over loopback and receives them through
+// the socket server under test.
+void BM_UdpLoopback(benchmark::State& state, bool uring) {
+  std::unique_ptr<SocketServer> server = CreateServer(uring);
+  std::unique_ptr<AsyncUDPSocket> sender(AsyncUDPSocket::Create(
+      server->CreateSocket(AF_INET, SOCK_DGRAM), SocketAddress("127.0.0.1", 0)));
+  std::unique_ptr<AsyncUDPSocket> receiver(AsyncUDPSocket::Create(
+      server->CreateSocket(AF_INET, SOCK_DGRAM), SocketAddress("127.0.0.1", 0)));
+  receiver->SetOption(PacketSocketOption::kRecvBuf, 4 << 20);
+  PacketCounter counter;
+  receiver->SignalReadPacket.connect(&counter, &PacketCounter::OnPacket);
+
+  const int64_t count = state.range(0);
+  const SocketAddress to = receiver->GetLocalAddress();
+  std::vector<uint8_t> payload(kDatagramSize);
+  for (auto _ : state) {
+    const int64_t target = counter.count + count;
+    for (int64_t i = 0; i < count; ++i) {
+      sender->SendTo(payload.data(), payload.size(), to);
+    }
+    while (counter.count < target) {
+      server->Wait(100);
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * count);
+}
+
+// Streams `state.range(0)` bytes per iteration over a loopback TCP
+// connection, read through the socket server under test.
+void BM_TcpLoopback(benchmark::State& state, bool uring) {
+  std::unique_ptr<SocketServer> server = CreateServer(uring);
+  std::unique_ptr<Socket> listener(server->CreateSocket(AF_INET, SOCK_STREAM));
+  listener->Bind(SocketAddress("127.0.0.1", 0));
+  listener->Listen(1);
+  StreamReader reader;
+  listener->SignalReadEvent.connect(&reader, &StreamReader::OnAccept);
+
+  std::unique_ptr<Socket> client(server->CreateSocket(AF_INET, SOCK_STREAM));
+  client->Connect(listener->GetLocalAddress());
+  while (!reader.socket) {
+    server->Wait(100);
+  }
+
+  const int64_t size = state.range(0);
+  std::vector<uint8_t> chunk(kChunkSize);
+  for (auto _ : state) {
+    const int64_t target = reader.bytes + size;
+    int64_t sent = 0;
+    while (sent < size) {
+      int len = client->Send(
+          chunk.data(), std::min<int64_t>(chunk.size(), size - sent));
+      if (len > 0) {
+        sent += len;
+      } else {
+        server->Wait(0);
+      }
+    }
+    while (reader.bytes < target) {
+      server->Wait(100);
+    }
+  }
+  state.SetBytesProcessed(state.iterations() * size);
+}
+
+BENCHMARK_CAPTURE(BM_UdpLoopback, epoll, false)->Arg(64);
+BENCHMARK_CAPTURE(BM_UdpLoopback, uring, true)->Arg(64);
+BENCHMARK_CAPTURE(BM_TcpLoopback, epoll, false)->Arg(1 << 20);
+BENCHMARK_CAPTURE(BM_TcpLoopback, uring, true)->Arg(1 << 20);
+
+}  // namespace
+}  // namespace net
+}  // namespace base
+}  // namespace ave
+
+BENCHMARK_MAIN();
@@ -0,0 +1,194 @@
+/*
+ * uring_socket_server_unittest.cc
+ * Copyright (C) 2026 youfa <vsyfar@gmail.com>
+ *
+ * Distributed under terms of the GPLv2 license.
+ */
+
+#include "base/net/uring_socket_server.h"
+
+#include <chrono>
+#include <future>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "base/net/async_udp_socket.h"
+#include "base/net/physical_socket_server.h"
+#include "base/net/socket_thread.h"
+
+namespace ave {
+namespace base {
+namespace net {
+namespace {
+
+// Runs each test on io_uring (or its fallback) and on epoll, both must
+// behave the same.
+class SocketServerTest : public ::testing::TestWithParam<bool> {
+ protected:
+  void SetUp() override {
+    if (GetParam()) {
+      server_ = UringSocketServer::Create();
+    } else {
+      server_ = std::make_unique<PhysicalSocketServer>();
+    }
+  }
+
+  template <typename Predicate>
+  bool WaitFor(Predicate predicate) {
+    for (int i = 0; i < 200 && !predicate(); ++i) {
+      server_->Wait(10);
+    }
+    return predicate();
+  }
+
+  std::unique_ptr<SocketServer> server_;
+};
+
+class StreamPeer : public sigslot::has_slots<> {
+ public:
+  explicit StreamPeer(Socket* socket) : socket_(socket) {
+    socket_->SignalReadEvent.connect(this, &StreamPeer::OnRead);
+    socket_->SignalConnectEvent.connect(this, &StreamPeer::OnConnect);
+  }
+
+  void OnRead(Socket* socket [[maybe_unused]]) {
+    char buf[1024];
+    int len;
+    while ((len = socket_->Recv(buf, sizeof(buf), nullptr)) > 0) {
+      received.append(buf, len);
+    }
+    if (len == 0) {
+      closed = true;
+    }
+  }
+
+  void OnConnect(Socket* socket [[maybe_unused]]) { connected = true; }
+
+  std::unique_ptr<Socket> socket_;
+  std::string received;
+  bool connected = false;
+  bool closed = false;
+};
+
+class Listener : public sigslot::has_slots<> {
+ public:
+  explicit Listener(Socket* socket) : socket_(socket) {
+    socket_->SignalReadEvent.connect(this, &Listener::OnRead);
+  }
+
+  void OnRead(Socket* socket [[maybe_unused]]) {
+    while (Socket* accepted = socket_->Accept(nullptr)) {
+      peers.push_back(std::make_unique<StreamPeer>(accepted));
+    }
+  }
+
+  std::unique_ptr<Socket> socket_;
+  std::vector<std::unique_ptr<StreamPeer>> peers;
+};
+
+TEST_P(SocketServerTest, UdpLoopback) {
+  std::unique_ptr<AsyncUDPSocket> sender(AsyncUDPSocket::Create(
+      server_->CreateSocket(AF_INET, SOCK_DGRAM), SocketAddress("127.0.0.1", 0)));
+  std::unique_ptr<AsyncUDPSocket> receiver(AsyncUDPSocket::Create(
+      server_->CreateSocket(AF_INET, SOCK_DGRAM), SocketAddress("127.0.0.1", 0)));
+  ASSERT_TRUE(sender && receiver);
+
+  class Receiver : public sigslot::has_slots<> {
+   public:
+    void OnPacket(AsyncPacketSocket* socket [[maybe_unused]],
+                  const uint8_t* data,
+                  size_t size,
+                  const SocketAddress& addr,
+                  int64_t timestamp [[maybe_unused]]) {
+      packets.emplace_back(reinterpret_cast<const char*>(data), size);
+      from = addr;
+    }
+
+    std::vector<std::string> packets;
+    SocketAddress from;
+  } packet_receiver;
+  receiver->SignalReadPacket.connect(&packet_receiver, &Receiver::OnPacket);
+
+  std::vector<std::string> expected;
+  for (int i = 0; i < 100; ++i) {
+    expected.push_back("datagram " + std::to_string(i));
+    EXPECT_GT(sender->SendTo(expected.back().data(), expected.back().size(),
+                             receiver->GetLocalAddress()),
+              0);
+  }
+
+  EXPECT_TRUE(WaitFor([&] { return packet_receiver.packets.size() == 100; }));
+  EXPECT_EQ(packet_receiver.packets, expected);
+  EXPECT_EQ(packet_receiver.from.port(), sender->GetLocalAddress().port());
+}
+
+TEST_P(SocketServerTest, TcpAcceptEchoAndClose) {
+  Listener listener(server_->CreateSocket(AF_INET, SOCK_STREAM));
+  ASSERT_EQ(listener.socket_->Bind(SocketAddress("127.0.0.1", 0)), 0);
+  ASSERT_EQ(listener.socket_->Listen(5), 0);
+
+  StreamPeer client(server_->CreateSocket(AF_INET, SOCK_STREAM));
+  ASSERT_EQ(client.socket_->Connect(listener.socket_->GetLocalAddress()), 0);
+  ASSERT_TRUE(WaitFor([&] {
+    return client.connected && listener.peers.size() == 1;
+  }));
+  StreamPeer& server_peer = *listener.peers[0];
+
+  // More than one read and one provided buffer worth.
+  std::string request(200 * 1024, 'x');
+  size_t sent = 0;
+  while (sent < request.size()) {
+    int len = client.socket_->Send(request.data() + sent,
+                                   request.size() - sent);
+    if (len > 0) {
+      sent += len;
+    } else {
+      server_->Wait(10);
+    }
+  }
+  ASSERT_TRUE(WaitFor([&] {
+    return server_peer.received.size() == request.size();
+  }));
+  EXPECT_EQ(server_peer.received, request);
+
+  EXPECT_EQ(server_peer.socket_->Send("pong", 4), 4);
+  ASSERT_TRUE(WaitFor([&] { return client.received == "pong"; }));
+
+  client.socket_->Close();
+  EXPECT_TRUE(WaitFor([&] { return server_peer.closed; }));
+}
+
+TEST_P(SocketServerTest, RunsSocketThread) {
+  SocketThread thread(std::move(server_));
+  thread.Start();
+
+  std::promise<void> done;
+  auto start = std::chrono::steady_clock::now();
+  thread.PostDelayedTask([&done] { done.set_value(); }, 5);
+  done.get_future().wait();
+  EXPECT_GE(std::chrono::steady_clock::now() - start,
+            std::chrono::milliseconds(5));
+
+  int count = 0;
+  for (int i = 0; i < 1000; ++i) {
+    thread.PostTask([&count] { ++count; });
+  }
+  thread.Invoke([] {});
+  EXPECT_EQ(count, 1000);
+  thread.Stop();
+}
+
+INSTANTIATE_TEST_SUITE_P(Backends,
+                         SocketServerTest,
+                         ::testing::Values(true, false),
+                         [](const ::testing::TestParamInfo<bool>& info) {
+                           return info.param ? "Uring" : "Epoll";
+                         });
+
+}  // namespace
+}  // namespace net
+}  // namespace base
+}  // namespace ave
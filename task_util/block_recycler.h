@@ -0,0 +1,130 @@
+/*
+ * block_recycler.h
+ * Copyright (C) 2026 youfa <vsyfar@gmail.com>
+ *
+ * Distributed under terms of the GPLv2 license.
+ */
+
+#ifndef BLOCK_RECYCLER_H
+#define BLOCK_RECYCLER_H
+
+#include <cstddef>
+#include <mutex>
+#include <new>
+
+namespace ave {
+namespace base {
+
+// Process wide free list for blocks of `kSize` bytes, meant for the entries
+// task runners allocate for every post. Each thread caches a few blocks.
+// Runners free blocks on their own thread that producers allocated on
+// others, so full caches hand batches to a shared depot and empty ones take
+// a batch back, taking the lock once per kBatch blocks.
+template <size_t kSize>
+class BlockRecycler {
+ public:
+  static void* Allocate() {
+    Cache& cache = LocalCache();
+    if (!cache.head_ && !Refill(cache)) {
+      return ::operator new(kSize);
+    }
+    Block* block = cache.head_;
+    cache.head_ = block->next_;
+    --cache.count_;
+    return block;
+  }
+
+  static void Free(void* pointer) {
+    Cache& cache = LocalCache();
+    auto* block = static_cast<Block*>(pointer);
+    block->next_ = cache.head_;
+    cache.head_ = block;
+    if (++cache.count_ >= 2 * kBatch) {
+      Flush(cache, kBatch);
+    }
+  }
+
+ private:
+  static constexpr size_t kBatch = 32;
+  static constexpr size_t kMaxDepotBatches = 64;
+
+  struct Block {
+    Block* next_;
+    // Links batches in the depot, only valid on the first block of a batch.
+    Block* next_batch_;
+  };
+  static_assert(kSize >= sizeof(Block));
+
+  struct Cache {
+    ~Cache() { Flush(*this, count_); }
+    Block* head_ = nullptr;
+    size_t count_ = 0;
+  };
+
+  struct Depot {
+    std::mutex mutex_;
+    Block* batches_ = nullptr;
+    size_t count_ = 0;
+  };
+
+  static Cache& LocalCache() {
+    thread_local Cache cache;
+    return cache;
+  }
+
+  static Depot& GetDepot() {
+    // Leaked, thread caches flush into it during thread and process exit.
+    static Depot* depot = new Depot;
+    return *depot;
+  }
+
+  static bool Refill(Cache& cache) {
+    Depot& depot = GetDepot();
+    std::scoped_lock guard(depot.mutex_);
+    if (!depot.batches_) {
+      return false;
+    }
+    cache.head_ = depot.batches_;
+    depot.batches_ = depot.batches_->next_batch_;
+    --depot.count_;
+    cache.count_ = kBatch;
+    return true;
+  }
+
+  // Moves `count` blocks from the cache to the depot, or releases them once
+  // the depot is full.
+  static void Flush(Cache& cache, size_t count) {
+    if (count == 0) {
+      return;
+    }
+    Block* first = cache.head_;
+    Block* last = first;
+    for (size_t i = 1; i < count; ++i) {
+      last = last->next_;
+    }
+    cache.head_ = last->next_;
+    cache.count_ -= count;
+    last->next_ = nullptr;
+
+    if (count == kBatch) {
+      Depot& depot = GetDepot();
+      std::scoped_lock guard(depot.mutex_);
+      if (depot.count_ < kMaxDepotBatches) {
+        first->next_batch_ = depot.batches_;
+        depot.batches_ = first;
+        ++depot.count_;
+        return;
+      }
+    }
+    while (first) {
+      Block* next = first->next_;
+      ::operator delete(first);
+      first = next;
+    }
+  }
+};
+
+}  // namespace base
+}  // namespace ave
+
+#endif /* !BLOCK_RECYCLER_H */
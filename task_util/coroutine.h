@@ -0,0 +1,250 @@
+/*
+ * coroutine.h
+ * Copyright (C) 2026 youfa <vsyfar@gmail.com>
+ *
+ * Distributed under terms of the GPLv2 license.
+ */
+
+#ifndef COROUTINE_H
+#define COROUTINE_H
+
+#include <coroutine>
+#include <cstdint>
+#include <exception>
+#include <optional>
+#include <utility>
+
+#include "base/checks.h"
+#include "base/task_util/task_runner.h"
+#include "base/task_util/task_runner_base.h"
+
+namespace ave {
+namespace base {
+
+// Coroutines on top of task runners:
+//
+//   CoTask<int> Fetch(TaskRunner& io_runner) {
+//     co_await io_runner;        // continues on `io_runner`
+//     co_await SleepFor(10000);  // 10ms later, on the same runner
+//     co_return 42;
+//   }
+//
+//   CoTask<> Run(TaskRunner& io_runner) {
+//     int value = co_await Fetch(io_runner);
+//     ...
+//   }
+//
+//   Run(io_runner).Start();
+//
+// Runners resume the frame through a small InlineTask, which costs no
+// allocation on runners overriding TaskRunnerBase::PostInlineTask(). A frame
+// whose resumption is dropped by a runner that is shutting down is leaked.
+
+namespace coroutine_impl {
+
+inline void PostResume(TaskRunnerBase* runner,
+                       std::coroutine_handle<> handle,
+                       uint64_t delay_us) {
+  runner->PostInlineTask([handle]() { handle.resume(); }, delay_us);
+}
+
+class PromiseBase {
+ public:
+  std::suspend_always initial_suspend() noexcept { return {}; }
+
+  auto final_suspend() noexcept {
+    struct FinalAwaiter {
+      bool await_ready() noexcept { return false; }
+      std::coroutine_handle<> await_suspend(
+          std::coroutine_handle<> handle) noexcept {
+        if (promise_->detached_) {
+          handle.destroy();
+          return std::noop_coroutine();
+        }
+        return promise_->continuation_ ? promise_->continuation_
+                                       : std::noop_coroutine();
+      }
+      void await_resume() noexcept {}
+
+      PromiseBase* promise_;
+    };
+    return FinalAwaiter{this};
+  }
+
+  void unhandled_exception() {
+    if (detached_) {
+      // Nobody is left to observe it.
+      std::terminate();
+    }
+    exception_ = std::current_exception();
+  }
+
+  void set_continuation(std::coroutine_handle<> continuation) {
+    continuation_ = continuation;
+  }
+  void set_detached() { detached_ = true; }
+
+ protected:
+  void RethrowIfFailed() {
+    if (exception_) {
+      std::rethrow_exception(exception_);
+    }
+  }
+
+ private:
+  std::coroutine_handle<> continuation_;
+  std::exception_ptr exception_;
+  bool detached_ = false;
+};
+
+template <typename T>
+class Promise;
+
+}  // namespace coroutine_impl
+
+// Lazily started coroutine returning T. Either co_await it from another
+// coroutine, which starts it and continues once it is done, on whichever
+// runner it finished on, or Start() it and let it delete itself when done.
+template <typename T = void>
+class [[nodiscard]] CoTask {
+ public:
+  using promise_type = coroutine_impl::Promise<T>;
+
+  CoTask(CoTask&& other) noexcept
+      : handle_(std::exchange(other.handle_, nullptr)) {}
+  CoTask& operator=(CoTask&& other) noexcept {
+    if (this != &other) {
+      Reset();
+      handle_ = std::exchange(other.handle_, nullptr);
+    }
+    return *this;
+  }
+  CoTask(const CoTask&) = delete;
+  CoTask& operator=(const CoTask&) = delete;
+
+  ~CoTask() { Reset(); }
+
+  // Runs the coroutine on the calling thread up to its first suspension.
+  // The frame then owns itself.
+  void Start() && {
+    AVE_DCHECK(handle_);
+    std::coroutine_handle<promise_type> handle =
+        std::exchange(handle_, nullptr);
+    handle.promise().set_detached();
+    handle.resume();
+  }
+
+  auto operator co_await() && noexcept {
+    struct Awaiter {
+      bool await_ready() noexcept { return false; }
+      std::coroutine_handle<> await_suspend(
+          std::coroutine_handle<> continuation) noexcept {
+        handle_.promise().set_continuation(continuation);
+        return handle_;
+      }
+      T await_resume() { return handle_.promise().Result(); }
+
+      std::coroutine_handle<promise_type> handle_;
+    };
+    AVE_DCHECK(handle_);
+    return Awaiter{handle_};
+  }
+
+ private:
+  friend class coroutine_impl::Promise<T>;
+
+  explicit CoTask(std::coroutine_handle<promise_type> handle)
+      : handle_(handle) {}
+
+  void Reset() {
+    if (handle_) {
+      std::exchange(handle_, nullptr).destroy();
+    }
+  }
+
+  std::coroutine_handle<promise_type> handle_;
+};
+
+namespace coroutine_impl {
+
+template <typename T>
+class Promise final : public PromiseBase {
+ public:
+  CoTask<T> get_return_object() {
+    return CoTask<T>(std::coroutine_handle<Promise>::from_promise(*this));
+  }
+
+  template <typename Value>
+  void return_value(Value&& value) {
+    value_.emplace(std::forward<Value>(value));
+  }
+
+  T Result() {
+    RethrowIfFailed();
+    return std::move(*value_);
+  }
+
+ private:
+  std::optional<T> value_;
+};
+
+template <>
+class Promise<void> final : public PromiseBase {
+ public:
+  CoTask<> get_return_object() {
+    return CoTask<>(std::coroutine_handle<Promise>::from_promise(*this));
+  }
+
+  void return_void() {}
+
+  void Result() { RethrowIfFailed(); }
+};
+
+}  // namespace coroutine_impl
+
+// `co_await ResumeOn(runner)` continues the coroutine on `runner`. Does not
+// suspend when already running there.
+class ResumeOn {
+ public:
+  explicit ResumeOn(TaskRunnerBase* runner) : runner_(runner) {}
+
+  bool await_ready() const { return runner_->IsCurrent(); }
+  void await_suspend(std::coroutine_handle<> handle) {
+    coroutine_impl::PostResume(runner_, handle, 0);
+  }
+  void await_resume() {}
+
+ private:
+  TaskRunnerBase* const runner_;
+};
+
+inline ResumeOn operator co_await(TaskRunnerBase& runner) {
+  return ResumeOn(&runner);
+}
+
+inline ResumeOn operator co_await(TaskRunner& runner) {
+  return ResumeOn(runner.Get());
+}
+
+// `co_await SleepFor(delay_us)` suspends for `delay_us` and continues on the
+// runner it was called on, which must be a task runner thread.
+class SleepFor {
+ public:
+  explicit SleepFor(uint64_t delay_us) : delay_us_(delay_us) {}
+
+  bool await_ready() const { return false; }
+  void await_suspend(std::coroutine_handle<> handle) {
+    TaskRunnerBase* runner = TaskRunnerBase::Current();
+    AVE_CHECK(runner) << "SleepFor() needs to run on a task runner";
+    coroutine_impl::PostResume(runner, handle, delay_us_);
+  }
+  void await_resume() {}
+
+ private:
+  const uint64_t delay_us_;
+};
+
+}  // namespace base
+}  // namespace ave
+
+#endif /* !COROUTINE_H */
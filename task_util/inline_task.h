@@ -0,0 +1,148 @@
+/*
+ * inline_task.h
+ * Copyright (C) 2026 youfa <vsyfar@gmail.com>
+ *
+ * Distributed under terms of the GPLv2 license.
+ */
+
+#ifndef INLINE_TASK_H
+#define INLINE_TASK_H
+
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include "base/task_util/task.h"
+#include "base/task_util/to_task.h"
+
+namespace ave {
+namespace base {
+
+// Move-only task that keeps closures of up to kInlineSize bytes in place, so
+// posting one through TaskRunnerBase::PostInlineTask() does not allocate.
+// Larger closures, and those that may throw on move, go to the heap. A
+// std::unique_ptr<Task> is kept as is and keeps its Run() ownership rules.
+class InlineTask {
+ public:
+  static constexpr size_t kInlineSize = 48;
+
+  InlineTask() = default;
+
+  explicit InlineTask(std::unique_ptr<Task> task)
+      : InlineTask(TaskHolder{task.release()}) {}
+
+  template <typename Closure,
+            typename Stored = std::decay_t<Closure>,
+            std::enable_if_t<!std::is_same_v<Stored, InlineTask> &&
+                             std::is_invocable_v<Stored&>>* = nullptr>
+  InlineTask(Closure&& closure) {  // NOLINT(google-explicit-constructor)
+    if constexpr (FitsInline<Stored>()) {
+      new (storage_) Stored(std::forward<Closure>(closure));
+      ops_ = &kInlineOps<Stored>;
+    } else {
+      *reinterpret_cast<Stored**>(storage_) =
+          new Stored(std::forward<Closure>(closure));
+      ops_ = &kHeapOps<Stored>;
+    }
+  }
+
+  InlineTask(InlineTask&& other) noexcept { MoveFrom(other); }
+  InlineTask& operator=(InlineTask&& other) noexcept {
+    if (this != &other) {
+      Reset();
+      MoveFrom(other);
+    }
+    return *this;
+  }
+
+  ~InlineTask() { Reset(); }
+
+  explicit operator bool() const { return ops_ != nullptr; }
+
+  // Runs the task, which must not be empty, then destroys the closure the
+  // way a runner deletes a Task once it has run.
+  void Run() && {
+    ops_->run(storage_);
+    Reset();
+  }
+
+  // Wraps the task in a heap allocated Task for runners that do not override
+  // PostInlineTask().
+  std::unique_ptr<Task> ToTask() && {
+    return toTask(
+        [task = std::move(*this)]() mutable { std::move(task).Run(); });
+  }
+
+ private:
+  struct Ops {
+    void (*run)(void* storage);
+    // Move constructs into `to` and destroys `from`.
+    void (*relocate)(void* from, void* to);
+    void (*destroy)(void* storage);
+  };
+
+  // Follows the Task::Run() contract, the task deletes itself unless Run()
+  // returns false.
+  struct TaskHolder {
+    TaskHolder(Task* task) : task_(task) {}  // NOLINT
+    TaskHolder(TaskHolder&& other) noexcept
+        : task_(std::exchange(other.task_, nullptr)) {}
+    ~TaskHolder() { delete task_; }
+    void operator()() {
+      Task* task = std::exchange(task_, nullptr);
+      if (task->Run()) {
+        delete task;
+      }
+    }
+    Task* task_;
+  };
+
+  template <typename Stored>
+  static constexpr bool FitsInline() {
+    return sizeof(Stored) <= kInlineSize &&
+           alignof(Stored) <= alignof(std::max_align_t) &&
+           std::is_nothrow_move_constructible_v<Stored>;
+  }
+
+  template <typename Stored>
+  static constexpr Ops kInlineOps = {
+      [](void* storage) { (*static_cast<Stored*>(storage))(); },
+      [](void* from, void* to) {
+        new (to) Stored(std::move(*static_cast<Stored*>(from)));
+        static_cast<Stored*>(from)->~Stored();
+      },
+      [](void* storage) { static_cast<Stored*>(storage)->~Stored(); },
+  };
+
+  template <typename Stored>
+  static constexpr Ops kHeapOps = {
+      [](void* storage) { (**static_cast<Stored**>(storage))(); },
+      [](void* from, void* to) {
+        *static_cast<Stored**>(to) = *static_cast<Stored**>(from);
+      },
+      [](void* storage) { delete *static_cast<Stored**>(storage); },
+  };
+
+  void MoveFrom(InlineTask& other) {
+    if (other.ops_) {
+      other.ops_->relocate(other.storage_, storage_);
+      ops_ = std::exchange(other.ops_, nullptr);
+    }
+  }
+
+  void Reset() {
+    if (ops_) {
+      std::exchange(ops_, nullptr)->destroy(storage_);
+    }
+  }
+
+  alignas(std::max_align_t) unsigned char storage_[kInlineSize];
+  const Ops* ops_ = nullptr;
+};
+
+}  // namespace base
+}  // namespace ave
+
+#endif /* !INLINE_TASK_H */
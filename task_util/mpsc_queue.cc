@@ -0,0 +1,81 @@
+/*
+ * mpsc_queue.cc
+ * Copyright (C) 2026 youfa <vsyfar@gmail.com>
+ *
+ * Distributed under terms of the GPLv2 license.
+ */
+
+#include "mpsc_queue.h"
+
+namespace ave {
+namespace base {
+
+void MpscQueueBase::Chain::Append(MpscQueueNode* node) {
+  node->next_.store(nullptr, std::memory_order_relaxed);
+  if (last_) {
+    last_->next_.store(node, std::memory_order_relaxed);
+  } else {
+    first_ = node;
+  }
+  last_ = node;
+}
+
+MpscQueueBase::MpscQueueBase() : head_(&stub_), tail_(&stub_) {}
+
+void MpscQueueBase::Push(MpscQueueNode* node) {
+  node->next_.store(nullptr, std::memory_order_relaxed);
+  // Sequentially consistent so a consumer that announced it is going to
+  // sleep either sees this entry in `empty()` or is seen as asleep by us.
+  MpscQueueNode* prev = head_.exchange(node, std::memory_order_seq_cst);
+  prev->next_.store(node, std::memory_order_release);
+}
+
+void MpscQueueBase::Push(Chain& chain) {
+  if (chain.empty()) {
+    return;
+  }
+  // The links inside the chain are published by the release store below.
+  MpscQueueNode* prev = head_.exchange(chain.last_, std::memory_order_seq_cst);
+  prev->next_.store(chain.first_, std::memory_order_release);
+  chain.first_ = nullptr;
+  chain.last_ = nullptr;
+}
+
+MpscQueueNode* MpscQueueBase::Pop() {
+  MpscQueueNode* tail = tail_;
+  MpscQueueNode* next = tail->next_.load(std::memory_order_acquire);
+  if (tail == &stub_) {
+    if (!next) {
+      return nullptr;
+    }
+    tail_ = next;
+    tail = next;
+    next = next->next_.load(std::memory_order_acquire);
+  }
+
+  if (next) {
+    tail_ = next;
+    return tail;
+  }
+
+  if (tail != head_.load(std::memory_order_acquire)) {
+    // A producer has taken its place but not linked it yet.
+    return nullptr;
+  }
+
+  // `tail` is the last entry, put the stub behind it so it can be handed out.
+  Push(&stub_);
+  next = tail->next_.load(std::memory_order_acquire);
+  if (next) {
+    tail_ = next;
+    return tail;
+  }
+  return nullptr;
+}
+
+bool MpscQueueBase::empty() const {
+  return tail_ == &stub_ && head_.load(std::memory_order_seq_cst) == &stub_;
+}
+
+}  // namespace base
+}  // namespace ave
@@ -0,0 +1,105 @@
+/*
+ * mpsc_queue.h
+ * Copyright (C) 2026 youfa <vsyfar@gmail.com>
+ *
+ * Distributed under terms of the GPLv2 license.
+ */
+
+#ifndef MPSC_QUEUE_H
+#define MPSC_QUEUE_H
+
+#include <atomic>
+#include <memory>
+#include <type_traits>
+
+#include "base/constructor_magic.h"
+
+namespace ave {
+namespace base {
+
+// Intrusive hook for entries kept in a MpscQueue.
+class MpscQueueNode {
+ private:
+  friend class MpscQueueBase;
+  std::atomic<MpscQueueNode*> next_{nullptr};
+};
+
+// Intrusive lock-free multi producer, single consumer FIFO. Push is one
+// atomic exchange and never blocks; Pop is wait-free for the consumer but
+// may report nothing while a producer is between its exchange and linking
+// its node, `empty()` is false in that window.
+class MpscQueueBase {
+ public:
+  // Entries linked up front, so a whole batch is published by one Push().
+  class Chain {
+   public:
+    void Append(MpscQueueNode* node);
+    bool empty() const { return first_ == nullptr; }
+
+   private:
+    friend class MpscQueueBase;
+    MpscQueueNode* first_ = nullptr;
+    MpscQueueNode* last_ = nullptr;
+  };
+
+  MpscQueueBase();
+  ~MpscQueueBase() = default;
+
+  // May be called from any thread.
+  void Push(MpscQueueNode* node);
+  // Pushes every entry of `chain` with a single atomic exchange and leaves
+  // it empty. May be called from any thread.
+  void Push(Chain& chain);
+
+  // Consumer only. Returns the oldest entry, or nullptr.
+  MpscQueueNode* Pop();
+
+  // Consumer only. False once a Push has started, even if Pop can not yet
+  // return its entry.
+  bool empty() const;
+
+ private:
+  // Producers and the consumer write to different cache lines.
+  alignas(64) std::atomic<MpscQueueNode*> head_;
+  alignas(64) MpscQueueNode* tail_;
+  MpscQueueNode stub_;
+
+  AVE_DISALLOW_COPY_AND_ASSIGN(MpscQueueBase);
+};
+
+// Owning wrapper, `Entry` must derive from MpscQueueNode.
+template <typename Entry>
+class MpscQueue {
+ public:
+  static_assert(std::is_base_of_v<MpscQueueNode, Entry>);
+
+  MpscQueue() = default;
+  ~MpscQueue() {
+    while (!queue_.empty()) {
+      delete static_cast<Entry*>(queue_.Pop());
+    }
+  }
+
+  void Push(std::unique_ptr<Entry> entry) {
+    queue_.Push(static_cast<MpscQueueNode*>(entry.release()));
+  }
+
+  // The queue takes ownership of the entries in `chain`.
+  void Push(MpscQueueBase::Chain& chain) { queue_.Push(chain); }
+
+  std::unique_ptr<Entry> Pop() {
+    return std::unique_ptr<Entry>(static_cast<Entry*>(queue_.Pop()));
+  }
+
+  bool empty() const { return queue_.empty(); }
+
+ private:
+  MpscQueueBase queue_;
+
+  AVE_DISALLOW_COPY_AND_ASSIGN(MpscQueue);
+};
+
+}  // namespace base
+}  // namespace ave
+
+#endif /* !MPSC_QUEUE_H */
@@ -0,0 +1,137 @@
+/*
+ * parallel.cc
+ * Copyright (C) 2026 youfa <vsyfar@gmail.com>
+ *
+ * Distributed under terms of the GPLv2 license.
+ */
+
+#include "parallel.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include "base/task_util/task_runner_pool.h"
+
+namespace ave {
+namespace base {
+namespace {
+
+// Chunks per thread when the caller leaves the grain to us, enough to even
+// out uneven chunks without paying for many claims.
+constexpr size_t kChunksPerThread = 4;
+
+// One Run() call. Helpers that pick it up late may still touch it after the
+// caller returned, but only call `chunk_` while there is a chunk left, which
+// the caller waits for.
+class ParallelJob {
+ public:
+  ParallelJob(size_t begin,
+              size_t end,
+              size_t grain,
+              FunctionView<void(size_t, size_t)> chunk)
+      : begin_(begin),
+        end_(end),
+        grain_(grain),
+        num_chunks_((end - begin - 1) / grain + 1),
+        chunk_(chunk) {}
+
+  // Runs chunks until none are left.
+  void Work() {
+    {
+      std::scoped_lock guard(mutex_);
+      ++active_;
+    }
+    for (;;) {
+      size_t index = next_chunk_.fetch_add(1);
+      if (index >= num_chunks_) {
+        break;
+      }
+      size_t chunk_begin = begin_ + index * grain_;
+      chunk_(chunk_begin, chunk_begin + std::min(end_ - chunk_begin, grain_));
+    }
+    std::scoped_lock guard(mutex_);
+    if (--active_ == 0) {
+      idle_.notify_all();
+    }
+  }
+
+  // Called by the caller once its Work() ran out of chunks.
+  void WaitForHelpers() {
+    std::unique_lock<std::mutex> l(mutex_);
+    idle_.wait(l, [this] { return active_ == 0; });
+  }
+
+ private:
+  const size_t begin_;
+  const size_t end_;
+  const size_t grain_;
+  const size_t num_chunks_;
+  const FunctionView<void(size_t, size_t)> chunk_;
+  std::atomic<size_t> next_chunk_{0};
+
+  std::mutex mutex_;
+  std::condition_variable idle_;
+  // Threads inside Work().
+  int active_{0};
+};
+
+}  // namespace
+
+ParallelPool::ParallelPool(size_t num_helpers) {
+  if (num_helpers == 0) {
+    return;
+  }
+  factory_ = CreateTaskRunnerPoolFactory(num_helpers);
+  helpers_.reserve(num_helpers);
+  for (size_t i = 0; i < num_helpers; ++i) {
+    helpers_.push_back(factory_->CreateTaskRunner(
+        "parallel_helper", TaskRunnerFactory::Priority::NORMAL));
+  }
+}
+
+ParallelPool::~ParallelPool() = default;
+
+// static
+ParallelPool& ParallelPool::Default() {
+  // Never destroyed, callers may still run at exit.
+  static ParallelPool* pool = new ParallelPool(
+      std::max(1U, std::thread::hardware_concurrency()) - 1);
+  return *pool;
+}
+
+void ParallelPool::Run(size_t begin,
+                       size_t end,
+                       size_t grain,
+                       FunctionView<void(size_t, size_t)> chunk) {
+  if (begin >= end) {
+    return;
+  }
+  size_t size = end - begin;
+  if (grain == 0) {
+    grain = std::max<size_t>(1, size / (concurrency() * kChunksPerThread));
+  }
+  size_t num_chunks = (size - 1) / grain + 1;
+  if (num_chunks == 1 || helpers_.empty()) {
+    for (size_t i = begin; i < end;) {
+      size_t n = std::min(end - i, grain);
+      chunk(i, i + n);
+      i += n;
+    }
+    return;
+  }
+
+  auto job = std::make_shared<ParallelJob>(begin, end, grain, chunk);
+  size_t num_helpers = std::min(helpers_.size(), num_chunks - 1);
+  for (size_t i = 0; i < num_helpers; ++i) {
+    helpers_[i]->PostInlineTask([job]() { job->Work(); }, 0LL);
+  }
+  job->Work();
+  job->WaitForHelpers();
+}
+
+}  // namespace base
+}  // namespace ave
@@ -0,0 +1,109 @@
+/*
+ * parallel.h
+ * Copyright (C) 2026 youfa <vsyfar@gmail.com>
+ *
+ * Distributed under terms of the GPLv2 license.
+ */
+
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#include "base/function_view.h"
+#include "base/task_util/task_runner_base.h"
+#include "base/task_util/task_runner_factory.h"
+
+namespace ave {
+namespace base {
+
+// Helper threads for ParallelFor() and ParallelReduce(). The helpers are
+// runners of a work-stealing pool, see CreateTaskRunnerPoolFactory(), and
+// the calling thread always takes part in the work, so a pool with no
+// helpers runs everything on the caller.
+class ParallelPool {
+ public:
+  explicit ParallelPool(size_t num_helpers);
+  ~ParallelPool();
+
+  ParallelPool(const ParallelPool&) = delete;
+  ParallelPool& operator=(const ParallelPool&) = delete;
+
+  // Shared by the whole process, with one helper less than there are cores.
+  static ParallelPool& Default();
+
+  // Threads working on a call, the helpers and the caller.
+  size_t concurrency() const { return helpers_.size() + 1; }
+
+  // Calls `chunk` with consecutive slices of [begin, end) of at most `grain`
+  // items, handed out one at a time to whichever thread is free, until the
+  // range is done. Returns once every slice has run.
+  void Run(size_t begin,
+           size_t end,
+           size_t grain,
+           FunctionView<void(size_t, size_t)> chunk);
+
+ private:
+  std::unique_ptr<TaskRunnerFactory> factory_;
+  std::vector<std::unique_ptr<TaskRunnerBase, TaskRunnerDeleter>> helpers_;
+};
+
+// Runs `fn(chunk_begin, chunk_end)` over [begin, end) in chunks of `grain`
+// items, 0 picks a grain that gives each thread a few chunks. Chunks run
+// concurrently and in no particular order.
+template <class Fn>
+void ParallelFor(ParallelPool& pool,
+                 size_t begin,
+                 size_t end,
+                 size_t grain,
+                 Fn&& fn) {
+  pool.Run(begin, end, grain, fn);
+}
+
+template <class Fn>
+void ParallelFor(size_t begin, size_t end, size_t grain, Fn&& fn) {
+  ParallelFor(ParallelPool::Default(), begin, end, grain,
+              std::forward<Fn>(fn));
+}
+
+// Folds `map(chunk_begin, chunk_end)` of every chunk of [begin, end) into
+// `init` with `combine`, which must be associative and commutative since the
+// chunks finish in no particular order.
+template <class T, class Map, class Combine>
+T ParallelReduce(ParallelPool& pool,
+                 size_t begin,
+                 size_t end,
+                 size_t grain,
+                 T init,
+                 Map&& map,
+                 Combine&& combine) {
+  std::mutex mutex;
+  T result = std::move(init);
+  pool.Run(begin, end, grain, [&](size_t chunk_begin, size_t chunk_end) {
+    T partial = map(chunk_begin, chunk_end);
+    std::scoped_lock guard(mutex);
+    result = combine(std::move(result), std::move(partial));
+  });
+  return result;
+}
+
+template <class T, class Map, class Combine>
+T ParallelReduce(size_t begin,
+                 size_t end,
+                 size_t grain,
+                 T init,
+                 Map&& map,
+                 Combine&& combine) {
+  return ParallelReduce(ParallelPool::Default(), begin, end, grain,
+                        std::move(init), std::forward<Map>(map),
+                        std::forward<Combine>(combine));
+}
+
+}  // namespace base
+}  // namespace ave
+
+#endif /* !PARALLEL_H */
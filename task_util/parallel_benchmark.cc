@@ -0,0 +1,81 @@
+/*
+ * parallel_benchmark.cc
+ * Copyright (C) 2026 youfa <vsyfar@gmail.com>
+ *
+ * Distributed under terms of the GPLv2 license.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#include "base/task_util/parallel.h"
+#include "benchmark/benchmark.h"
+
+namespace ave {
+namespace base {
+namespace {
+
+constexpr size_t kSamples = 1 << 22;
+
+// Registers 1 to N threads, N being the cores of the machine.
+void ThreadCounts(benchmark::internal::Benchmark* benchmark) {
+  for (unsigned threads = 1;
+       threads <= std::max(1U, std::thread::hardware_concurrency());
+       ++threads) {
+    benchmark->Arg(threads);
+  }
+}
+
+// Sum of squares over a large sample array, `state.range(0)` threads.
+void BM_ParallelReduceSumOfSquares(benchmark::State& state) {
+  ParallelPool pool(static_cast<size_t>(state.range(0)) - 1);
+  std::vector<float> samples(kSamples);
+  for (size_t i = 0; i < samples.size(); ++i) {
+    samples[i] = std::sin(static_cast<float>(i));
+  }
+
+  for (auto _ : state) {
+    double energy = ParallelReduce(
+        pool, 0, samples.size(), 0, 0.0,
+        [&samples](size_t begin, size_t end) {
+          double sum = 0;
+          for (size_t i = begin; i < end; ++i) {
+            sum += samples[i] * samples[i];
+          }
+          return sum;
+        },
+        [](double a, double b) { return a + b; });
+    benchmark::DoNotOptimize(energy);
+  }
+  state.SetBytesProcessed(state.iterations() * kSamples * sizeof(float));
+}
+
+// Byte swap pass over 16 bit samples in place, `state.range(0)` threads.
+void BM_ParallelForByteSwap(benchmark::State& state) {
+  ParallelPool pool(static_cast<size_t>(state.range(0)) - 1);
+  std::vector<uint16_t> samples(kSamples, 0x1234);
+
+  for (auto _ : state) {
+    ParallelFor(pool, 0, samples.size(), 0,
+                [&samples](size_t begin, size_t end) {
+                  for (size_t i = begin; i < end; ++i) {
+                    samples[i] = static_cast<uint16_t>((samples[i] << 8) |
+                                                       (samples[i] >> 8));
+                  }
+                });
+    benchmark::ClobberMemory();
+  }
+  state.SetBytesProcessed(state.iterations() * kSamples * sizeof(uint16_t));
+}
+
+BENCHMARK(BM_ParallelReduceSumOfSquares)->Apply(ThreadCounts)->UseRealTime();
+BENCHMARK(BM_ParallelForByteSwap)->Apply(ThreadCounts)->UseRealTime();
+
+}  // namespace
+}  // namespace base
+}  // namespace ave
+
+BENCHMARK_MAIN();
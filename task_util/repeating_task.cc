@@ -8,61 +8,92 @@
 #include "repeating_task.h"
 
 #include <algorithm>
-#include <chrono>
 #include <cstdint>
 #include <memory>
 #include <utility>
 
 #include "base/logging.h"
-#include "base/task_util/pending_task_flag.h"
 
 namespace ave {
 namespace base {
 
 namespace repeating_task_impl {
-static uint64_t GetNowUs() {
-  auto systemClock = std::chrono::system_clock::now();
-  return std::chrono::duration_cast<std::chrono::microseconds>(
-             systemClock.time_since_epoch())
-      .count();
+bool RepeatingTaskState::PostNext(TaskRunnerBase* task_runner,
+                                  Task* task,
+                                  uint64_t delay_us,
+                                  uint64_t slack_us) {
+  std::scoped_lock guard(mutex_);
+  if (!alive_) {
+    return false;
+  }
+  pending_ = task_runner->PostCancellableTask(
+      InlineTask(std::unique_ptr<Task>(task)),
+      {.delay_us = delay_us, .slack_us = slack_us});
+  return true;
+}
+
+void RepeatingTaskState::Stop() {
+  TaskHandle pending;
+  {
+    std::scoped_lock guard(mutex_);
+    alive_ = false;
+    pending = std::move(pending_);
+  }
+  // Destroys the task unless it is running, it then sees `alive_` cleared.
+  pending.Cancel();
+}
+
+bool RepeatingTaskState::Alive() const {
+  std::scoped_lock guard(mutex_);
+  return alive_;
 }
 
 RepeatingTaskBase::RepeatingTaskBase(TaskRunnerBase* task_runner,
-                                     uint64_t first_delay_us,
-                                     std::shared_ptr<PendingTaskFlag> alive)
+                                     const RepeatingTaskOptions& options,
+                                     std::shared_ptr<RepeatingTaskState> state)
     : task_runner_(task_runner),
-      next_run_time_(GetNowUs() + first_delay_us),
-      alive_flag_(std::move(alive)) {}
+      slack_us_(options.slack_us),
+      next_run_time_(task_runner->NowUs() + options.first_delay_us),
+      state_(std::move(state)) {}
 RepeatingTaskBase::~RepeatingTaskBase() = default;
 
+void RepeatingTaskBase::Start() {
+  uint64_t now_us = task_runner_->NowUs();
+  uint64_t delay_us = next_run_time_ > now_us ? next_run_time_ - now_us : 0;
+  std::shared_ptr<RepeatingTaskState> state = state_;
+  state->PostNext(task_runner_, this, delay_us, slack_us_);
+}
+
 bool RepeatingTaskBase::Run() {
-  if (!alive_flag_->Alive()) {
+  if (!state_->Alive()) {
     return true;
   }
 
-  // TODO(youfa): use time utils to avoid overflow.
-  uint64_t delay = RunClosure();
-
-  uint64_t lost_time = GetNowUs() - next_run_time_;
-  next_run_time_ += delay;
-  delay = (lost_time > delay) ? 0 : delay;
+  uint64_t period_us = RunClosure();
 
-  if (!alive_flag_->Alive()) {
-    return true;
+  uint64_t now_us = task_runner_->NowUs();
+  if (period_us == 0) {
+    next_run_time_ = now_us;
+  } else {
+    next_run_time_ += period_us;
+    if (next_run_time_ < now_us) {
+      // More than a period behind, skip the missed runs but keep the phase.
+      next_run_time_ += (now_us - next_run_time_ + period_us - 1) /
+                        period_us * period_us;
+    }
   }
-
-  task_runner_->PostDelayedTask(std::unique_ptr<RepeatingTaskBase>(this),
-                                delay);
+  uint64_t delay_us = next_run_time_ - now_us;
 
   // Return false to tell the TaskQueue to not destruct this object since we
   // have taken ownership of it.
-  return false;
+  std::shared_ptr<RepeatingTaskState> state = state_;
+  return !state->PostNext(task_runner_, this, delay_us, slack_us_);
 }
 }  // namespace repeating_task_impl
 
 void RepeatingTaskHandle::Stop() {
   if (repeating_task_) {
-    repeating_task_->SetNotAlive();
+    repeating_task_->Stop();
     repeating_task_ = nullptr;
   }
 }
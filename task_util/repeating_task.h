@@ -11,41 +11,78 @@
 #include <base/task_util/task.h>
 #include <cstdint>
 #include <memory>
-#include "base/task_util/pending_task_flag.h"
+#include <mutex>
+#include "base/task_util/task_handle.h"
 #include "base/task_util/task_runner_base.h"
 
 namespace ave {
 namespace base {
-using base::PendingTaskFlag;
 using base::Task;
 using base::TaskRunnerBase;
 
+struct RepeatingTaskOptions {
+  uint64_t first_delay_us = 0;
+  // Lets each run start up to this much late, so loops on one runner with
+  // compatible periods fire in one wakeup, see PostOptions::slack_us. Runs
+  // stay anchored to the start time, the slack does not add up.
+  uint64_t slack_us = 0;
+};
+
 namespace repeating_task_impl {
+// Shared by a RepeatingTaskHandle and its task. Keeps the handle of the next
+// run, so stopping removes it from the runner right away.
+class RepeatingTaskState {
+ public:
+  RepeatingTaskState() = default;
+  ~RepeatingTaskState() = default;
+
+  // Posts the next run of `task`, taking ownership of it, unless stopped.
+  bool PostNext(TaskRunnerBase* task_runner,
+                Task* task,
+                uint64_t delay_us,
+                uint64_t slack_us);
+
+  void Stop();
+
+  bool Alive() const;
+
+ private:
+  mutable std::mutex mutex_;
+  bool alive_ = true;
+  TaskHandle pending_;
+};
+
 class RepeatingTaskBase : public Task {
  public:
   RepeatingTaskBase(TaskRunnerBase* task_runner,
-                    uint64_t first_delay_us,
-                    std::shared_ptr<PendingTaskFlag> alive_flag);
+                    const RepeatingTaskOptions& options,
+                    std::shared_ptr<RepeatingTaskState> state);
   ~RepeatingTaskBase() override;
 
+  // Posts the first run.
+  void Start();
+
  private:
   virtual uint64_t RunClosure() = 0;
 
   bool Run() final;
 
   TaskRunnerBase* const task_runner_;
+  const uint64_t slack_us_;
+  // On the clock of the runner, see TaskRunnerBase::NowUs(), advanced by the
+  // returned period after each run so the schedule does not drift.
   uint64_t next_run_time_;
-  std::shared_ptr<PendingTaskFlag> alive_flag_;
+  std::shared_ptr<RepeatingTaskState> state_;
 };
 
 template <class Closure>
 class RepeatingTaskImpl final : public RepeatingTaskBase {
  public:
   RepeatingTaskImpl(TaskRunnerBase* task_runner,
-                    uint64_t first_delay,
+                    const RepeatingTaskOptions& options,
                     Closure&& closure,
-                    std::shared_ptr<PendingTaskFlag> alive_flag)
-      : RepeatingTaskBase(task_runner, first_delay, std::move(alive_flag)),
+                    std::shared_ptr<RepeatingTaskState> state)
+      : RepeatingTaskBase(task_runner, options, std::move(state)),
         closure_(std::forward<Closure>(closure)) {
     static_assert(
         std::is_same_v<uint64_t, std::invoke_result_t<
@@ -68,14 +105,13 @@ class RepeatingTaskHandle {
   RepeatingTaskHandle(const RepeatingTaskHandle&) = delete;
   RepeatingTaskHandle& operator=(const RepeatingTaskHandle&) = delete;
 
+  // Runs `closure` until stopped, each run is followed by the next one after
+  // the period in microseconds it returns.
   template <class Closure>
   static RepeatingTaskHandle Start(TaskRunnerBase* task_runner,
                                    Closure&& closure) {
-    auto alive_flag = PendingTaskFlag::Create();
-    task_runner->PostTask(
-        std::make_unique<repeating_task_impl::RepeatingTaskImpl<Closure>>(
-            task_runner, 0LL, std::forward<Closure>(closure), alive_flag));
-    return RepeatingTaskHandle(std::move(alive_flag));
+    return Start(task_runner, RepeatingTaskOptions(),
+                 std::forward<Closure>(closure));
   }
 
   // DelayedStart is equivalent to Start except that the first invocation of the
@@ -84,13 +120,19 @@ class RepeatingTaskHandle {
   static RepeatingTaskHandle DelayedStart(TaskRunnerBase* task_runner,
                                           uint64_t first_delay_us,
                                           Closure&& closure) {
-    auto alive_flag = PendingTaskFlag::Create();
-    task_runner->PostDelayedTask(
-        std::make_unique<repeating_task_impl::RepeatingTaskImpl<Closure>>(
-            task_runner, first_delay_us, std::forward<Closure>(closure),
-            alive_flag),
-        first_delay_us);
-    return RepeatingTaskHandle(std::move(alive_flag));
+    return Start(task_runner, {.first_delay_us = first_delay_us},
+                 std::forward<Closure>(closure));
+  }
+
+  template <class Closure>
+  static RepeatingTaskHandle Start(TaskRunnerBase* task_runner,
+                                   const RepeatingTaskOptions& options,
+                                   Closure&& closure) {
+    auto state = std::make_shared<repeating_task_impl::RepeatingTaskState>();
+    (new repeating_task_impl::RepeatingTaskImpl<Closure>(
+         task_runner, options, std::forward<Closure>(closure), state))
+        ->Start();
+    return RepeatingTaskHandle(std::move(state));
   }
 
   void Stop();
@@ -98,9 +140,10 @@ class RepeatingTaskHandle {
   bool Running() const;
 
  private:
-  explicit RepeatingTaskHandle(std::shared_ptr<PendingTaskFlag> alive_flag)
-      : repeating_task_(std::move(alive_flag)) {}
-  std::shared_ptr<PendingTaskFlag> repeating_task_;
+  explicit RepeatingTaskHandle(
+      std::shared_ptr<repeating_task_impl::RepeatingTaskState> state)
+      : repeating_task_(std::move(state)) {}
+  std::shared_ptr<repeating_task_impl::RepeatingTaskState> repeating_task_;
 };
 
 }  // namespace base
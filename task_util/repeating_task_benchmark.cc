@@ -0,0 +1,81 @@
+/*
+ * repeating_task_benchmark.cc
+ * Copyright (C) 2026 youfa <vsyfar@gmail.com>
+ *
+ * Distributed under terms of the GPLv2 license.
+ */
+
+#include <sys/resource.h>
+
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "base/task_util/default_task_runner_factory.h"
+#include "base/task_util/repeating_task.h"
+#include "base/task_util/task_runner.h"
+#include "benchmark/benchmark.h"
+
+namespace ave {
+namespace base {
+namespace {
+
+constexpr int kTasks = 1000;
+constexpr uint64_t kPeriodUs = 10 * 1000;
+
+int64_t VoluntaryContextSwitches() {
+  struct rusage usage {};
+  getrusage(RUSAGE_SELF, &usage);
+  return usage.ru_nvcsw;
+}
+
+// Runs 1000 repeating tasks with a 10ms period and phases spread over the
+// period on one runner, with `state.range(0)` us of slack. Reports how often
+// the process gave up the CPU, i.e. roughly the runner wakeups.
+void BM_RepeatingTaskWakeups(benchmark::State& state) {
+  auto factory = CreateDefaultTaskRunnerFactory();
+  TaskRunner runner(factory->CreateTaskRunner(
+      "RepeatingTaskWakeups", TaskRunnerFactory::Priority::NORMAL));
+  std::vector<RepeatingTaskHandle> handles;
+  handles.reserve(kTasks);
+  for (int i = 0; i < kTasks; ++i) {
+    RepeatingTaskOptions options;
+    options.first_delay_us = kPeriodUs * i / kTasks;
+    options.slack_us = static_cast<uint64_t>(state.range(0));
+    handles.push_back(RepeatingTaskHandle::Start(
+        runner.Get(), options, []() { return kPeriodUs; }));
+  }
+
+  int64_t switches = 0;
+  auto elapsed = std::chrono::steady_clock::duration::zero();
+  for (auto _ : state) {
+    auto start = std::chrono::steady_clock::now();
+    int64_t start_switches = VoluntaryContextSwitches();
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    switches += VoluntaryContextSwitches() - start_switches;
+    elapsed += std::chrono::steady_clock::now() - start;
+  }
+
+  runner.PostTaskAndWait([&handles]() {
+    for (auto& handle : handles) {
+      handle.Stop();
+    }
+  });
+  state.counters["wakeups_per_sec"] = benchmark::Counter(
+      static_cast<double>(switches) /
+      std::chrono::duration<double>(elapsed).count());
+}
+
+BENCHMARK(BM_RepeatingTaskWakeups)
+    ->Arg(0)
+    ->Arg(1000)
+    ->Arg(4000)
+    ->Iterations(5)
+    ->UseRealTime();
+
+}  // namespace
+}  // namespace base
+}  // namespace ave
+
+BENCHMARK_MAIN();
@@ -0,0 +1,361 @@
+/*
+ * simulated_time_controller.cc
+ * Copyright (C) 2026 youfa <vsyfar@gmail.com>
+ *
+ * Distributed under terms of the GPLv2 license.
+ */
+
+#include "simulated_time_controller.h"
+
+#include <atomic>
+#include <cstdint>
+#include <limits>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "base/checks.h"
+#include "base/count_down_latch.h"
+#include "base/task_util/inline_task.h"
+#include "base/task_util/task_handle.h"
+#include "base/task_util/task_runner_base.h"
+
+namespace ave {
+namespace base {
+namespace {
+
+constexpr uint64_t kNever = std::numeric_limits<uint64_t>::max();
+
+// Queued tasks run by due time, then lane, then post order.
+using TaskKey = std::tuple<uint64_t, TaskLane, uint64_t>;
+
+class SimulatedTaskRunner;
+
+}  // namespace
+
+class SimulatedScheduler
+    : public std::enable_shared_from_this<SimulatedScheduler> {
+ public:
+  // Shared by a TaskHandle and the entry it cancels.
+  class EntryDelegate final : public TaskHandle::Delegate {
+   public:
+    explicit EntryDelegate(std::weak_ptr<SimulatedScheduler> scheduler)
+        : scheduler_(std::move(scheduler)) {}
+
+    bool Cancel() override;
+
+    // Called before running the entry, returns false if it was cancelled.
+    bool Start() { return !done_.exchange(true); }
+
+   private:
+    friend class SimulatedScheduler;
+    const std::weak_ptr<SimulatedScheduler> scheduler_;
+    std::atomic<bool> done_{false};
+    // Guarded by `mutex_` of the scheduler.
+    TaskKey key_;
+  };
+
+  struct Entry {
+    SimulatedTaskRunner* runner_{nullptr};
+    InlineTask task_;
+    std::shared_ptr<EntryDelegate> delegate_;
+    // Releases a waiting poster once the entry is done with, run or not.
+    ScopedCountDown done_;
+    // Absolute, dropped instead of run once this has passed, 0 for none.
+    uint64_t deadline_us_{0};
+    InlineTask on_late_;
+  };
+
+  explicit SimulatedScheduler(Timestamp start_time) : clock_(start_time) {}
+
+  SimulatedClock* clock() { return &clock_; }
+  uint64_t NowUs() {
+    return static_cast<uint64_t>(clock_.TimeInMicroseconds());
+  }
+
+  void Post(std::unique_ptr<Entry> entry, uint64_t when_us, TaskLane lane);
+  // Drops the queued tasks of `runner`.
+  void RemoveRunner(SimulatedTaskRunner* runner);
+
+  // Runs the first task due by `until_us`, moving the clock forward to its
+  // due time. Returns false if there is none.
+  bool RunNext(uint64_t until_us);
+  // Runs every task due by `time_us`, then sets the clock to it.
+  void AdvanceTo(uint64_t time_us);
+
+ private:
+  // Takes a cancelled entry out of the queue and destroys it.
+  void Remove(const TaskKey& key);
+
+  SimulatedClock clock_;
+  std::mutex mutex_;
+  uint64_t order_{0};
+  std::map<TaskKey, std::unique_ptr<Entry>> tasks_;
+};
+
+namespace {
+
+class SimulatedTaskRunner final : public TaskRunnerBase {
+ public:
+  using Entry = SimulatedScheduler::Entry;
+
+  explicit SimulatedTaskRunner(std::shared_ptr<SimulatedScheduler> scheduler)
+      : scheduler_(std::move(scheduler)) {}
+
+  void Destruct() override;
+  void PostTask(std::unique_ptr<Task> task) override;
+  void PostDelayedTask(std::unique_ptr<Task> task, uint64_t delay_us) override;
+  void PostDelayedTaskAndWait(std::unique_ptr<Task> task,
+                              uint64_t delay_us,
+                              bool wait) override;
+  void PostInlineTask(InlineTask task, uint64_t delay_us) override;
+  TaskHandle PostCancellableTask(InlineTask task,
+                                 PostOptions options) override;
+  bool PostTaskWithOptions(InlineTask task, PostOptions options) override;
+  uint64_t NowUs() const override { return scheduler_->NowUs(); }
+
+  // Called by the scheduler on the driving thread.
+  void Run(std::unique_ptr<Entry> entry);
+
+ private:
+  ~SimulatedTaskRunner() override = default;
+
+  void Post(std::unique_ptr<Entry> entry, PostOptions& options);
+
+  const std::shared_ptr<SimulatedScheduler> scheduler_;
+  // Only touched by the driving thread.
+  bool running_{false};
+  bool destroyed_{false};
+};
+
+void SimulatedTaskRunner::Destruct() {
+  scheduler_->RemoveRunner(this);
+  // Destroyed from one of its own tasks, finish that task first.
+  if (running_) {
+    destroyed_ = true;
+    return;
+  }
+  delete this;
+}
+
+void SimulatedTaskRunner::PostTask(std::unique_ptr<Task> task) {
+  PostInlineTask(InlineTask(std::move(task)), 0LL);
+}
+
+void SimulatedTaskRunner::PostDelayedTask(std::unique_ptr<Task> task,
+                                          uint64_t delay_us) {
+  PostInlineTask(InlineTask(std::move(task)), delay_us);
+}
+
+void SimulatedTaskRunner::PostDelayedTaskAndWait(std::unique_ptr<Task> task,
+                                                 uint64_t delay_us,
+                                                 bool wait) {
+  CountDownLatch done(1);
+  auto entry = std::make_unique<Entry>();
+  entry->task_ = InlineTask(std::move(task));
+  if (wait) {
+    entry->done_.reset(&done);
+  }
+  PostOptions options{.delay_us = delay_us};
+  Post(std::move(entry), options);
+  // Nobody else drives the clock, run the controller until the task is done.
+  while (wait && done.GetCount() > 0 && scheduler_->RunNext(kNever)) {
+  }
+}
+
+void SimulatedTaskRunner::PostInlineTask(InlineTask task, uint64_t delay_us) {
+  auto entry = std::make_unique<Entry>();
+  entry->task_ = std::move(task);
+  PostOptions options{.delay_us = delay_us};
+  Post(std::move(entry), options);
+}
+
+TaskHandle SimulatedTaskRunner::PostCancellableTask(InlineTask task,
+                                                    PostOptions options) {
+  auto delegate = std::make_shared<SimulatedScheduler::EntryDelegate>(
+      scheduler_->weak_from_this());
+  auto entry = std::make_unique<Entry>();
+  entry->task_ = std::move(task);
+  entry->delegate_ = delegate;
+  Post(std::move(entry), options);
+  return TaskHandle(std::move(delegate));
+}
+
+bool SimulatedTaskRunner::PostTaskWithOptions(InlineTask task,
+                                              PostOptions options) {
+  auto entry = std::make_unique<Entry>();
+  entry->task_ = std::move(task);
+  Post(std::move(entry), options);
+  return true;
+}
+
+void SimulatedTaskRunner::Post(std::unique_ptr<Entry> entry,
+                               PostOptions& options) {
+  uint64_t now_us = scheduler_->NowUs();
+  entry->runner_ = this;
+  if (options.deadline_us > 0) {
+    entry->deadline_us_ = DueTimeUs(now_us, options.deadline_us, 0);
+    entry->on_late_ = std::move(options.on_late);
+  }
+  scheduler_->Post(std::move(entry),
+                   DueTimeUs(now_us, options.delay_us, options.slack_us),
+                   options.lane);
+}
+
+void SimulatedTaskRunner::Run(std::unique_ptr<Entry> entry) {
+  if (entry->delegate_ && !entry->delegate_->Start()) {
+    return;
+  }
+  {
+    CurrentTaskRunnerSetter set_current(this);
+    bool was_running = running_;
+    running_ = true;
+    if (entry->deadline_us_ > 0 && NowUs() > entry->deadline_us_) {
+      if (entry->on_late_) {
+        std::move(entry->on_late_).Run();
+      }
+    } else {
+      std::move(entry->task_).Run();
+    }
+    running_ = was_running;
+  }
+  entry.reset();
+  if (destroyed_ && !running_) {
+    delete this;
+  }
+}
+
+class SimulatedTaskRunnerFactory final : public TaskRunnerFactory {
+ public:
+  explicit SimulatedTaskRunnerFactory(
+      std::shared_ptr<SimulatedScheduler> scheduler)
+      : scheduler_(std::move(scheduler)) {}
+
+  using TaskRunnerFactory::CreateTaskRunner;
+
+  std::unique_ptr<TaskRunnerBase, TaskRunnerDeleter> CreateTaskRunner(
+      const char* name [[maybe_unused]],
+      Priority priority [[maybe_unused]]) const override {
+    return std::unique_ptr<TaskRunnerBase, TaskRunnerDeleter>(
+        new SimulatedTaskRunner(scheduler_));
+  }
+
+ private:
+  const std::shared_ptr<SimulatedScheduler> scheduler_;
+};
+
+}  // namespace
+
+bool SimulatedScheduler::EntryDelegate::Cancel() {
+  if (done_.exchange(true)) {
+    return false;
+  }
+  if (std::shared_ptr<SimulatedScheduler> scheduler = scheduler_.lock()) {
+    scheduler->Remove(key_);
+  }
+  return true;
+}
+
+void SimulatedScheduler::Post(std::unique_ptr<Entry> entry,
+                              uint64_t when_us,
+                              TaskLane lane) {
+  std::scoped_lock guard(mutex_);
+  TaskKey key(when_us, lane, order_++);
+  if (entry->delegate_) {
+    entry->delegate_->key_ = key;
+  }
+  tasks_.emplace(key, std::move(entry));
+}
+
+void SimulatedScheduler::Remove(const TaskKey& key) {
+  std::unique_ptr<Entry> entry;
+  {
+    std::scoped_lock guard(mutex_);
+    auto it = tasks_.find(key);
+    if (it == tasks_.end()) {
+      return;
+    }
+    entry = std::move(it->second);
+    tasks_.erase(it);
+  }
+  // Destroyed outside the lock, the closure may post.
+}
+
+void SimulatedScheduler::RemoveRunner(SimulatedTaskRunner* runner) {
+  std::vector<std::unique_ptr<Entry>> dropped;
+  {
+    std::scoped_lock guard(mutex_);
+    for (auto it = tasks_.begin(); it != tasks_.end();) {
+      if (it->second->runner_ == runner) {
+        dropped.push_back(std::move(it->second));
+        it = tasks_.erase(it);
+      } else {
+        ++it;
+      }
+    }
+  }
+}
+
+bool SimulatedScheduler::RunNext(uint64_t until_us) {
+  std::unique_ptr<Entry> entry;
+  {
+    std::scoped_lock guard(mutex_);
+    if (tasks_.empty()) {
+      return false;
+    }
+    auto it = tasks_.begin();
+    uint64_t when_us = std::get<0>(it->first);
+    if (when_us > until_us) {
+      return false;
+    }
+    AVE_CHECK(when_us != kNever) << "Task posted with an endless delay";
+    uint64_t now_us = NowUs();
+    if (when_us > now_us) {
+      clock_.AdvanceTimeMicroseconds(static_cast<int64_t>(when_us - now_us));
+    }
+    entry = std::move(it->second);
+    tasks_.erase(it);
+  }
+  SimulatedTaskRunner* runner = entry->runner_;
+  runner->Run(std::move(entry));
+  return true;
+}
+
+void SimulatedScheduler::AdvanceTo(uint64_t time_us) {
+  while (RunNext(time_us)) {
+  }
+  uint64_t now_us = NowUs();
+  if (time_us > now_us) {
+    clock_.AdvanceTimeMicroseconds(static_cast<int64_t>(time_us - now_us));
+  }
+}
+
+SimulatedTimeController::SimulatedTimeController(Timestamp start_time)
+    : scheduler_(std::make_shared<SimulatedScheduler>(start_time)),
+      factory_(std::make_unique<SimulatedTaskRunnerFactory>(scheduler_)) {}
+
+SimulatedTimeController::~SimulatedTimeController() = default;
+
+Clock* SimulatedTimeController::GetClock() {
+  return scheduler_->clock();
+}
+
+TaskRunnerFactory* SimulatedTimeController::GetTaskRunnerFactory() {
+  return factory_.get();
+}
+
+void SimulatedTimeController::RunReady() {
+  scheduler_->AdvanceTo(scheduler_->NowUs());
+}
+
+void SimulatedTimeController::AdvanceTime(TimeDelta duration) {
+  AVE_DCHECK_GE(duration.us(), 0);
+  scheduler_->AdvanceTo(scheduler_->NowUs() +
+                        static_cast<uint64_t>(duration.us()));
+}
+
+}  // namespace base
+}  // namespace ave
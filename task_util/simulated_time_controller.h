@@ -0,0 +1,65 @@
+/*
+ * simulated_time_controller.h
+ * Copyright (C) 2026 youfa <vsyfar@gmail.com>
+ *
+ * Distributed under terms of the GPLv2 license.
+ */
+
+#ifndef SIMULATED_TIME_CONTROLLER_H
+#define SIMULATED_TIME_CONTROLLER_H
+
+#include <memory>
+
+#include "base/clock.h"
+#include "base/task_util/task_runner_factory.h"
+#include "base/units/time_delta.h"
+#include "base/units/timestamp.h"
+
+namespace ave {
+namespace base {
+
+class SimulatedScheduler;
+
+// Drives task runners on virtual time kept by a SimulatedClock. Nothing runs
+// on its own: RunReady() and AdvanceTime() run the due tasks of all runners
+// of the controller on the calling thread, jumping the clock from one timer
+// to the next, so hours of timer driven behaviour replay in milliseconds and
+// in the same order on every run.
+//
+// Tasks may be posted from any thread, but drive the controller from one
+// thread at a time. PostTaskAndWait() on a simulated runner drives the
+// controller on the calling thread until the task has run, and Invoke() from
+// a thread other than a driving one blocks until a driver runs the task.
+// Destroy the runners before the controller.
+class SimulatedTimeController {
+ public:
+  explicit SimulatedTimeController(Timestamp start_time);
+  ~SimulatedTimeController();
+
+  SimulatedTimeController(const SimulatedTimeController&) = delete;
+  SimulatedTimeController& operator=(const SimulatedTimeController&) = delete;
+
+  // The virtual clock, also what TaskRunnerBase::NowUs() of the runners
+  // returns.
+  Clock* GetClock();
+
+  // Creates runners on this controller, the thread options and priorities
+  // passed to it are ignored.
+  TaskRunnerFactory* GetTaskRunnerFactory();
+
+  // Runs the tasks that are due, including the ones they post without delay.
+  void RunReady();
+
+  // Moves the clock forward by `duration`, stopping at each timer on the way
+  // to run the tasks due then.
+  void AdvanceTime(TimeDelta duration);
+
+ private:
+  std::shared_ptr<SimulatedScheduler> scheduler_;
+  std::unique_ptr<TaskRunnerFactory> factory_;
+};
+
+}  // namespace base
+}  // namespace ave
+
+#endif /* !SIMULATED_TIME_CONTROLLER_H */
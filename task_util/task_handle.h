@@ -0,0 +1,52 @@
+/*
+ * task_handle.h
+ * Copyright (C) 2026 youfa <vsyfar@gmail.com>
+ *
+ * Distributed under terms of the GPLv2 license.
+ */
+
+#ifndef TASK_HANDLE_H
+#define TASK_HANDLE_H
+
+#include <memory>
+#include <utility>
+
+namespace ave {
+namespace base {
+
+// Returned by TaskRunnerBase::PostCancellableTask(). Dropping the handle
+// does not cancel the task. Copies refer to the same task.
+class TaskHandle {
+ public:
+  // Implemented by each runner for the tasks it queues.
+  class Delegate {
+   public:
+    virtual ~Delegate() = default;
+
+    // Returns true if the task had not started yet and will not run. The
+    // closure is destroyed before returning, unless another thread is about
+    // to pick the task up, in which case it is dropped by that thread.
+    virtual bool Cancel() = 0;
+  };
+
+  TaskHandle() = default;
+  explicit TaskHandle(std::shared_ptr<Delegate> delegate)
+      : delegate_(std::move(delegate)) {}
+
+  // Safe to call from any thread, also once the task has run or the runner
+  // is gone, both making it return false.
+  bool Cancel() {
+    std::shared_ptr<Delegate> delegate = std::move(delegate_);
+    return delegate && delegate->Cancel();
+  }
+
+  explicit operator bool() const { return delegate_ != nullptr; }
+
+ private:
+  std::shared_ptr<Delegate> delegate_;
+};
+
+}  // namespace base
+}  // namespace ave
+
+#endif /* !TASK_HANDLE_H */
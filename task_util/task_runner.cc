@@ -22,17 +22,21 @@ bool TaskRunner::IsCurrent() const {
   return impl_->IsCurrent();
 }
 
-void TaskRunner::PostTask(std::unique_ptr<base::Task> task) {
-  return impl_->PostTask(std::move(task));
+void TaskRunner::PostTask(std::unique_ptr<base::Task> task,
+                          std::source_location location) {
+  impl_->PostTaskWithOptions(InlineTask(std::move(task)),
+                             {.location = location});
 }
 
 void TaskRunner::PostTaskAndWait(std::unique_ptr<base::Task> task) {
   return impl_->PostDelayedTaskAndWait(std::move(task), 0LL, true);
 }
 
-void TaskRunner::PostDelayedTask(std::unique_ptr<base::Task> task,
-                                 uint64_t time_us) {
-  return impl_->PostDelayedTask(std::move(task), time_us);
+TaskHandle TaskRunner::PostDelayedTask(std::unique_ptr<base::Task> task,
+                                       uint64_t time_us,
+                                       std::source_location location) {
+  return impl_->PostCancellableTask(
+      InlineTask(std::move(task)), {.delay_us = time_us, .location = location});
 }
 
 void TaskRunner::PostDelayedTaskAndWait(std::unique_ptr<base::Task> task,
@@ -40,5 +44,25 @@ void TaskRunner::PostDelayedTaskAndWait(std::unique_ptr<base::Task> task,
   return impl_->PostDelayedTaskAndWait(std::move(task), time_us, true);
 }
 
+void TaskRunner::PostInlineTask(InlineTask task, uint64_t time_us) {
+  return impl_->PostInlineTask(std::move(task), time_us);
+}
+
+void TaskRunner::PostTasks(std::span<InlineTask> tasks) {
+  return impl_->PostTasks(tasks);
+}
+
+bool TaskRunner::PostTaskWithOptions(InlineTask task, PostOptions options) {
+  return impl_->PostTaskWithOptions(std::move(task), std::move(options));
+}
+
+void TaskRunner::SetQueueLimits(TaskQueueLimits limits) {
+  return impl_->SetQueueLimits(std::move(limits));
+}
+
+TaskRunnerStats TaskRunner::GetStats() const {
+  return impl_->GetStats();
+}
+
 }  // namespace base
 }  // namespace ave
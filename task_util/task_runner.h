@@ -9,8 +9,17 @@
 #define TASK_RUNNER_H
 
 #include <memory>
+#include <optional>
+#include <source_location>
+#include <span>
+#include <type_traits>
+#include <utility>
 
+#include "base/checks.h"
 #include "base/constructor_magic.h"
+#include "base/count_down_latch.h"
+#include "base/task_util/inline_task.h"
+#include "base/task_util/task_handle.h"
 #include "base/task_util/task.h"
 #include "base/task_util/task_runner_base.h"
 #include "base/task_util/to_task.h"
@@ -18,6 +27,9 @@
 
 namespace ave {
 namespace base {
+// A runner may be destroyed from any thread, including from one of its own
+// tasks, but not while another thread is still inside one of its Post*()
+// calls: posting may touch the runner after the task it queued already ran.
 class CAPABILITY("TaskRunner") TaskRunner {
  public:
   explicit TaskRunner(
@@ -27,24 +39,53 @@ class CAPABILITY("TaskRunner") TaskRunner {
   // Used for AVE_DCHECKing the current runner.
   bool IsCurrent() const;
 
-  // post a task to be run
-  void PostTask(std::unique_ptr<base::Task> task);
+  // post a task to be run. `location` is reported by TaskWatchdog if the
+  // task runs too long.
+  void PostTask(
+      std::unique_ptr<base::Task> task,
+      std::source_location location = std::source_location::current());
 
   void PostTaskAndWait(std::unique_ptr<base::Task> task);
 
-  void PostDelayedTask(std::unique_ptr<base::Task> task, uint64_t time_us);
+  // The returned handle removes the task from the runner if it has not run
+  // yet, it can be ignored.
+  TaskHandle PostDelayedTask(
+      std::unique_ptr<base::Task> task,
+      uint64_t time_us,
+      std::source_location location = std::source_location::current());
 
   void PostDelayedTaskAndWait(std::unique_ptr<base::Task> task,
                               uint64_t time_us);
 
+  // Closures of up to InlineTask::kInlineSize bytes are posted without
+  // allocating, see TaskRunnerBase::PostInlineTask().
+  void PostInlineTask(InlineTask task, uint64_t time_us);
+
+  // Posts a batch of tasks with a single wakeup, see
+  // TaskRunnerBase::PostTasks().
+  void PostTasks(std::span<InlineTask> tasks);
+
+  // Posts to a lane and with a deadline, see PostOptions. Returns false if
+  // the runner refused the task, see SetQueueLimits().
+  bool PostTaskWithOptions(InlineTask task, PostOptions options);
+
+  // See TaskRunnerBase::SetQueueLimits().
+  void SetQueueLimits(TaskQueueLimits limits);
+
+  // See TaskRunnerBase::GetStats().
+  TaskRunnerStats GetStats() const;
+
   TaskRunnerBase* Get() { return impl_; }
 
   template <class Closure,
             std::enable_if_t<
                 !std::is_convertible_v<Closure, std::unique_ptr<base::Task>>>* =
                 nullptr>
-  void PostTask(Closure&& closure) {
-    return PostTask(base::toTask(std::forward<Closure>(closure)));
+  void PostTask(
+      Closure&& closure,
+      std::source_location location = std::source_location::current()) {
+    impl_->PostTaskWithOptions(InlineTask(std::forward<Closure>(closure)),
+                               {.location = location});
   }
 
   template <class Closure,
@@ -52,16 +93,83 @@ class CAPABILITY("TaskRunner") TaskRunner {
                 !std::is_convertible_v<Closure, std::unique_ptr<base::Task>>>* =
                 nullptr>
   void PostTaskAndWait(Closure&& closure) {
-    return PostTaskAndWait(base::toTask(std::forward<Closure>(closure)));
+    Invoke(std::forward<Closure>(closure));
+  }
+
+  // Runs `closure` on this runner and returns its result, blocking the
+  // caller until then. Runs it right away when called on this runner. The
+  // closure and its result stay on the caller's stack, only a reference is
+  // posted. The result comes back as a std::optional, empty if the runner
+  // refused or dropped the task, e.g. while shutting down, and a reference
+  // result is copied. A closure returning void gives whether it ran.
+  template <class Closure>
+  auto Invoke(Closure&& closure) {
+    using Result = std::remove_cvref_t<std::invoke_result_t<Closure&>>;
+    CountDownLatch latch(1);
+    if constexpr (std::is_void_v<Result>) {
+      if (IsCurrent()) {
+        closure();
+        return true;
+      }
+      bool ran = false;
+      PostInlineTask(
+          [&closure, &ran, done = ScopedCountDown(&latch)]() {
+            closure();
+            ran = true;
+          },
+          0LL);
+      latch.Wait();
+      return ran;
+    } else {
+      std::optional<Result> result;
+      if (IsCurrent()) {
+        result.emplace(closure());
+        return result;
+      }
+      PostInlineTask(
+          [&closure, &result, done = ScopedCountDown(&latch)]() {
+            result.emplace(closure());
+          },
+          0LL);
+      latch.Wait();
+      return result;
+    }
+  }
+
+  // Runs `task` on this runner, then `reply` on `reply_runner`. A task
+  // returning a value hands it over to `reply`. `reply_runner` must outlive
+  // the task.
+  template <class Closure, class Reply>
+  void PostTaskAndReply(Closure&& task,
+                        TaskRunnerBase* reply_runner,
+                        Reply&& reply) {
+    PostTask([task = std::forward<Closure>(task), reply_runner,
+              reply = std::forward<Reply>(reply)]() mutable {
+      using Result = std::invoke_result_t<decltype(task)&>;
+      if constexpr (std::is_void_v<Result>) {
+        task();
+        reply_runner->PostInlineTask(std::move(reply), 0);
+      } else {
+        reply_runner->PostInlineTask(
+            [reply = std::move(reply), result = task()]() mutable {
+              reply(std::move(result));
+            },
+            0);
+      }
+    });
   }
 
   template <class Closure,
             std::enable_if_t<
                 !std::is_convertible_v<Closure, std::unique_ptr<base::Task>>>* =
                 nullptr>
-  void PostDelayedTask(Closure&& closure, uint64_t timeUs) {
-    return PostDelayedTask(base::toTask(std::forward<Closure>(closure)),
-                           timeUs);
+  TaskHandle PostDelayedTask(
+      Closure&& closure,
+      uint64_t timeUs,
+      std::source_location location = std::source_location::current()) {
+    return impl_->PostCancellableTask(
+        InlineTask(std::forward<Closure>(closure)),
+        {.delay_us = timeUs, .location = location});
   }
 
   template <class Closure,
@@ -9,7 +9,15 @@
 
 #include <pthread.h>
 
+#include <bit>
+#include <chrono>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <utility>
+
 #include "base/checks.h"
+#include "base/logging.h"
 
 namespace ave {
 namespace base {
@@ -21,18 +29,128 @@ void InitializeTls() {
   AVE_CHECK(pthread_key_create(&g_queue_ptr_tls, nullptr) == 0);
 }
 
+uint64_t GetNowUs() {
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
 pthread_key_t GetQueuePtrTls() {
   static pthread_once_t init_once = PTHREAD_ONCE_INIT;
   AVE_CHECK(pthread_once(&init_once, &InitializeTls) == 0);
   return g_queue_ptr_tls;
 }
 
+// Holds the closure outside the runner, whichever of Cancel() and Run()
+// comes first takes it.
+class ForwardingTaskDelegate final : public TaskHandle::Delegate {
+ public:
+  explicit ForwardingTaskDelegate(InlineTask task) : task_(std::move(task)) {}
+
+  bool Cancel() override {
+    InlineTask task = Take();
+    return static_cast<bool>(task);
+  }
+
+  void Run() {
+    if (InlineTask task = Take()) {
+      std::move(task).Run();
+    }
+  }
+
+ private:
+  InlineTask Take() {
+    std::scoped_lock guard(mutex_);
+    return std::move(task_);
+  }
+
+  std::mutex mutex_;
+  InlineTask task_;
+};
+
 }  // namespace
 
 TaskRunnerBase* TaskRunnerBase::Current() {
   return static_cast<TaskRunnerBase*>(pthread_getspecific(GetQueuePtrTls()));
 }
 
+void TaskRunnerBase::PostInlineTask(InlineTask task, uint64_t delay_us) {
+  if (delay_us == 0) {
+    PostTask(std::move(task).ToTask());
+  } else {
+    PostDelayedTask(std::move(task).ToTask(), delay_us);
+  }
+}
+
+TaskHandle TaskRunnerBase::PostCancellableTask(InlineTask task,
+                                               PostOptions options) {
+  auto delegate = std::make_shared<ForwardingTaskDelegate>(std::move(task));
+  PostTaskWithOptions([delegate]() { delegate->Run(); }, std::move(options));
+  return TaskHandle(std::move(delegate));
+}
+
+void TaskRunnerBase::PostTasks(std::span<InlineTask> tasks) {
+  for (InlineTask& task : tasks) {
+    PostInlineTask(std::move(task), 0LL);
+  }
+}
+
+bool TaskRunnerBase::PostTaskWithOptions(InlineTask task,
+                                         PostOptions options) {
+  if (options.deadline_us == 0) {
+    PostInlineTask(std::move(task), options.delay_us);
+    return true;
+  }
+
+  uint64_t deadline_us = NowUs() + options.deadline_us;
+  PostInlineTask(
+      [this, task = std::move(task), on_late = std::move(options.on_late),
+       deadline_us]() mutable {
+        if (NowUs() > deadline_us) {
+          if (on_late) {
+            std::move(on_late).Run();
+          }
+          return;
+        }
+        std::move(task).Run();
+      },
+      options.delay_us);
+  return true;
+}
+
+void TaskRunnerBase::SetQueueLimits(TaskQueueLimits limits) {
+  if (limits.capacity > 0 || limits.high_watermark > 0) {
+    AVE_LOG(LS_WARNING) << "Queue limits are not supported by this runner, "
+                           "its queue stays unbounded";
+  }
+}
+
+TaskRunnerStats TaskRunnerBase::GetStats() const {
+  return {};
+}
+
+uint64_t TaskRunnerBase::NowUs() const {
+  return GetNowUs();
+}
+
+uint64_t TaskRunnerBase::DueTimeUs(uint64_t now_us,
+                                   uint64_t delay_us,
+                                   uint64_t slack_us) {
+  constexpr uint64_t kNever = std::numeric_limits<uint64_t>::max();
+  if (delay_us > kNever - now_us) {
+    return kNever;
+  }
+  uint64_t due_us = now_us + delay_us;
+  if (slack_us == 0) {
+    return due_us;
+  }
+  uint64_t grid_us = std::bit_floor(slack_us);
+  if (due_us > kNever - (grid_us - 1)) {
+    return kNever;
+  }
+  return (due_us + grid_us - 1) & ~(grid_us - 1);
+}
+
 TaskRunnerBase::CurrentTaskRunnerSetter::CurrentTaskRunnerSetter(
     TaskRunnerBase* task_runner)
     : previous_(TaskRunnerBase::Current()) {
@@ -8,12 +8,80 @@
 #ifndef TASK_RUNNER_BASE_H
 #define TASK_RUNNER_BASE_H
 
+#include <cstddef>
+#include <cstdint>
+#include <functional>
 #include <memory>
+#include <source_location>
+#include <span>
 
+#include "inline_task.h"
+#include "task_handle.h"
 #include "task.h"
+#include "task_runner_stats.h"
 
 namespace ave {
 namespace base {
+
+// Lanes of one runner, a ready task of a lane runs before any queued task of
+// the lanes after it.
+enum class TaskLane : uint8_t {
+  kUrgent,
+  kNormal,
+  kBackground,
+};
+constexpr size_t kTaskLaneCount = 3;
+
+struct PostOptions {
+  TaskLane lane = TaskLane::kNormal;
+  uint64_t delay_us = 0;
+  // The task may run up to this much later than `delay_us` so that timers of
+  // one runner share wakeups: its due time is rounded up to a multiple of the
+  // largest power of two not above the slack, on the runner's monotonic clock.
+  uint64_t slack_us = 0;
+  // Relative to the post like `delay_us`, 0 for none. A task that has not
+  // started by then is dropped, counted in TaskRunnerStats::late_tasks, and
+  // `on_late` runs in its place.
+  uint64_t deadline_us = 0;
+  InlineTask on_late;
+  // A runner full under QueueFullPolicy::kDropOldest may drop this task to
+  // make room for a newer one.
+  bool droppable = false;
+  // Where the task was posted from, reported by TaskWatchdog.
+  std::source_location location = std::source_location::current();
+};
+
+// What a post does when the runner already holds TaskQueueLimits::capacity
+// tasks ready to run.
+enum class QueueFullPolicy : uint8_t {
+  // Waits until the runner catches up. Posts from the runner's own thread
+  // are let through instead, they would wait forever.
+  kBlock,
+  // Fails the post, PostTaskWithOptions() returns false.
+  kReject,
+  // Drops the oldest queued droppable task, see PostOptions::droppable, or
+  // fails the post if there is none.
+  kDropOldest,
+};
+
+// Bounds the ready tasks of a runner. Delayed tasks count once they are due
+// and are never refused then. Rejected and dropped tasks are counted in
+// TaskRunnerStats::overflow_tasks.
+struct TaskQueueLimits {
+  // 0 for unbounded.
+  size_t capacity = 0;
+  QueueFullPolicy policy = QueueFullPolicy::kBlock;
+  // `on_high` runs once the depth reaches `high_watermark`, on the posting
+  // thread, or the runner thread when delayed tasks fall due. `on_low` runs
+  // once it is back down to `low_watermark`, on the runner thread. So
+  // producers can throttle themselves before the queue is full. Neither may
+  // post to the runner. 0 disables them.
+  size_t high_watermark = 0;
+  size_t low_watermark = 0;
+  std::function<void()> on_high;
+  std::function<void()> on_low;
+};
+
 class TaskRunnerBase {
  public:
   virtual void Destruct() = 0;
@@ -29,6 +97,40 @@ class TaskRunnerBase {
                                       uint64_t time_us,
                                       bool wait) = 0;
 
+  // Posts a closure held in InlineTask storage, so small closures cost no
+  // allocation on runners that override this. The default wraps it in a
+  // heap allocated Task and calls PostTask() or PostDelayedTask().
+  virtual void PostInlineTask(InlineTask task, uint64_t delay_us);
+
+  // Like PostTaskWithOptions(), and the returned handle cancels the task.
+  // Runners that override this remove the queued entry right away. The
+  // default keeps a small forwarding task queued but still destroys the
+  // closure on Cancel().
+  virtual TaskHandle PostCancellableTask(InlineTask task, PostOptions options);
+
+  // Posts `tasks` in order, moving them out of the span. Runners that
+  // override this queue the whole batch in one step and wake up at most
+  // once, the default posts them one by one.
+  virtual void PostTasks(std::span<InlineTask> tasks);
+
+  // Posts `task` to a lane, with a deadline or some slack. The default
+  // ignores the lane and the slack and checks the deadline in a wrapping
+  // task, without counting late tasks. Returns false if the task was
+  // refused, see TaskQueueLimits.
+  virtual bool PostTaskWithOptions(InlineTask task, PostOptions options);
+
+  // Call before other threads post. Runners that override this bound their
+  // ready tasks, the default logs a warning and ignores the limits.
+  virtual void SetQueueLimits(TaskQueueLimits limits);
+
+  // Queue depth, queueing delay and run time of the tasks run so far. Empty
+  // unless built with AVE_TASK_RUNNER_STATS, see TaskRunnerStatsRecorder.
+  virtual TaskRunnerStats GetStats() const;
+
+  // Monotonic time in microseconds that delays and deadlines of this runner
+  // count from. Simulated runners return their virtual time.
+  virtual uint64_t NowUs() const;
+
   // virtual bool postTaskAndReplay(const Task& task, const Task& reply);
 
   static TaskRunnerBase* Current();
@@ -47,6 +149,11 @@ class TaskRunnerBase {
   };
 
   virtual ~TaskRunnerBase() = default;
+
+  // Due time of a task posted at `now_us`, see PostOptions::slack_us.
+  static uint64_t DueTimeUs(uint64_t now_us,
+                            uint64_t delay_us,
+                            uint64_t slack_us);
 };
 
 struct TaskRunnerDeleter {
@@ -0,0 +1,69 @@
+/*
+ * task_runner_benchmark.cc
+ * Copyright (C) 2026 youfa <vsyfar@gmail.com>
+ *
+ * Distributed under terms of the GPLv2 license.
+ */
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include "base/task_util/default_task_runner_factory.h"
+#include "base/task_util/inline_task.h"
+#include "base/task_util/task_runner.h"
+#include "benchmark/benchmark.h"
+
+namespace ave {
+namespace base {
+namespace {
+
+std::unique_ptr<TaskRunner> CreateRunner(const char* name) {
+  static std::unique_ptr<TaskRunnerFactory> factory =
+      CreateDefaultTaskRunnerFactory();
+  return std::make_unique<TaskRunner>(
+      factory->CreateTaskRunner(name, TaskRunnerFactory::Priority::NORMAL));
+}
+
+// Fans out `state.range(0)` small tasks with one PostTask() each.
+void BM_PostTaskFanOut(benchmark::State& state) {
+  auto runner = CreateRunner("PostTaskFanOut");
+  const int64_t count = state.range(0);
+  std::atomic<int64_t> done{0};
+
+  for (auto _ : state) {
+    for (int64_t i = 0; i < count; ++i) {
+      runner->PostTask([&done]() { done.fetch_add(1); });
+    }
+    runner->PostTaskAndWait([]() {});
+  }
+  state.SetItemsProcessed(state.iterations() * count);
+}
+
+// Same fan out through a single PostTasks() call.
+void BM_PostTasksFanOut(benchmark::State& state) {
+  auto runner = CreateRunner("PostTasksFanOut");
+  const int64_t count = state.range(0);
+  std::atomic<int64_t> done{0};
+  std::vector<InlineTask> batch;
+  batch.reserve(count);
+
+  for (auto _ : state) {
+    batch.clear();
+    for (int64_t i = 0; i < count; ++i) {
+      batch.emplace_back([&done]() { done.fetch_add(1); });
+    }
+    runner->PostTasks(batch);
+    runner->PostTaskAndWait([]() {});
+  }
+  state.SetItemsProcessed(state.iterations() * count);
+}
+
+BENCHMARK(BM_PostTaskFanOut)->RangeMultiplier(4)->Range(4, 256)->UseRealTime();
+BENCHMARK(BM_PostTasksFanOut)->RangeMultiplier(4)->Range(4, 256)->UseRealTime();
+
+}  // namespace
+}  // namespace base
+}  // namespace ave
+
+BENCHMARK_MAIN();
@@ -11,6 +11,7 @@
 #include <memory>
 
 #include "base/task_util/task_runner_base.h"
+#include "base/thread.h"
 
 namespace ave {
 namespace base {
@@ -24,6 +25,22 @@ class TaskRunnerFactory {
   virtual std::unique_ptr<TaskRunnerBase, TaskRunnerDeleter> CreateTaskRunner(
       const char* name,
       Priority priority) const = 0;
+
+  // Creates a runner whose thread is placed and scheduled by `options`.
+  // Factories without threads of their own map the nice value in `options`
+  // to a Priority and ignore the rest.
+  virtual std::unique_ptr<TaskRunnerBase, TaskRunnerDeleter> CreateTaskRunner(
+      const char* name,
+      const ThreadOptions& options) const {
+    Priority priority = Priority::NORMAL;
+    if (options.policy != ThreadOptions::SchedPolicy::kNormal ||
+        options.priority < AVE_PRIORITY_NORMAL) {
+      priority = Priority::HIGH;
+    } else if (options.priority > AVE_PRIORITY_NORMAL) {
+      priority = Priority::LOW;
+    }
+    return CreateTaskRunner(name, priority);
+  }
 };
 
 }  // namespace base
@@ -0,0 +1,709 @@
+/*
+ * task_runner_pool.cc
+ * Copyright (C) 2026 youfa <vsyfar@gmail.com>
+ *
+ * Distributed under terms of the GPLv2 license.
+ */
+
+#include "task_runner_pool.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <source_location>
+#include <span>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "base/constructor_magic.h"
+#include "base/count_down_latch.h"
+#include "base/task_util/inline_task.h"
+#include "base/task_util/task_runner_factory.h"
+#include "base/task_util/task_runner_stats.h"
+#include "base/task_util/task_watchdog.h"
+#include "base/thread.h"
+#include "base/thread_defs.h"
+
+namespace ave {
+namespace base {
+namespace {
+
+// A runner hands its worker back after this many tasks, so one busy runner
+// can not starve the other runners queued on the same worker.
+constexpr int kMaxTasksPerSlice = 32;
+
+uint64_t GetNowUs() {
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+class PoolCore;
+class PooledTaskRunner;
+
+thread_local PoolCore* t_current_pool = nullptr;
+thread_local size_t t_worker_index = 0;
+
+struct TaskEntry {
+  InlineTask task_;
+  // Releases a waiting poster once the entry is done with, run or not.
+  ScopedCountDown done_;
+  TaskLane lane_{TaskLane::kNormal};
+  // Dropped instead of run once this has passed, 0 for none.
+  uint64_t deadline_us_{0};
+  std::unique_ptr<InlineTask> on_late_;
+  std::source_location location_;
+#if defined(AVE_TASK_RUNNER_STATS)
+  uint64_t ready_us_{0};
+#endif
+};
+
+struct DelayedEntry {
+  uint64_t when_us_{};
+  uint64_t order_{};
+  // Keeps the runner alive while the entry sits in the timer heap.
+  std::shared_ptr<PooledTaskRunner> runner_;
+  TaskEntry entry_;
+};
+
+struct DelayedOrder {
+  bool operator()(const DelayedEntry& first,
+                  const DelayedEntry& second) const {
+    if (first.when_us_ != second.when_us_) {
+      return first.when_us_ > second.when_us_;
+    }
+    return first.order_ > second.order_;
+  }
+};
+
+// State shared by the pool owner and its threads. The threads hold a
+// reference of their own, so a pool released from one of its workers stays
+// valid until that worker leaves its loop.
+class PoolCore {
+ public:
+  explicit PoolCore(size_t num_workers);
+
+  size_t num_workers() const { return queues_.size(); }
+
+  // Returns true if called from the pool thread with the given index, the
+  // timer thread has index num_workers().
+  bool RunsOn(size_t index) const {
+    return t_current_pool == this && t_worker_index == index;
+  }
+
+  // Queues a runner that just became runnable. Workers of this pool push to
+  // their own deque, other threads spread runners round robin.
+  void Schedule(PooledTaskRunner* runner);
+
+  // Takes a queued runner back out of the deques. Returns false if no deque
+  // holds it, i.e. a worker already picked it up.
+  bool Unschedule(PooledTaskRunner* runner);
+
+  void PostDelayed(DelayedEntry entry);
+
+  // Drops the pending delayed tasks of `runner`.
+  void CancelDelayed(const PooledTaskRunner* runner);
+
+  void Quit();
+
+  void WorkerLoop(size_t index);
+  void TimerLoop();
+
+ private:
+  struct alignas(64) WorkerQueue {
+    std::mutex mutex_;
+    std::deque<PooledTaskRunner*> runners_;
+  };
+
+  // Pops from the front of the worker's own deque, or steals from the back
+  // of another one.
+  PooledTaskRunner* Pop(size_t index);
+
+  std::vector<WorkerQueue> queues_;
+  std::atomic<size_t> next_queue_;
+  std::atomic<size_t> queued_runners_;
+  std::atomic<int> idle_workers_;
+
+  std::mutex idle_mutex_;
+  std::condition_variable idle_condition_;
+  bool need_quit_;
+
+  std::mutex timer_mutex_;
+  std::condition_variable timer_condition_;
+  std::vector<DelayedEntry> delayed_queue_;
+  uint64_t delayed_order_id_;
+  bool timer_quit_;
+
+  AVE_DISALLOW_COPY_AND_ASSIGN(PoolCore);
+};
+
+// Owns the pool threads, destroyed once the factory and all its runners are.
+class WorkerPool {
+ public:
+  WorkerPool(size_t num_workers, const ThreadOptions& worker_options);
+  ~WorkerPool();
+
+  PoolCore* core() const { return core_.get(); }
+
+ private:
+  std::shared_ptr<PoolCore> core_;
+  std::vector<std::unique_ptr<Thread>> threads_;
+
+  AVE_DISALLOW_COPY_AND_ASSIGN(WorkerPool);
+};
+
+class PooledTaskRunner final : public TaskRunnerBase {
+ public:
+  static PooledTaskRunner* Create(const char* name,
+                                  std::shared_ptr<WorkerPool> pool);
+
+  PooledTaskRunner(const char* name, std::shared_ptr<WorkerPool> pool);
+  ~PooledTaskRunner() override = default;
+
+  void Destruct() override;
+  void PostTask(std::unique_ptr<Task> task) override;
+  void PostDelayedTask(std::unique_ptr<Task> task, uint64_t delay_us) override;
+  void PostDelayedTaskAndWait(std::unique_ptr<Task> task,
+                              uint64_t delay_us,
+                              bool wait) override;
+  void PostInlineTask(InlineTask task, uint64_t delay_us) override;
+  void PostTasks(std::span<InlineTask> tasks) override;
+  bool PostTaskWithOptions(InlineTask task, PostOptions options) override;
+  TaskRunnerStats GetStats() const override;
+
+  // Appends a task and schedules the runner if it was idle. Returns false and
+  // leaves `entry` untouched once the runner is quitting.
+  bool Enqueue(TaskEntry& entry);
+
+  // Runs up to kMaxTasksPerSlice tasks on the calling worker. Returns true if
+  // tasks are left and the runner must be scheduled again.
+  bool RunSlice();
+
+ private:
+  // Returns false if the runner is quitting and dropped `entry`.
+  bool Post(TaskEntry entry, uint64_t delay_us, uint64_t slack_us = 0);
+  // Called with `mutex_` held.
+  bool HasQueuedTasks() const;
+  // Returns true and runs the late callback of `entry` if it missed its
+  // deadline.
+  bool DropIfLate(TaskEntry& entry);
+
+  std::string name_;
+  std::shared_ptr<WorkerPool> pool_;
+  PoolCore* const core_;
+  // Released by Destruct(), delayed entries still in the timer heap keep the
+  // object alive until they are dropped.
+  std::shared_ptr<PooledTaskRunner> self_;
+
+  std::mutex mutex_;
+  std::condition_variable idle_condition_;
+  // One per TaskLane.
+  std::array<std::deque<TaskEntry>, kTaskLaneCount> task_queues_;
+  // True while the runner sits on a worker deque or runs on a worker.
+  bool scheduled_;
+  bool running_;
+  bool need_quit_;
+  bool release_when_idle_;
+
+  TaskRunnerStatsRecorder stats_;
+  const std::shared_ptr<TaskWatchdogSlot> watchdog_;
+
+  AVE_DISALLOW_COPY_AND_ASSIGN(PooledTaskRunner);
+};
+
+PoolCore::PoolCore(size_t num_workers)
+    : queues_(num_workers),
+      next_queue_(0),
+      queued_runners_(0),
+      idle_workers_(0),
+      need_quit_(false),
+      delayed_order_id_(0),
+      timer_quit_(false) {}
+
+void PoolCore::Schedule(PooledTaskRunner* runner) {
+  size_t index = 0;
+  if (t_current_pool == this && t_worker_index < queues_.size()) {
+    index = t_worker_index;
+  } else {
+    index = next_queue_.fetch_add(1, std::memory_order_relaxed) %
+            queues_.size();
+  }
+
+  // Count before publishing, an idle worker that sees the count but not yet
+  // the runner simply retries.
+  queued_runners_.fetch_add(1);
+  {
+    std::scoped_lock guard(queues_[index].mutex_);
+    queues_[index].runners_.push_back(runner);
+  }
+
+  if (idle_workers_.load() > 0) {
+    std::scoped_lock guard(idle_mutex_);
+    idle_condition_.notify_one();
+  }
+}
+
+bool PoolCore::Unschedule(PooledTaskRunner* runner) {
+  for (auto& queue : queues_) {
+    std::scoped_lock guard(queue.mutex_);
+    auto it = std::find(queue.runners_.begin(), queue.runners_.end(), runner);
+    if (it != queue.runners_.end()) {
+      queue.runners_.erase(it);
+      queued_runners_.fetch_sub(1);
+      return true;
+    }
+  }
+  return false;
+}
+
+PooledTaskRunner* PoolCore::Pop(size_t index) {
+  {
+    WorkerQueue& own = queues_[index];
+    std::scoped_lock guard(own.mutex_);
+    if (!own.runners_.empty()) {
+      PooledTaskRunner* runner = own.runners_.front();
+      own.runners_.pop_front();
+      queued_runners_.fetch_sub(1);
+      return runner;
+    }
+  }
+
+  for (size_t i = 1; i < queues_.size(); ++i) {
+    WorkerQueue& victim = queues_[(index + i) % queues_.size()];
+    std::scoped_lock guard(victim.mutex_);
+    if (!victim.runners_.empty()) {
+      PooledTaskRunner* runner = victim.runners_.back();
+      victim.runners_.pop_back();
+      queued_runners_.fetch_sub(1);
+      return runner;
+    }
+  }
+  return nullptr;
+}
+
+void PoolCore::PostDelayed(DelayedEntry entry) {
+  bool wake_timer = false;
+  {
+    std::scoped_lock guard(timer_mutex_);
+    entry.order_ = delayed_order_id_++;
+    wake_timer = delayed_queue_.empty() ||
+                 entry.when_us_ < delayed_queue_.front().when_us_;
+    delayed_queue_.push_back(std::move(entry));
+    std::push_heap(delayed_queue_.begin(), delayed_queue_.end(),
+                   DelayedOrder());
+  }
+  if (wake_timer) {
+    timer_condition_.notify_one();
+  }
+}
+
+void PoolCore::CancelDelayed(const PooledTaskRunner* runner) {
+  std::vector<DelayedEntry> cancelled;
+  {
+    std::scoped_lock guard(timer_mutex_);
+    auto it = std::stable_partition(
+        delayed_queue_.begin(), delayed_queue_.end(),
+        [runner](const DelayedEntry& e) { return e.runner_.get() != runner; });
+    std::move(it, delayed_queue_.end(), std::back_inserter(cancelled));
+    delayed_queue_.erase(it, delayed_queue_.end());
+    std::make_heap(delayed_queue_.begin(), delayed_queue_.end(),
+                   DelayedOrder());
+  }
+  // The tasks and the runner references are released outside the lock.
+}
+
+void PoolCore::Quit() {
+  {
+    std::scoped_lock guard(idle_mutex_);
+    need_quit_ = true;
+  }
+  idle_condition_.notify_all();
+  {
+    std::scoped_lock guard(timer_mutex_);
+    timer_quit_ = true;
+  }
+  timer_condition_.notify_one();
+}
+
+void PoolCore::WorkerLoop(size_t index) {
+  t_current_pool = this;
+  t_worker_index = index;
+
+  while (true) {
+    PooledTaskRunner* runner = Pop(index);
+    if (runner) {
+      if (runner->RunSlice()) {
+        Schedule(runner);
+      }
+      continue;
+    }
+
+    std::unique_lock<std::mutex> l(idle_mutex_);
+    idle_workers_.fetch_add(1);
+    idle_condition_.wait(
+        l, [this] { return need_quit_ || queued_runners_.load() > 0; });
+    idle_workers_.fetch_sub(1);
+    if (need_quit_) {
+      break;
+    }
+  }
+
+  t_current_pool = nullptr;
+}
+
+void PoolCore::TimerLoop() {
+  t_current_pool = this;
+  t_worker_index = queues_.size();
+
+  std::unique_lock<std::mutex> l(timer_mutex_);
+  while (!timer_quit_) {
+    if (delayed_queue_.empty()) {
+      timer_condition_.wait(l);
+      continue;
+    }
+
+    uint64_t now_us = GetNowUs();
+    uint64_t when_us = delayed_queue_.front().when_us_;
+    if (when_us > now_us) {
+      timer_condition_.wait_for(l, std::chrono::microseconds(when_us - now_us));
+      continue;
+    }
+
+    std::vector<DelayedEntry> fired;
+    while (!delayed_queue_.empty() &&
+           delayed_queue_.front().when_us_ <= now_us) {
+      std::pop_heap(delayed_queue_.begin(), delayed_queue_.end(),
+                    DelayedOrder());
+      fired.push_back(std::move(delayed_queue_.back()));
+      delayed_queue_.pop_back();
+    }
+
+    // Enqueue without the timer lock, task and runner destructors may post
+    // new delayed tasks.
+    l.unlock();
+    for (auto& delayed : fired) {
+      delayed.runner_->Enqueue(delayed.entry_);
+    }
+    fired.clear();
+    l.lock();
+  }
+
+  t_current_pool = nullptr;
+}
+
+WorkerPool::WorkerPool(size_t num_workers, const ThreadOptions& worker_options)
+    : core_(std::make_shared<PoolCore>(num_workers)) {
+  for (size_t i = 0; i < num_workers; ++i) {
+    threads_.push_back(std::make_unique<Thread>(
+        [core = core_, i] { core->WorkerLoop(i); },
+        "pool_worker_" + std::to_string(i), worker_options,
+        true /* joinable */));
+  }
+  threads_.push_back(std::make_unique<Thread>(
+      [core = core_] { core->TimerLoop(); }, "pool_timer", AVE_PRIORITY_NORMAL,
+      true /* joinable */));
+
+  for (auto& thread : threads_) {
+    thread->start(false);
+  }
+}
+
+WorkerPool::~WorkerPool() {
+  core_->Quit();
+  for (size_t i = 0; i < threads_.size(); ++i) {
+    // The last reference may be dropped on a pool thread, that thread is
+    // detached by ~Thread() and exits on its own.
+    if (!core_->RunsOn(i)) {
+      threads_[i]->join();
+    }
+  }
+}
+
+// static
+PooledTaskRunner* PooledTaskRunner::Create(const char* name,
+                                           std::shared_ptr<WorkerPool> pool) {
+  auto runner = std::make_shared<PooledTaskRunner>(name, std::move(pool));
+  runner->self_ = runner;
+  return runner.get();
+}
+
+PooledTaskRunner::PooledTaskRunner(const char* name,
+                                   std::shared_ptr<WorkerPool> pool)
+    : name_(name),
+      pool_(std::move(pool)),
+      core_(pool_->core()),
+      scheduled_(false),
+      running_(false),
+      need_quit_(false),
+      release_when_idle_(false),
+      stats_(name_),
+      watchdog_(TaskWatchdog::Register(name_)) {}
+
+void PooledTaskRunner::Destruct() {
+  std::array<std::deque<TaskEntry>, kTaskLaneCount> dropped;
+  bool unschedule = false;
+  {
+    std::scoped_lock guard(mutex_);
+    need_quit_ = true;
+    dropped.swap(task_queues_);
+    unschedule = scheduled_ && !running_;
+  }
+  core_->CancelDelayed(this);
+  for (std::deque<TaskEntry>& queue : dropped) {
+    stats_.OnDropped(queue.size());
+    queue.clear();
+  }
+
+  if (IsCurrent()) {
+    // Called from one of our own tasks, RunSlice() lets go once it returns.
+    std::scoped_lock guard(mutex_);
+    release_when_idle_ = true;
+    return;
+  }
+
+  if (unschedule && core_->Unschedule(this)) {
+    std::scoped_lock guard(mutex_);
+    scheduled_ = false;
+  }
+
+  std::shared_ptr<PooledTaskRunner> self;
+  {
+    std::unique_lock<std::mutex> l(mutex_);
+    idle_condition_.wait(l, [this] { return !scheduled_; });
+    self = std::move(self_);
+  }
+}
+
+void PooledTaskRunner::PostTask(std::unique_ptr<Task> task) {
+  PostDelayedTaskAndWait(std::move(task), 0LL, false);
+}
+
+void PooledTaskRunner::PostDelayedTask(std::unique_ptr<Task> task,
+                                       uint64_t delay_us) {
+  PostDelayedTaskAndWait(std::move(task), delay_us, false);
+}
+
+void PooledTaskRunner::PostDelayedTaskAndWait(std::unique_ptr<Task> task,
+                                              uint64_t delay_us,
+                                              bool wait) {
+  CountDownLatch done(1);
+  TaskEntry entry;
+  entry.task_ = InlineTask(std::move(task));
+  if (wait) {
+    entry.done_.reset(&done);
+  }
+  if (Post(std::move(entry), delay_us) && wait) {
+    done.Wait();
+  }
+}
+
+void PooledTaskRunner::PostInlineTask(InlineTask task, uint64_t delay_us) {
+  TaskEntry entry;
+  entry.task_ = std::move(task);
+  Post(std::move(entry), delay_us);
+}
+
+bool PooledTaskRunner::PostTaskWithOptions(InlineTask task,
+                                           PostOptions options) {
+  TaskEntry entry;
+  entry.task_ = std::move(task);
+  entry.lane_ = options.lane;
+  entry.location_ = options.location;
+  if (options.deadline_us > 0) {
+    entry.deadline_us_ = GetNowUs() + options.deadline_us;
+    if (options.on_late) {
+      entry.on_late_ = std::make_unique<InlineTask>(std::move(options.on_late));
+    }
+  }
+  return Post(std::move(entry), options.delay_us, options.slack_us);
+}
+
+bool PooledTaskRunner::Post(TaskEntry entry,
+                            uint64_t delay_us,
+                            uint64_t slack_us) {
+#if defined(AVE_TASK_RUNNER_STATS)
+  entry.ready_us_ = GetNowUs();
+#endif
+
+  if (delay_us > 0) {
+    DelayedEntry delayed;
+    {
+      std::scoped_lock guard(mutex_);
+      if (need_quit_) {
+        return false;
+      }
+      delayed.runner_ = self_;
+    }
+    delayed.when_us_ = DueTimeUs(GetNowUs(), delay_us, slack_us);
+#if defined(AVE_TASK_RUNNER_STATS)
+    entry.ready_us_ = delayed.when_us_;
+#endif
+    delayed.entry_ = std::move(entry);
+    core_->PostDelayed(std::move(delayed));
+    return true;
+  }
+  return Enqueue(entry);
+}
+
+void PooledTaskRunner::PostTasks(std::span<InlineTask> tasks) {
+  bool schedule = false;
+  {
+    std::scoped_lock guard(mutex_);
+    if (need_quit_ || tasks.empty()) {
+      return;
+    }
+#if defined(AVE_TASK_RUNNER_STATS)
+    uint64_t now_us = GetNowUs();
+#endif
+    std::deque<TaskEntry>& queue =
+        task_queues_[static_cast<size_t>(TaskLane::kNormal)];
+    for (InlineTask& task : tasks) {
+      TaskEntry& entry = queue.emplace_back();
+      entry.task_ = std::move(task);
+#if defined(AVE_TASK_RUNNER_STATS)
+      entry.ready_us_ = now_us;
+#endif
+    }
+    stats_.OnQueued(tasks.size());
+    schedule = !scheduled_;
+    scheduled_ = true;
+  }
+  if (schedule) {
+    core_->Schedule(this);
+  }
+}
+
+bool PooledTaskRunner::Enqueue(TaskEntry& entry) {
+  bool schedule = false;
+  {
+    std::scoped_lock guard(mutex_);
+    if (need_quit_) {
+      return false;
+    }
+    task_queues_[static_cast<size_t>(entry.lane_)].push_back(
+        std::move(entry));
+    stats_.OnQueued(1);
+    schedule = !scheduled_;
+    scheduled_ = true;
+  }
+  if (schedule) {
+    core_->Schedule(this);
+  }
+  return true;
+}
+
+bool PooledTaskRunner::RunSlice() {
+  {
+    std::scoped_lock guard(mutex_);
+    running_ = true;
+  }
+
+  {
+    CurrentTaskRunnerSetter set_current(this);
+    for (int i = 0; i < kMaxTasksPerSlice; ++i) {
+      TaskEntry entry;
+      {
+        std::scoped_lock guard(mutex_);
+        if (need_quit_ || !HasQueuedTasks()) {
+          break;
+        }
+        // The most urgent lane holding a task.
+        auto queue = std::find_if(
+            task_queues_.begin(), task_queues_.end(),
+            [](const std::deque<TaskEntry>& lane) { return !lane.empty(); });
+        entry = std::move(queue->front());
+        queue->pop_front();
+      }
+
+      if (entry.deadline_us_ > 0 && DropIfLate(entry)) {
+        continue;
+      }
+      // The runner is on one worker at a time, so one slot covers it.
+      watchdog_->OnTaskStart(entry.location_);
+#if defined(AVE_TASK_RUNNER_STATS)
+      uint64_t start_us = GetNowUs();
+      std::move(entry.task_).Run();
+      stats_.OnRun(entry.ready_us_, start_us, GetNowUs());
+#else
+      std::move(entry.task_).Run();
+#endif
+      watchdog_->OnTaskEnd();
+    }
+  }
+
+  // Destroyed after the lock is released if Destruct() was called from one
+  // of our own tasks.
+  std::shared_ptr<PooledTaskRunner> self;
+  std::scoped_lock guard(mutex_);
+  running_ = false;
+  if (!need_quit_ && HasQueuedTasks()) {
+    return true;
+  }
+  scheduled_ = false;
+  if (release_when_idle_) {
+    self = std::move(self_);
+  } else {
+    idle_condition_.notify_all();
+  }
+  return false;
+}
+
+TaskRunnerStats PooledTaskRunner::GetStats() const {
+  return stats_.Get();
+}
+
+bool PooledTaskRunner::HasQueuedTasks() const {
+  return std::any_of(
+      task_queues_.begin(), task_queues_.end(),
+      [](const std::deque<TaskEntry>& queue) { return !queue.empty(); });
+}
+
+bool PooledTaskRunner::DropIfLate(TaskEntry& entry) {
+  if (GetNowUs() <= entry.deadline_us_) {
+    return false;
+  }
+  stats_.OnLate();
+  if (entry.on_late_) {
+    std::move(*entry.on_late_).Run();
+  }
+  return true;
+}
+
+class TaskRunnerPoolFactory final : public TaskRunnerFactory {
+ public:
+  TaskRunnerPoolFactory(size_t num_workers, const ThreadOptions& worker_options)
+      : pool_(std::make_shared<WorkerPool>(num_workers, worker_options)) {}
+
+  using TaskRunnerFactory::CreateTaskRunner;
+
+  std::unique_ptr<TaskRunnerBase, TaskRunnerDeleter> CreateTaskRunner(
+      const char* name,
+      Priority priority [[maybe_unused]]) const override {
+    return std::unique_ptr<TaskRunnerBase, TaskRunnerDeleter>(
+        PooledTaskRunner::Create(name, pool_));
+  }
+
+ private:
+  std::shared_ptr<WorkerPool> pool_;
+};
+
+}  // namespace
+
+std::unique_ptr<TaskRunnerFactory> CreateTaskRunnerPoolFactory(
+    size_t num_workers,
+    const ThreadOptions& worker_options) {
+  if (num_workers == 0) {
+    num_workers = std::max(1U, std::thread::hardware_concurrency());
+  }
+  return std::make_unique<TaskRunnerPoolFactory>(num_workers, worker_options);
+}
+
+}  // namespace base
+}  // namespace ave
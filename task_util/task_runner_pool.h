@@ -0,0 +1,39 @@
+/*
+ * task_runner_pool.h
+ * Copyright (C) 2026 youfa <vsyfar@gmail.com>
+ *
+ * Distributed under terms of the GPLv2 license.
+ */
+
+#ifndef TASK_RUNNER_POOL_H
+#define TASK_RUNNER_POOL_H
+
+#include <cstddef>
+#include <memory>
+
+#include "base/task_util/task_runner_factory.h"
+
+namespace ave {
+namespace base {
+
+// Creates a factory whose task runners share a fixed pool of worker threads
+// instead of owning one thread each. Every worker keeps its own deque of
+// runnable task runners and steals from the others when it runs dry.
+//
+// Each runner still runs its tasks one at a time and in posting order, and
+// TaskRunnerBase::Current() returns the runner while one of its tasks runs.
+// A task that blocks holds its worker, so keep blocking work off pooled
+// runners or size the pool accordingly.
+//
+// `num_workers` == 0 uses std::thread::hardware_concurrency(). The pool lives
+// until the factory and every runner created from it are gone. The workers
+// run with `worker_options`, the priority or thread options passed to
+// CreateTaskRunner() are ignored.
+std::unique_ptr<TaskRunnerFactory> CreateTaskRunnerPoolFactory(
+    size_t num_workers = 0,
+    const ThreadOptions& worker_options = ThreadOptions());
+
+}  // namespace base
+}  // namespace ave
+
+#endif /* !TASK_RUNNER_POOL_H */
@@ -0,0 +1,129 @@
+/*
+ * task_runner_stats.cc
+ * Copyright (C) 2026 youfa <vsyfar@gmail.com>
+ *
+ * Distributed under terms of the GPLv2 license.
+ */
+
+#include "task_runner_stats.h"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+
+#if defined(AVE_TASK_RUNNER_STATS)
+#include "base/tracing/trace.h"
+#endif
+
+namespace ave {
+namespace base {
+
+size_t TaskTimeHistogram::BucketFor(uint64_t us) {
+  return std::min<size_t>(std::bit_width(us), kBuckets - 1);
+}
+
+uint64_t TaskTimeHistogram::BucketLimitUs(size_t bucket) {
+  return uint64_t{1} << bucket;
+}
+
+uint64_t TaskTimeHistogram::Count() const {
+  uint64_t count = 0;
+  for (uint64_t bucket : buckets) {
+    count += bucket;
+  }
+  return count;
+}
+
+uint64_t TaskTimeHistogram::PercentileUs(double fraction) const {
+  uint64_t count = Count();
+  if (count == 0) {
+    return 0;
+  }
+  auto rank = std::max<uint64_t>(
+      static_cast<uint64_t>(std::ceil(std::clamp(fraction, 0.0, 1.0) *
+                                      static_cast<double>(count))),
+      1);
+  uint64_t seen = 0;
+  for (size_t i = 0; i < kBuckets; ++i) {
+    seen += buckets[i];
+    if (seen >= rank) {
+      return BucketLimitUs(i);
+    }
+  }
+  return BucketLimitUs(kBuckets - 1);
+}
+
+#if defined(AVE_TASK_RUNNER_STATS)
+
+namespace {
+
+[[maybe_unused]] constexpr char kTraceCategory[] = "task_runner";
+
+// Only ever written by one thread, a plain load and store is enough.
+void Increment(std::atomic<uint64_t>& value) {
+  value.store(value.load(std::memory_order_relaxed) + 1,
+              std::memory_order_relaxed);
+}
+
+}  // namespace
+
+TaskRunnerStatsRecorder::TaskRunnerStatsRecorder(const std::string& name)
+    : queue_depth_counter_(name + ".queue_depth"),
+      queue_delay_counter_(name + ".queue_delay_us"),
+      run_time_counter_(name + ".run_time_us") {}
+
+void TaskRunnerStatsRecorder::OnQueued(size_t count) {
+  queue_depth_.fetch_add(static_cast<int64_t>(count),
+                         std::memory_order_relaxed);
+}
+
+void TaskRunnerStatsRecorder::OnDropped(size_t count) {
+  queue_depth_.fetch_sub(static_cast<int64_t>(count),
+                         std::memory_order_relaxed);
+}
+
+void TaskRunnerStatsRecorder::OnRun(uint64_t ready_us,
+                                    uint64_t start_us,
+                                    uint64_t end_us) {
+  int64_t depth [[maybe_unused]] =
+      queue_depth_.fetch_sub(1, std::memory_order_relaxed) - 1;
+  uint64_t queue_delay_us = start_us > ready_us ? start_us - ready_us : 0;
+  uint64_t run_time_us = end_us - start_us;
+
+  Increment(tasks_run_);
+  Increment(queue_delay_[TaskTimeHistogram::BucketFor(queue_delay_us)]);
+  Increment(run_time_[TaskTimeHistogram::BucketFor(run_time_us)]);
+  if (run_time_us > longest_task_us_.load(std::memory_order_relaxed)) {
+    longest_task_us_.store(run_time_us, std::memory_order_relaxed);
+    longest_task_end_us_.store(end_us, std::memory_order_relaxed);
+  }
+
+  AVE_TRACE_COUNTER_CATEGORY(kTraceCategory, queue_depth_counter_, depth);
+  AVE_TRACE_COUNTER_CATEGORY(kTraceCategory, queue_delay_counter_,
+                             static_cast<int64_t>(queue_delay_us));
+  AVE_TRACE_COUNTER_CATEGORY(kTraceCategory, run_time_counter_,
+                             static_cast<int64_t>(run_time_us));
+}
+
+TaskRunnerStats TaskRunnerStatsRecorder::Get() const {
+  TaskRunnerStats stats;
+  stats.queue_depth = static_cast<uint64_t>(
+      std::max<int64_t>(queue_depth_.load(std::memory_order_relaxed), 0));
+  stats.tasks_run = tasks_run_.load(std::memory_order_relaxed);
+  for (size_t i = 0; i < TaskTimeHistogram::kBuckets; ++i) {
+    stats.queue_delay.buckets[i] =
+        queue_delay_[i].load(std::memory_order_relaxed);
+    stats.run_time.buckets[i] = run_time_[i].load(std::memory_order_relaxed);
+  }
+  stats.longest_task_us = longest_task_us_.load(std::memory_order_relaxed);
+  stats.longest_task_end_us =
+      longest_task_end_us_.load(std::memory_order_relaxed);
+  stats.late_tasks = late_tasks_.load(std::memory_order_relaxed);
+  stats.overflow_tasks = overflow_tasks_.load(std::memory_order_relaxed);
+  return stats;
+}
+
+#endif  // defined(AVE_TASK_RUNNER_STATS)
+
+}  // namespace base
+}  // namespace ave
@@ -0,0 +1,139 @@
+/*
+ * task_runner_stats.h
+ * Copyright (C) 2026 youfa <vsyfar@gmail.com>
+ *
+ * Distributed under terms of the GPLv2 license.
+ */
+
+#ifndef TASK_RUNNER_STATS_H
+#define TASK_RUNNER_STATS_H
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "base/constructor_magic.h"
+
+namespace ave {
+namespace base {
+
+// Histogram of durations in microseconds with power of two buckets: bucket 0
+// counts 0us, bucket i counts [2^(i-1), 2^i) and the last bucket everything
+// longer.
+struct TaskTimeHistogram {
+  static constexpr size_t kBuckets = 24;
+
+  static size_t BucketFor(uint64_t us);
+  // Smallest duration the bucket does not count anymore.
+  static uint64_t BucketLimitUs(size_t bucket);
+
+  uint64_t Count() const;
+  // Upper bound of the bucket holding the `fraction` quantile, 0 when empty.
+  uint64_t PercentileUs(double fraction) const;
+
+  std::array<uint64_t, kBuckets> buckets{};
+};
+
+struct TaskRunnerStats {
+  // Tasks ready to run but not started yet.
+  uint64_t queue_depth = 0;
+  uint64_t tasks_run = 0;
+  // From being ready, i.e. posted or due, to starting to run.
+  TaskTimeHistogram queue_delay;
+  TaskTimeHistogram run_time;
+  uint64_t longest_task_us = 0;
+  // Steady clock time the longest task finished at.
+  uint64_t longest_task_end_us = 0;
+  // Dropped for missing their deadline, counted in every build.
+  uint64_t late_tasks = 0;
+  // Rejected or dropped for a full queue, see TaskQueueLimits. Counted in
+  // every build.
+  uint64_t overflow_tasks = 0;
+};
+
+// Collects TaskRunnerStats for a runner. Only built in with the
+// AVE_TASK_RUNNER_STATS define (the `enable_ave_task_runner_stats` gn arg),
+// otherwise every call is empty and Get() returns an empty record. With
+// tracing enabled the queue depth, queueing delay and run time of every task
+// are also emitted as "task_runner" trace counters. Late tasks are always
+// counted.
+class TaskRunnerStatsRecorder {
+ public:
+#if defined(AVE_TASK_RUNNER_STATS)
+  static constexpr bool kEnabled = true;
+
+  explicit TaskRunnerStatsRecorder(const std::string& name);
+  ~TaskRunnerStatsRecorder() = default;
+
+  // May be called from any thread.
+  void OnQueued(size_t count);
+  // A queued task left without running, e.g. cancelled.
+  void OnDropped(size_t count);
+  // Called by one thread at a time, after the task ran.
+  void OnRun(uint64_t ready_us, uint64_t start_us, uint64_t end_us);
+
+  TaskRunnerStats Get() const;
+
+ private:
+  using Buckets =
+      std::array<std::atomic<uint64_t>, TaskTimeHistogram::kBuckets>;
+
+  const std::string queue_depth_counter_;
+  const std::string queue_delay_counter_;
+  const std::string run_time_counter_;
+
+  std::atomic<int64_t> queue_depth_{0};
+  // Written by the running thread only.
+  std::atomic<uint64_t> tasks_run_{0};
+  Buckets queue_delay_{};
+  Buckets run_time_{};
+  std::atomic<uint64_t> longest_task_us_{0};
+  std::atomic<uint64_t> longest_task_end_us_{0};
+#else
+  static constexpr bool kEnabled = false;
+
+  explicit TaskRunnerStatsRecorder(const std::string& /* name */) {}
+  ~TaskRunnerStatsRecorder() = default;
+
+  void OnQueued(size_t /* count */) {}
+  void OnDropped(size_t /* count */) {}
+  void OnRun(uint64_t /* ready_us */,
+             uint64_t /* start_us */,
+             uint64_t /* end_us */) {}
+
+  TaskRunnerStats Get() const {
+    TaskRunnerStats stats;
+    stats.late_tasks = late_tasks_.load(std::memory_order_relaxed);
+    stats.overflow_tasks = overflow_tasks_.load(std::memory_order_relaxed);
+    return stats;
+  }
+#endif
+
+ public:
+  // Called by one thread at a time, instead of OnRun() for a queued task
+  // dropped for its deadline.
+  void OnLate() {
+    OnDropped(1);
+    late_tasks_.store(late_tasks_.load(std::memory_order_relaxed) + 1,
+                      std::memory_order_relaxed);
+  }
+
+  // May be called from any thread, for a post rejected because the queue
+  // was full or a queued task dropped to make room.
+  void OnOverflow() {
+    overflow_tasks_.fetch_add(1, std::memory_order_relaxed);
+  }
+
+ private:
+  std::atomic<uint64_t> late_tasks_{0};
+  std::atomic<uint64_t> overflow_tasks_{0};
+
+  AVE_DISALLOW_COPY_AND_ASSIGN(TaskRunnerStatsRecorder);
+};
+
+}  // namespace base
+}  // namespace ave
+
+#endif /* !TASK_RUNNER_STATS_H */
@@ -7,16 +7,31 @@
 
 #include "task_runner_stdlib.h"
 
+#include <algorithm>
+#include <array>
+#include <atomic>
 #include <chrono>
 #include <condition_variable>
-#include <future>
+#include <deque>
 #include <memory>
 #include <mutex>
-#include <queue>
+#include <source_location>
+#include <span>
 #include <string>
+#include <thread>
+#include <utility>
 
+#include "base/checks.h"
+#include "base/count_down_latch.h"
 #include "base/logging.h"
+#include "base/task_util/block_recycler.h"
+#include "base/task_util/inline_task.h"
+#include "base/task_util/mpsc_queue.h"
+#include "base/task_util/task_handle.h"
 #include "base/task_util/task_runner_factory.h"
+#include "base/task_util/task_runner_stats.h"
+#include "base/task_util/task_watchdog.h"
+#include "base/task_util/timing_wheel.h"
 #include "base/thread.h"
 #include "base/thread_defs.h"
 
@@ -24,10 +39,10 @@ namespace ave {
 namespace base {
 namespace {
 
+// Monotonic, wall clock changes must not move timers.
 uint64_t GetNowUs() {
-  auto systemClock = std::chrono::system_clock::now();
   return std::chrono::duration_cast<std::chrono::microseconds>(
-             systemClock.time_since_epoch())
+             std::chrono::steady_clock::now().time_since_epoch())
       .count();
 }
 
@@ -49,7 +64,12 @@ int TaskRunnerPriorityToStdlibPriority(TaskRunnerFactory::Priority priority) {
 
 class TaskRunnerStdlib final : public TaskRunnerBase {
  public:
-  TaskRunnerStdlib(const char* name, int priority);
+  // Owned by itself until Destruct(), task handles may keep the object
+  // around a little longer.
+  static TaskRunnerStdlib* Create(const char* name,
+                                  const ThreadOptions& options);
+
+  TaskRunnerStdlib(const char* name, const ThreadOptions& options);
   ~TaskRunnerStdlib() override = default;
 
   void Destruct() override;
@@ -58,73 +78,216 @@ class TaskRunnerStdlib final : public TaskRunnerBase {
   void PostDelayedTaskAndWait(std::unique_ptr<Task> task,
                               uint64_t delay_us,
                               bool wait) override;
+  void PostInlineTask(InlineTask task, uint64_t delay_us) override;
+  TaskHandle PostCancellableTask(InlineTask task,
+                                 PostOptions options) override;
+  void PostTasks(std::span<InlineTask> tasks) override;
+  bool PostTaskWithOptions(InlineTask task, PostOptions options) override;
+  void SetQueueLimits(TaskQueueLimits limits) override;
+  TaskRunnerStats GetStats() const override;
 
  private:
   using OrderId = uint64_t;
-  struct TaskEntry {
-    bool wait_{false};
-    uint64_t when_us_{};
-    OrderId order_{};
-    std::unique_ptr<Task> task_;
-    std::shared_ptr<std::promise<void>> promise_;
+  struct TaskEntry;
+
+  // Shared by a TaskHandle and the entry it cancels.
+  class EntryDelegate final : public TaskHandle::Delegate {
+   public:
+    explicit EntryDelegate(std::weak_ptr<TaskRunnerStdlib> runner)
+        : runner_(std::move(runner)) {}
+
+    bool Cancel() override;
+
+    // Called by the runner thread before running the entry, returns false
+    // if it was cancelled.
+    bool Start() { return !done_.exchange(true); }
+
+   private:
+    friend class TaskRunnerStdlib;
+    const std::weak_ptr<TaskRunnerStdlib> runner_;
+    std::atomic<bool> done_{false};
+    // The entry while it sits in the timing wheel, guarded by `mutex_` of the
+    // runner.
+    TaskEntry* entry_{nullptr};
   };
 
-  struct TaskOrder {
-    bool operator()(const std::unique_ptr<TaskEntry>& first,
-                    const std::unique_ptr<TaskEntry>& second) const {
-      return first->when_us_ > second->when_us_;
-    }
-  };
-
-  struct NextTask {
-    bool final_task_{false};
-    std::unique_ptr<Task> run_task_;
+  struct TaskEntry : public TimingWheelNode, public MpscQueueNode {
+    // Entries are recycled instead of going back to malloc.
+    static void* operator new(size_t size);
+    static void operator delete(void* entry);
+
+    explicit TaskEntry(InlineTask task) : task_(std::move(task)) {}
+
+    InlineTask task_;
+    std::shared_ptr<EntryDelegate> delegate_;
+    // Releases a waiting poster once the entry is done with, run or not.
+    ScopedCountDown done_;
+    TaskLane lane_{TaskLane::kNormal};
+    bool droppable_{false};
+    // Dropped instead of run once this has passed, 0 for none.
+    uint64_t deadline_us_{0};
+    std::unique_ptr<InlineTask> on_late_;
+    std::source_location location_;
+#if defined(AVE_TASK_RUNNER_STATS)
+    uint64_t ready_us_{0};
+#endif
   };
+  using TaskEntryRecycler = BlockRecycler<sizeof(TaskEntry)>;
+
+  // Returns false if the runner is quitting and dropped `entry`.
+  bool Post(std::unique_ptr<TaskEntry> entry,
+            uint64_t delay_us,
+            uint64_t slack_us = 0);
+  // An entry for `task` in the lane and with the deadline of `options`.
+  static std::unique_ptr<TaskEntry> MakeEntry(InlineTask task,
+                                              PostOptions& options);
+  // Takes a cancelled entry out of the timing wheel and destroys it.
+  void RemoveDelayed(EntryDelegate* delegate);
+
+  // Queues a ready entry of a bounded runner under the policy of `limits_`.
+  // Returns false if the entry is refused.
+  bool PostBounded(std::unique_ptr<TaskEntry> entry);
+  // The next three are called with `ready_mutex_` held.
+  // Queues `entry` without a limit. Returns true if the depth just reached
+  // the high watermark and `limits_.on_high` is due.
+  bool PushReady(std::unique_ptr<TaskEntry> entry);
+  // Takes the oldest droppable entry out of `ready_queues_`, nullptr if there
+  // is none.
+  std::unique_ptr<TaskEntry> TakeOldestDroppable();
+  // Called by the runner thread for an entry it took out of `ready_queues_`.
+  // Returns true if the depth is back down to the low watermark and
+  // `limits_.on_low` is due.
+  bool Release();
+
+  // Wakes the runner thread if it is parked, skipping the mutex and the
+  // notify otherwise.
+  void WakeUp();
+  // Stamps an entry about to go into `immediate_queues_` for the stats.
+  void MarkReady(TaskEntry* entry, uint64_t ready_us);
+  // Pops the next entry of the most urgent lane holding one.
+  std::unique_ptr<TaskEntry> PopImmediate();
+  bool ImmediateQueuesEmpty() const;
+  // Returns true and runs the late callback of `entry` if it missed its
+  // deadline.
+  bool DropIfLate(TaskEntry& entry);
+  // Moves due timers behind the immediate tasks already posted.
+  void MoveDueTasks();
+  // Sleeps until woken or the next timer is due, unless work turned up.
+  void Park();
+  void ProcessTask();
 
+  std::shared_ptr<TaskRunnerStdlib> self_;
+  std::weak_ptr<TaskRunnerStdlib> weak_self_;
   std::string name_;
-  int32_t priority_;
   std::unique_ptr<Thread> thread_;
+  std::atomic<bool> need_quit_;
+  // Set by the runner thread before it sleeps, cleared by whoever wakes it.
+  std::atomic<bool> parked_;
+
+  // Zero delay posts skip the clock and the mutex and go straight to the
+  // lock-free FIFO.
+  // One per TaskLane.
+  std::array<MpscQueue<TaskEntry>, kTaskLaneCount> immediate_queues_;
+
+  // Guards the delayed tasks and the sleep of the runner thread.
   std::mutex mutex_;
   std::condition_variable task_condition_;
-  bool need_quit_;
   OrderId task_order_id_;
+  TimingWheel<TaskEntry> delayed_queue_;
+  // Deadline of the earliest delayed task, read without the mutex.
+  std::atomic<uint64_t> next_due_us_;
+
+  // Set once SetQueueLimits() bounds the runner, posts skip the accounting
+  // otherwise.
+  std::atomic<bool> bounded_{false};
+  TaskQueueLimits limits_;
+  // A bounded runner queues its ready entries here instead of in
+  // `immediate_queues_`, so that a full queue can take out and destroy the
+  // oldest droppable entry right away. One per TaskLane.
+  std::mutex ready_mutex_;
+  std::array<std::deque<std::unique_ptr<TaskEntry>>, kTaskLaneCount>
+      ready_queues_;
+  // Entries in `ready_queues_`, written under `ready_mutex_` and read without
+  // it to skip the mutex while they are empty.
+  std::atomic<size_t> depth_{0};
+  // Orders entries across lanes for TakeOldestDroppable().
+  OrderId ready_order_id_{0};
+  bool above_high_{false};
+  // Posters waiting under kBlock, they sleep on `space_condition_` with
+  // `ready_mutex_`.
+  int blocked_posters_{0};
+  std::condition_variable space_condition_;
+
+  TaskRunnerStatsRecorder stats_;
+  const std::shared_ptr<TaskWatchdogSlot> watchdog_;
 
-  std::priority_queue<std::unique_ptr<TaskEntry>,
-                      std::vector<std::unique_ptr<TaskEntry>>,
-                      TaskOrder>
-      task_queue_;
-
-  bool Looping();
-  void ProcessTask();
   AVE_DISALLOW_COPY_AND_ASSIGN(TaskRunnerStdlib);
 };
 
-TaskRunnerStdlib::TaskRunnerStdlib(const char* name, int priority)
+void* TaskRunnerStdlib::TaskEntry::operator new(size_t size) {
+  AVE_DCHECK_EQ(size, sizeof(TaskEntry));
+  return TaskEntryRecycler::Allocate();
+}
+
+void TaskRunnerStdlib::TaskEntry::operator delete(void* entry) {
+  TaskEntryRecycler::Free(entry);
+}
+
+bool TaskRunnerStdlib::EntryDelegate::Cancel() {
+  if (done_.exchange(true)) {
+    return false;
+  }
+  if (std::shared_ptr<TaskRunnerStdlib> runner = runner_.lock()) {
+    runner->RemoveDelayed(this);
+  }
+  return true;
+}
+
+// static
+TaskRunnerStdlib* TaskRunnerStdlib::Create(const char* name,
+                                           const ThreadOptions& options) {
+  auto runner = std::make_shared<TaskRunnerStdlib>(name, options);
+  runner->weak_self_ = runner;
+  runner->self_ = runner;
+  return runner.get();
+}
+
+TaskRunnerStdlib::TaskRunnerStdlib(const char* name,
+                                   const ThreadOptions& options)
     : name_(name),
-      priority_(priority),
       thread_(std::make_unique<Thread>(
           [this] {
             CurrentTaskRunnerSetter set_current(this);
             ProcessTask();
           },
           name_,
-          priority_,
+          options,
           true /* joinable */)),
       need_quit_(false),
-      task_order_id_(0LL) {
+      parked_(false),
+      task_order_id_(0LL),
+      delayed_queue_(GetNowUs()),
+      next_due_us_(TimingWheelBase::kNever),
+      stats_(name_),
+      watchdog_(TaskWatchdog::Register(name_)) {
   thread_->start(false);
 }
 
 void TaskRunnerStdlib::Destruct() {
+  need_quit_.store(true);
   {
     std::scoped_lock guard(mutex_);
-    need_quit_ = true;
+    parked_.store(false);
+    task_condition_.notify_one();
+  }
+  {
+    std::scoped_lock guard(ready_mutex_);
+    space_condition_.notify_all();
   }
-  task_condition_.notify_one();
   if (thread_) {
     thread_->join();
   }
-  delete this;
+  std::shared_ptr<TaskRunnerStdlib> self = std::move(self_);
 }
 
 void TaskRunnerStdlib::PostTask(std::unique_ptr<Task> task) {
@@ -138,86 +301,400 @@ void TaskRunnerStdlib::PostDelayedTask(std::unique_ptr<Task> task,
 void TaskRunnerStdlib::PostDelayedTaskAndWait(std::unique_ptr<Task> task,
                                               uint64_t delay_us,
                                               bool wait) {
-  std::shared_ptr<std::promise<void>> promise;
-  std::future<void> future;
-  {
-    std::scoped_lock guard(mutex_);
-    if (need_quit_) {
-      return;
-    }
+  CountDownLatch done(1);
+  auto entry = std::make_unique<TaskEntry>(InlineTask(std::move(task)));
+  if (wait) {
+    entry->done_.reset(&done);
+  }
+  if (Post(std::move(entry), delay_us) && wait) {
+    done.Wait();
+  }
+}
+
+void TaskRunnerStdlib::PostInlineTask(InlineTask task, uint64_t delay_us) {
+  Post(std::make_unique<TaskEntry>(std::move(task)), delay_us);
+}
+
+TaskHandle TaskRunnerStdlib::PostCancellableTask(InlineTask task,
+                                                 PostOptions options) {
+  auto delegate = std::make_shared<EntryDelegate>(weak_self_);
+  std::unique_ptr<TaskEntry> entry = MakeEntry(std::move(task), options);
+  entry->delegate_ = delegate;
+  if (!Post(std::move(entry), options.delay_us, options.slack_us)) {
+    return TaskHandle();
+  }
+  return TaskHandle(std::move(delegate));
+}
 
-    if (wait) {
-      promise = std::make_shared<std::promise<void>>();
-      future = promise->get_future();
+bool TaskRunnerStdlib::PostTaskWithOptions(InlineTask task,
+                                           PostOptions options) {
+  std::unique_ptr<TaskEntry> entry = MakeEntry(std::move(task), options);
+  return Post(std::move(entry), options.delay_us, options.slack_us);
+}
+
+void TaskRunnerStdlib::SetQueueLimits(TaskQueueLimits limits) {
+  std::scoped_lock guard(ready_mutex_);
+  limits_ = std::move(limits);
+  bounded_.store(limits_.capacity > 0 || limits_.high_watermark > 0,
+                 std::memory_order_release);
+}
+
+std::unique_ptr<TaskRunnerStdlib::TaskEntry> TaskRunnerStdlib::MakeEntry(
+    InlineTask task,
+    PostOptions& options) {
+  auto entry = std::make_unique<TaskEntry>(std::move(task));
+  entry->lane_ = options.lane;
+  entry->droppable_ = options.droppable;
+  entry->location_ = options.location;
+  if (options.deadline_us > 0) {
+    entry->deadline_us_ = GetNowUs() + options.deadline_us;
+    if (options.on_late) {
+      entry->on_late_ =
+          std::make_unique<InlineTask>(std::move(options.on_late));
     }
+  }
+  return entry;
+}
 
-    uint64_t when_us = 0;
-    if (delay_us > 0) {
-      uint64_t now_us = GetNowUs();
-      when_us = (delay_us > (std::numeric_limits<uint64_t>::max() - now_us)
-                     ? std::numeric_limits<uint64_t>::max()
-                     : (now_us + delay_us));
-    } else {
-      when_us = GetNowUs();
+void TaskRunnerStdlib::PostTasks(std::span<InlineTask> tasks) {
+  if (tasks.empty() || need_quit_.load(std::memory_order_acquire)) {
+    return;
+  }
+  if (bounded_.load(std::memory_order_acquire)) {
+    // Each task is admitted on its own.
+    for (InlineTask& task : tasks) {
+      Post(std::make_unique<TaskEntry>(std::move(task)), 0LL);
     }
-    std::unique_ptr<TaskEntry> entry = std::make_unique<TaskEntry>();
-    entry->when_us_ = when_us;
+    return;
+  }
+
+  uint64_t now_us = TaskRunnerStatsRecorder::kEnabled ? GetNowUs() : 0;
+  MpscQueueBase::Chain chain;
+  for (InlineTask& task : tasks) {
+    auto* entry = new TaskEntry(std::move(task));
+    MarkReady(entry, now_us);
+    chain.Append(entry);
+  }
+  immediate_queues_[static_cast<size_t>(TaskLane::kNormal)].Push(chain);
+  WakeUp();
+}
+
+bool TaskRunnerStdlib::Post(std::unique_ptr<TaskEntry> entry,
+                            uint64_t delay_us,
+                            uint64_t slack_us) {
+  if (need_quit_.load(std::memory_order_acquire)) {
+    return false;
+  }
+
+  if (delay_us > 0) {
+    std::scoped_lock guard(mutex_);
+    uint64_t now_us = GetNowUs();
+    entry->when_us_ = DueTimeUs(now_us, delay_us, slack_us);
     entry->order_ = task_order_id_++;
-    entry->task_ = std::move(task);
-    if (wait) {
-      entry->promise_ = promise;
+    if (entry->delegate_) {
+      entry->delegate_->entry_ = entry.get();
     }
-    task_queue_.push(std::move(entry));
+    delayed_queue_.Insert(std::move(entry));
+    next_due_us_.store(delayed_queue_.NextDueUs(), std::memory_order_release);
+    // The runner thread reads the deadline under the mutex before it sleeps,
+    // so it only needs a notify if it is asleep already.
+    if (parked_.exchange(false)) {
+      task_condition_.notify_one();
+    }
+  } else {
+    if (bounded_.load(std::memory_order_acquire)) {
+      return PostBounded(std::move(entry));
+    }
+    MarkReady(entry.get(),
+              TaskRunnerStatsRecorder::kEnabled ? GetNowUs() : 0);
+    immediate_queues_[static_cast<size_t>(entry->lane_)].Push(
+        std::move(entry));
+    WakeUp();
+  }
+  return true;
+}
 
-    task_condition_.notify_one();
+bool TaskRunnerStdlib::PostBounded(std::unique_ptr<TaskEntry> entry) {
+  uint64_t now_us = TaskRunnerStatsRecorder::kEnabled ? GetNowUs() : 0;
+  std::unique_ptr<TaskEntry> dropped;
+  bool high = false;
+  {
+    std::unique_lock<std::mutex> l(ready_mutex_);
+    while (limits_.capacity > 0 && depth_.load() >= limits_.capacity) {
+      if (need_quit_.load()) {
+        return false;
+      }
+      if (limits_.policy == QueueFullPolicy::kReject) {
+        stats_.OnOverflow();
+        return false;
+      }
+      if (limits_.policy == QueueFullPolicy::kDropOldest) {
+        dropped = TakeOldestDroppable();
+        if (!dropped) {
+          stats_.OnOverflow();
+          return false;
+        }
+        break;
+      }
+      if (IsCurrent()) {
+        // kBlock on the runner thread would wait for itself.
+        break;
+      }
+      ++blocked_posters_;
+      space_condition_.wait(l);
+      --blocked_posters_;
+    }
+    MarkReady(entry.get(), now_us);
+    high = PushReady(std::move(entry));
+  }
+  if (dropped) {
+    // Destroyed here, outside the lock, the closure and what it holds do not
+    // wait for the runner thread to catch up.
+    if (dropped->delegate_) {
+      dropped->delegate_->Start();
+    }
+    stats_.OnOverflow();
+    stats_.OnDropped(1);
+    dropped.reset();
+  }
+  if (high) {
+    limits_.on_high();
+  }
+  WakeUp();
+  return true;
+}
+
+bool TaskRunnerStdlib::PushReady(std::unique_ptr<TaskEntry> entry) {
+  entry->order_ = ready_order_id_++;
+  ready_queues_[static_cast<size_t>(entry->lane_)].push_back(std::move(entry));
+  size_t depth = depth_.load(std::memory_order_relaxed) + 1;
+  depth_.store(depth);
+  if (limits_.high_watermark == 0 || depth < limits_.high_watermark ||
+      above_high_) {
+    return false;
   }
+  above_high_ = true;
+  return static_cast<bool>(limits_.on_high);
+}
 
-  if (wait) {
-    future.wait();
+std::unique_ptr<TaskRunnerStdlib::TaskEntry>
+TaskRunnerStdlib::TakeOldestDroppable() {
+  std::deque<std::unique_ptr<TaskEntry>>* oldest_queue = nullptr;
+  std::deque<std::unique_ptr<TaskEntry>>::iterator oldest;
+  for (auto& queue : ready_queues_) {
+    auto it = std::find_if(queue.begin(), queue.end(),
+                           [](const std::unique_ptr<TaskEntry>& entry) {
+                             return entry->droppable_;
+                           });
+    if (it != queue.end() &&
+        (!oldest_queue || (*it)->order_ < (*oldest)->order_)) {
+      oldest_queue = &queue;
+      oldest = it;
+    }
   }
+  if (!oldest_queue) {
+    return nullptr;
+  }
+  std::unique_ptr<TaskEntry> entry = std::move(*oldest);
+  oldest_queue->erase(oldest);
+  depth_.store(depth_.load(std::memory_order_relaxed) - 1);
+  return entry;
 }
 
-bool TaskRunnerStdlib::Looping() {
-  std::scoped_lock guard(mutex_);
-  return !need_quit_;
+bool TaskRunnerStdlib::Release() {
+  size_t depth = depth_.load(std::memory_order_relaxed) - 1;
+  depth_.store(depth);
+  if (blocked_posters_ > 0) {
+    space_condition_.notify_one();
+  }
+  if (limits_.high_watermark == 0 || depth > limits_.low_watermark ||
+      !above_high_) {
+    return false;
+  }
+  above_high_ = false;
+  return static_cast<bool>(limits_.on_low);
 }
 
-void TaskRunnerStdlib::ProcessTask() {
-  while (Looping()) {
-    std::unique_ptr<Task> task;
-    std::shared_ptr<std::promise<void>> promise;
-    {
-      std::unique_lock<std::mutex> l(mutex_);
-      if (task_queue_.empty()) {
-        task_condition_.wait(l);
-        continue;
-      }
+void TaskRunnerStdlib::WakeUp() {
+  // Pairs with Park(): either this sees `parked_` set, or the runner thread
+  // sees the entry just pushed and does not sleep.
+  if (parked_.exchange(false)) {
+    std::scoped_lock guard(mutex_);
+    task_condition_.notify_one();
+  }
+}
 
-      const auto& entry = task_queue_.top();
-      uint64_t now_ms = GetNowUs();
-      if (entry->when_us_ > now_ms) {
-        uint64_t delay_us = entry->when_us_ - now_ms;
-        if (delay_us > std::numeric_limits<uint64_t>::max()) {
-          delay_us = std::numeric_limits<uint64_t>::max();
-        }
-        task_condition_.wait_for(l, std::chrono::microseconds(delay_us));
-        continue;
+TaskRunnerStats TaskRunnerStdlib::GetStats() const {
+  return stats_.Get();
+}
+
+void TaskRunnerStdlib::MarkReady(TaskEntry* entry [[maybe_unused]],
+                                 uint64_t ready_us [[maybe_unused]]) {
+#if defined(AVE_TASK_RUNNER_STATS)
+  entry->ready_us_ = ready_us;
+#endif
+  stats_.OnQueued(1);
+}
+
+void TaskRunnerStdlib::MoveDueTasks() {
+  uint64_t next_due_us = next_due_us_.load(std::memory_order_acquire);
+  if (next_due_us == TimingWheelBase::kNever || next_due_us > GetNowUs()) {
+    return;
+  }
+
+  bool bounded = bounded_.load(std::memory_order_acquire);
+  bool high = false;
+  {
+    std::scoped_lock guard(mutex_);
+    std::unique_lock<std::mutex> ready_lock(ready_mutex_, std::defer_lock);
+    if (bounded) {
+      ready_lock.lock();
+    }
+    uint64_t now_us = GetNowUs();
+    while (auto due = delayed_queue_.PopDue(now_us)) {
+      if (due->delegate_) {
+        due->delegate_->entry_ = nullptr;
+      }
+      MarkReady(due.get(), due->when_us_);
+      if (bounded) {
+        // Already accepted, counted but never refused.
+        high |= PushReady(std::move(due));
+      } else {
+        immediate_queues_[static_cast<size_t>(due->lane_)].Push(
+            std::move(due));
       }
+    }
+    next_due_us_.store(delayed_queue_.NextDueUs(), std::memory_order_release);
+  }
+  if (high) {
+    limits_.on_high();
+  }
+}
+
+void TaskRunnerStdlib::RemoveDelayed(EntryDelegate* delegate) {
+  std::unique_ptr<TaskEntry> entry;
+  {
+    std::scoped_lock guard(mutex_);
+    if (!delegate->entry_) {
+      // Already queued to run, ProcessTask() drops it.
+      return;
+    }
+    entry = delayed_queue_.Remove(delegate->entry_);
+    if (!entry) {
+      // Its tick has been reached, MoveDueTasks() hands it out shortly.
+      return;
+    }
+    delegate->entry_ = nullptr;
+    next_due_us_.store(delayed_queue_.NextDueUs(), std::memory_order_release);
+  }
+  // The closure is destroyed here, outside the lock.
+}
 
-      task = std::move(entry->task_);
-      promise = std::move(entry->promise_);
-      task_queue_.pop();
+std::unique_ptr<TaskRunnerStdlib::TaskEntry>
+TaskRunnerStdlib::PopImmediate() {
+  // Entries posted before the runner was bounded go first in their lane.
+  bool bounded_ready = depth_.load() > 0;
+  std::unique_lock<std::mutex> ready_lock(ready_mutex_, std::defer_lock);
+  for (size_t lane = 0; lane < kTaskLaneCount; ++lane) {
+    if (std::unique_ptr<TaskEntry> entry = immediate_queues_[lane].Pop()) {
+      return entry;
     }
-    Task* release_ptr = task.release();
-    // if return true , task runner take the ownership
-    if (release_ptr->Run()) {
-      delete release_ptr;
+    if (!bounded_ready) {
+      continue;
     }
+    if (!ready_lock.owns_lock()) {
+      ready_lock.lock();
+    }
+    std::deque<std::unique_ptr<TaskEntry>>& queue = ready_queues_[lane];
+    if (!queue.empty()) {
+      std::unique_ptr<TaskEntry> entry = std::move(queue.front());
+      queue.pop_front();
+      bool low = Release();
+      ready_lock.unlock();
+      if (low) {
+        limits_.on_low();
+      }
+      return entry;
+    }
+  }
+  return nullptr;
+}
 
-    if (promise) {
-      promise->set_value();
+bool TaskRunnerStdlib::ImmediateQueuesEmpty() const {
+  if (depth_.load() > 0) {
+    return false;
+  }
+  for (const MpscQueue<TaskEntry>& queue : immediate_queues_) {
+    if (!queue.empty()) {
+      return false;
     }
   }
+  return true;
+}
+
+bool TaskRunnerStdlib::DropIfLate(TaskEntry& entry) {
+  if (GetNowUs() <= entry.deadline_us_) {
+    return false;
+  }
+  stats_.OnLate();
+  if (entry.on_late_) {
+    std::move(*entry.on_late_).Run();
+  }
+  return true;
+}
+
+void TaskRunnerStdlib::Park() {
+  parked_.store(true);
+  if (!ImmediateQueuesEmpty() || need_quit_.load()) {
+    // A producer may still be linking its entry, let it finish.
+    parked_.store(false, std::memory_order_relaxed);
+    std::this_thread::yield();
+    return;
+  }
+
+  std::unique_lock<std::mutex> l(mutex_);
+  auto woken = [this] { return !parked_.load(std::memory_order_relaxed); };
+  uint64_t next_due_us = delayed_queue_.NextDueUs();
+  if (next_due_us == TimingWheelBase::kNever) {
+    task_condition_.wait(l, woken);
+  } else {
+    uint64_t now_us = GetNowUs();
+    task_condition_.wait_for(
+        l,
+        std::chrono::microseconds(next_due_us > now_us ? next_due_us - now_us
+                                                       : 0),
+        woken);
+  }
+  parked_.store(false, std::memory_order_relaxed);
+}
+
+void TaskRunnerStdlib::ProcessTask() {
+  while (!need_quit_.load(std::memory_order_acquire)) {
+    MoveDueTasks();
+
+    std::unique_ptr<TaskEntry> entry = PopImmediate();
+    if (!entry) {
+      Park();
+      continue;
+    }
+    if (entry->delegate_ && !entry->delegate_->Start()) {
+      stats_.OnDropped(1);
+      continue;
+    }
+    if (entry->deadline_us_ > 0 && DropIfLate(*entry)) {
+      continue;
+    }
+
+    watchdog_->OnTaskStart(entry->location_);
+#if defined(AVE_TASK_RUNNER_STATS)
+    uint64_t start_us = GetNowUs();
+    std::move(entry->task_).Run();
+    stats_.OnRun(entry->ready_us_, start_us, GetNowUs());
+#else
+    std::move(entry->task_).Run();
+#endif
+    watchdog_->OnTaskEnd();
+  }
 }
 
 class TaskRunnerStdlibFactory final : public TaskRunnerFactory {
@@ -225,9 +702,16 @@ class TaskRunnerStdlibFactory final : public TaskRunnerFactory {
   std::unique_ptr<TaskRunnerBase, TaskRunnerDeleter> CreateTaskRunner(
       const char* name,
       Priority priority) const override {
+    return CreateTaskRunner(
+        name, ThreadOptions{
+                  .priority = TaskRunnerPriorityToStdlibPriority(priority)});
+  }
+
+  std::unique_ptr<TaskRunnerBase, TaskRunnerDeleter> CreateTaskRunner(
+      const char* name,
+      const ThreadOptions& options) const override {
     return std::unique_ptr<TaskRunnerBase, TaskRunnerDeleter>(
-        new TaskRunnerStdlib(name,
-                             TaskRunnerPriorityToStdlibPriority(priority)));
+        TaskRunnerStdlib::Create(name, options));
   }
 };
 
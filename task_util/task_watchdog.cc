@@ -0,0 +1,168 @@
+/*
+ * task_watchdog.cc
+ * Copyright (C) 2026 youfa <vsyfar@gmail.com>
+ *
+ * Distributed under terms of the GPLv2 license.
+ */
+
+#include "task_watchdog.h"
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#include "base/logging.h"
+#include "base/thread.h"
+#include "base/thread_defs.h"
+#include "base/tracing/trace.h"
+
+namespace ave {
+namespace base {
+namespace {
+
+[[maybe_unused]] constexpr char kTraceCategory[] = "task_runner";
+
+uint64_t GetNowUs() {
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+struct WatchdogState {
+  std::mutex mutex_;
+  std::condition_variable wake_;
+  std::vector<std::weak_ptr<TaskWatchdogSlot>> slots_;
+  std::unique_ptr<Thread> thread_;
+  bool quit_{false};
+};
+
+WatchdogState& GetState() {
+  // Never destroyed, runners may still register at exit.
+  static WatchdogState* state = new WatchdogState();
+  return *state;
+}
+
+void Report(const TaskWatchdog::LongTask& task) {
+  AVE_LOG(LS_WARNING) << "Task on " << task.runner << " has run for "
+                      << task.running_us / 1000 << " ms, posted from "
+                      << (task.line > 0 ? task.file : "unknown") << ":"
+                      << task.line << " " << task.function;
+  AVE_TRACE_EVENT_CATEGORY(kTraceCategory, task.runner + ".long_task");
+}
+
+}  // namespace
+
+// static
+void TaskWatchdog::Start(uint64_t threshold_us, Observer observer) {
+  Stop();
+  WatchdogState& state = GetState();
+  std::scoped_lock guard(state.mutex_);
+  state.quit_ = false;
+  state.thread_ = std::make_unique<Thread>(
+      [threshold_us, observer = std::move(observer)] {
+        WatchLoop(threshold_us, observer);
+      },
+      "task_watchdog", AVE_PRIORITY_NORMAL, true /* joinable */);
+  state.thread_->start(false);
+}
+
+// static
+void TaskWatchdog::Stop() {
+  WatchdogState& state = GetState();
+  std::unique_ptr<Thread> thread;
+  {
+    std::scoped_lock guard(state.mutex_);
+    state.quit_ = true;
+    thread = std::move(state.thread_);
+  }
+  state.wake_.notify_all();
+  if (thread) {
+    thread->join();
+  }
+}
+
+// static
+std::shared_ptr<TaskWatchdogSlot> TaskWatchdog::Register(std::string name) {
+  auto slot = std::make_shared<TaskWatchdogSlot>(std::move(name));
+  WatchdogState& state = GetState();
+  std::scoped_lock guard(state.mutex_);
+  std::erase_if(state.slots_,
+                [](const std::weak_ptr<TaskWatchdogSlot>& registered) {
+                  return registered.expired();
+                });
+  state.slots_.push_back(slot);
+  return slot;
+}
+
+// static
+void TaskWatchdog::WatchLoop(uint64_t threshold_us, const Observer& observer) {
+  WatchdogState& state = GetState();
+  auto interval =
+      std::chrono::microseconds(std::max<uint64_t>(threshold_us / 4, 1));
+  std::vector<LongTask> reports;
+  std::unique_lock<std::mutex> l(state.mutex_);
+  while (!state.wake_.wait_for(l, interval, [&state] { return state.quit_; })) {
+    uint64_t now_us = GetNowUs();
+    for (const std::weak_ptr<TaskWatchdogSlot>& registered : state.slots_) {
+      std::shared_ptr<TaskWatchdogSlot> slot = registered.lock();
+      LongTask report;
+      if (slot && Sample(*slot, now_us, threshold_us, &report)) {
+        reports.push_back(std::move(report));
+      }
+    }
+    if (reports.empty()) {
+      continue;
+    }
+
+    l.unlock();
+    for (const LongTask& report : reports) {
+      Report(report);
+      if (observer) {
+        observer(report);
+      }
+    }
+    reports.clear();
+    l.lock();
+  }
+}
+
+// static
+bool TaskWatchdog::Sample(TaskWatchdogSlot& slot,
+                          uint64_t now_us,
+                          uint64_t threshold_us,
+                          LongTask* report) {
+  uint64_t sequence = slot.sequence_.load(std::memory_order_acquire);
+  if ((sequence & 1) == 0) {
+    slot.seen_sequence_ = sequence;
+    return false;
+  }
+  if (sequence != slot.seen_sequence_) {
+    // A task started since the last sample, time it from now.
+    slot.seen_sequence_ = sequence;
+    slot.seen_since_us_ = now_us;
+    slot.reported_ = false;
+    return false;
+  }
+  if (slot.reported_ || now_us - slot.seen_since_us_ < threshold_us) {
+    return false;
+  }
+
+  report->file = slot.file_.load(std::memory_order_relaxed);
+  report->function = slot.function_.load(std::memory_order_relaxed);
+  report->line = slot.line_.load(std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_acquire);
+  if (slot.sequence_.load(std::memory_order_relaxed) != sequence) {
+    // Done in the meantime, the location may belong to the next task.
+    return false;
+  }
+  slot.reported_ = true;
+  report->runner = slot.name_;
+  report->running_us = now_us - slot.seen_since_us_;
+  return true;
+}
+
+}  // namespace base
+}  // namespace ave
@@ -0,0 +1,106 @@
+/*
+ * task_watchdog.h
+ * Copyright (C) 2026 youfa <vsyfar@gmail.com>
+ *
+ * Distributed under terms of the GPLv2 license.
+ */
+
+#ifndef TASK_WATCHDOG_H
+#define TASK_WATCHDOG_H
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <source_location>
+#include <string>
+
+namespace ave {
+namespace base {
+
+// What the thread of one runner is running. The thread marks each task with
+// a few plain stores and no clock read, the watchdog samples the slot.
+class TaskWatchdogSlot {
+ public:
+  explicit TaskWatchdogSlot(std::string name) : name_(std::move(name)) {}
+
+  const std::string& name() const { return name_; }
+
+  // `location` is where the task was posted from.
+  void OnTaskStart(const std::source_location& location) {
+    std::atomic_thread_fence(std::memory_order_release);
+    file_.store(location.file_name(), std::memory_order_relaxed);
+    function_.store(location.function_name(), std::memory_order_relaxed);
+    line_.store(location.line(), std::memory_order_relaxed);
+    // Odd while a task runs.
+    sequence_.store(sequence_.load(std::memory_order_relaxed) + 1,
+                    std::memory_order_release);
+  }
+
+  void OnTaskEnd() {
+    sequence_.store(sequence_.load(std::memory_order_relaxed) + 1,
+                    std::memory_order_release);
+  }
+
+ private:
+  friend class TaskWatchdog;
+
+  const std::string name_;
+  std::atomic<uint64_t> sequence_{0};
+  std::atomic<const char*> file_{""};
+  std::atomic<const char*> function_{""};
+  std::atomic<uint32_t> line_{0};
+
+  // Only touched by the watchdog thread.
+  uint64_t seen_sequence_{0};
+  uint64_t seen_since_us_{0};
+  bool reported_{false};
+};
+
+// Optional process wide thread that notices runners stuck in one task. Each
+// such task is logged once with the runner name, how long it has run so far
+// and where it was posted from, and emitted as a "task_runner" trace instant
+// event.
+//
+// The watchdog samples every quarter of the threshold and times a task from
+// the first sample that sees it, up to a quarter threshold after it started.
+// It reports the task at the first sample a full threshold after that, so
+// between one and one and a quarter thresholds after the start, later if the
+// watchdog thread itself is held up.
+class TaskWatchdog {
+ public:
+  struct LongTask {
+    std::string runner;
+    // Since the task was first seen, short of its true run time by up to a
+    // quarter threshold, as runners read no clock per task.
+    uint64_t running_us = 0;
+    // Posting location, empty and 0 if unknown.
+    const char* file = "";
+    const char* function = "";
+    uint32_t line = 0;
+  };
+  using Observer = std::function<void(const LongTask&)>;
+
+  // Starts watching, or restarts with a new threshold. `observer` runs on
+  // the watchdog thread for each report, in addition to the log.
+  static void Start(uint64_t threshold_us, Observer observer = nullptr);
+  static void Stop();
+
+  // Called by runners for their thread, the slot is watched until it is
+  // released. Cheap whether or not the watchdog runs.
+  static std::shared_ptr<TaskWatchdogSlot> Register(std::string name);
+
+ private:
+  static void WatchLoop(uint64_t threshold_us, const Observer& observer);
+  // Returns true and fills `report` the first time the task running in
+  // `slot` is seen past the threshold.
+  static bool Sample(TaskWatchdogSlot& slot,
+                     uint64_t now_us,
+                     uint64_t threshold_us,
+                     LongTask* report);
+};
+
+}  // namespace base
+}  // namespace ave
+
+#endif /* !TASK_WATCHDOG_H */
@@ -0,0 +1,219 @@
+/*
+ * timing_wheel.cc
+ * Copyright (C) 2026 youfa <vsyfar@gmail.com>
+ *
+ * Distributed under terms of the GPLv2 license.
+ */
+
+#include "timing_wheel.h"
+
+#include <algorithm>
+#include <bit>
+
+namespace ave {
+namespace base {
+namespace {
+
+struct NodeOrder {
+  bool operator()(const TimingWheelNode* first,
+                  const TimingWheelNode* second) const {
+    if (first->when_us_ != second->when_us_) {
+      return first->when_us_ > second->when_us_;
+    }
+    return first->order_ > second->order_;
+  }
+};
+
+}  // namespace
+
+TimingWheelBase::TimingWheelBase(uint64_t now_us)
+    : current_tick_(now_us >> kTickShift), size_(0) {
+  buckets_.fill(nullptr);
+  occupied_.fill(0);
+}
+
+void TimingWheelBase::Insert(TimingWheelNode* node) {
+  ++size_;
+  Place(node);
+}
+
+TimingWheelNode* TimingWheelBase::PopDue(uint64_t now_us) {
+  Advance(now_us);
+  if (near_.empty() || near_.front()->when_us_ > now_us) {
+    return nullptr;
+  }
+  --size_;
+  return PopNear();
+}
+
+TimingWheelNode* TimingWheelBase::PopAny() {
+  if (size_ == 0) {
+    return nullptr;
+  }
+  --size_;
+  if (!near_.empty()) {
+    return PopNear();
+  }
+  for (TimingWheelNode* head : buckets_) {
+    if (head) {
+      Unlink(head);
+      return head;
+    }
+  }
+  return nullptr;
+}
+
+bool TimingWheelBase::Remove(TimingWheelNode* node) {
+  if (node->bucket_ < 0 || node->bucket_ == kNearBucket) {
+    return false;
+  }
+  Unlink(node);
+  --size_;
+  return true;
+}
+
+uint64_t TimingWheelBase::NextDueUs() const {
+  if (!near_.empty()) {
+    return near_.front()->when_us_;
+  }
+  uint64_t tick = NextEventTick();
+  return tick == kNever ? kNever : tick << kTickShift;
+}
+
+void TimingWheelBase::Place(TimingWheelNode* node) {
+  uint64_t tick = node->when_us_ >> kTickShift;
+  if (tick <= current_tick_) {
+    PushNear(node);
+    return;
+  }
+
+  // The entry goes to the lowest level on which it shares the upper digits
+  // with the current tick, its digit on that level is always ahead of ours.
+  for (int level = 0; level < kLevels; ++level) {
+    int upper_shift = kSlotBits * (level + 1);
+    if ((tick >> upper_shift) == (current_tick_ >> upper_shift)) {
+      int32_t slot =
+          static_cast<int32_t>((tick >> (kSlotBits * level)) & (kSlots - 1));
+      occupied_[level] |= uint64_t{1} << slot;
+      Link(node, level * kSlots + slot);
+      return;
+    }
+  }
+  Link(node, kOverflowBucket);
+}
+
+void TimingWheelBase::Link(TimingWheelNode* node, int32_t bucket) {
+  node->bucket_ = bucket;
+  node->prev_ = nullptr;
+  node->next_ = buckets_[bucket];
+  if (node->next_) {
+    node->next_->prev_ = node;
+  }
+  buckets_[bucket] = node;
+}
+
+void TimingWheelBase::Unlink(TimingWheelNode* node) {
+  int32_t bucket = node->bucket_;
+  if (node->prev_) {
+    node->prev_->next_ = node->next_;
+  } else {
+    buckets_[bucket] = node->next_;
+  }
+  if (node->next_) {
+    node->next_->prev_ = node->prev_;
+  }
+  if (!buckets_[bucket] && bucket < kOverflowBucket) {
+    occupied_[bucket / kSlots] &= ~(uint64_t{1} << (bucket % kSlots));
+  }
+  node->prev_ = nullptr;
+  node->next_ = nullptr;
+  node->bucket_ = -1;
+}
+
+TimingWheelNode* TimingWheelBase::TakeBucket(int32_t bucket) {
+  TimingWheelNode* head = buckets_[bucket];
+  buckets_[bucket] = nullptr;
+  if (bucket < kOverflowBucket) {
+    occupied_[bucket / kSlots] &= ~(uint64_t{1} << (bucket % kSlots));
+  }
+  return head;
+}
+
+void TimingWheelBase::PushNear(TimingWheelNode* node) {
+  node->prev_ = nullptr;
+  node->next_ = nullptr;
+  node->bucket_ = kNearBucket;
+  near_.push_back(node);
+  std::push_heap(near_.begin(), near_.end(), NodeOrder());
+}
+
+TimingWheelNode* TimingWheelBase::PopNear() {
+  std::pop_heap(near_.begin(), near_.end(), NodeOrder());
+  TimingWheelNode* node = near_.back();
+  near_.pop_back();
+  node->bucket_ = -1;
+  return node;
+}
+
+uint64_t TimingWheelBase::NextEventTick() const {
+  // Occupied slots always lie ahead of the current digit of their level, and
+  // every slot of a lower level starts before any slot of a higher one.
+  for (int level = 0; level < kLevels; ++level) {
+    int shift = kSlotBits * level;
+    uint64_t digit = (current_tick_ >> shift) & (kSlots - 1);
+    uint64_t ahead = digit == kSlots - 1
+                         ? 0
+                         : occupied_[level] & (~uint64_t{0} << (digit + 1));
+    if (ahead) {
+      uint64_t rotation = current_tick_ >> (shift + kSlotBits);
+      uint64_t slot = std::countr_zero(ahead);
+      return ((rotation << kSlotBits) | slot) << shift;
+    }
+  }
+  if (buckets_[kOverflowBucket]) {
+    int top_shift = kSlotBits * kLevels;
+    return ((current_tick_ >> top_shift) + 1) << top_shift;
+  }
+  return kNever;
+}
+
+void TimingWheelBase::Advance(uint64_t now_us) {
+  uint64_t target = now_us >> kTickShift;
+  while (target > current_tick_) {
+    uint64_t event = NextEventTick();
+    if (event > target) {
+      current_tick_ = target;
+      return;
+    }
+    current_tick_ = event;
+
+    // Every bucket starting at `event` is emptied, higher levels first since
+    // they refill the lower ones.
+    std::array<int32_t, kLevels + 1> buckets{};
+    size_t count = 0;
+    if ((event & ((uint64_t{1} << (kSlotBits * kLevels)) - 1)) == 0) {
+      buckets[count++] = kOverflowBucket;
+    }
+    for (int level = kLevels - 1; level >= 0; --level) {
+      int shift = kSlotBits * level;
+      if ((event & ((uint64_t{1} << shift) - 1)) == 0) {
+        int32_t slot = static_cast<int32_t>((event >> shift) & (kSlots - 1));
+        buckets[count++] = level * kSlots + slot;
+      }
+    }
+    for (size_t i = 0; i < count; ++i) {
+      int32_t bucket = buckets[i];
+      TimingWheelNode* node = TakeBucket(bucket);
+      while (node) {
+        TimingWheelNode* next = node->next_;
+        node->prev_ = nullptr;
+        node->next_ = nullptr;
+        Place(node);
+        node = next;
+      }
+    }
+  }
+}
+
+}  // namespace base
+}  // namespace ave
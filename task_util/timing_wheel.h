@@ -0,0 +1,138 @@
+/*
+ * timing_wheel.h
+ * Copyright (C) 2026 youfa <vsyfar@gmail.com>
+ *
+ * Distributed under terms of the GPLv2 license.
+ */
+
+#ifndef TIMING_WHEEL_H
+#define TIMING_WHEEL_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+#include "base/constructor_magic.h"
+
+namespace ave {
+namespace base {
+
+// Intrusive hook for entries kept in a TimingWheel. Entries due at the same
+// time come out ordered by `order_`.
+class TimingWheelNode {
+ public:
+  uint64_t when_us_{};
+  uint64_t order_{};
+
+ private:
+  friend class TimingWheelBase;
+  TimingWheelNode* prev_{nullptr};
+  TimingWheelNode* next_{nullptr};
+  int32_t bucket_{-1};
+};
+
+// Hierarchical timing wheel with four levels of 64 slots and a tick of
+// 1024us, covering about 4.7 hours before entries spill into an overflow
+// list. Insert is O(1). Advancing skips empty slots using per level bitmaps
+// and moves every entry down at most once per level, so expiry is amortised
+// O(1). Entries whose tick has been reached sit in a small heap, that keeps
+// their exact order and means no entry is ever reported before `when_us_`.
+//
+// Not thread safe.
+class TimingWheelBase {
+ public:
+  static constexpr uint64_t kNever = std::numeric_limits<uint64_t>::max();
+
+  explicit TimingWheelBase(uint64_t now_us);
+  ~TimingWheelBase() = default;
+
+  void Insert(TimingWheelNode* node);
+
+  // Returns the earliest entry with `when_us_` <= `now_us`, or nullptr.
+  TimingWheelNode* PopDue(uint64_t now_us);
+
+  // Removes and returns any entry, used to drain the wheel.
+  TimingWheelNode* PopAny();
+
+  // Unlinks `node` in O(1). Returns false, leaving it in place, if its tick
+  // has been reached already, it is then handed out by the next PopDue().
+  bool Remove(TimingWheelNode* node);
+
+  // Returns a time no later than the earliest entry, or kNever if empty.
+  uint64_t NextDueUs() const;
+
+  bool empty() const { return size_ == 0; }
+  size_t size() const { return size_; }
+
+ private:
+  static constexpr int kSlotBits = 6;
+  static constexpr int kSlots = 1 << kSlotBits;
+  static constexpr int kLevels = 4;
+  static constexpr int kTickShift = 10;
+  static constexpr int32_t kOverflowBucket = kLevels * kSlots;
+  static constexpr int32_t kNearBucket = kOverflowBucket + 1;
+
+  // Files an entry relative to `current_tick_`.
+  void Place(TimingWheelNode* node);
+  void Link(TimingWheelNode* node, int32_t bucket);
+  void Unlink(TimingWheelNode* node);
+  TimingWheelNode* TakeBucket(int32_t bucket);
+  void PushNear(TimingWheelNode* node);
+  TimingWheelNode* PopNear();
+
+  // First tick after `current_tick_` at which a bucket has to be emptied.
+  uint64_t NextEventTick() const;
+  void Advance(uint64_t now_us);
+
+  uint64_t current_tick_;
+  size_t size_;
+  std::array<TimingWheelNode*, kOverflowBucket + 1> buckets_;
+  std::array<uint64_t, kLevels> occupied_;
+  std::vector<TimingWheelNode*> near_;
+
+  AVE_DISALLOW_COPY_AND_ASSIGN(TimingWheelBase);
+};
+
+// Owning wrapper, `Entry` must derive from TimingWheelNode.
+template <typename Entry>
+class TimingWheel {
+ public:
+  static_assert(std::is_base_of_v<TimingWheelNode, Entry>);
+  static constexpr uint64_t kNever = TimingWheelBase::kNever;
+
+  explicit TimingWheel(uint64_t now_us) : wheel_(now_us) {}
+  ~TimingWheel() {
+    while (TimingWheelNode* node = wheel_.PopAny()) {
+      delete static_cast<Entry*>(node);
+    }
+  }
+
+  void Insert(std::unique_ptr<Entry> entry) { wheel_.Insert(entry.release()); }
+
+  std::unique_ptr<Entry> PopDue(uint64_t now_us) {
+    return std::unique_ptr<Entry>(static_cast<Entry*>(wheel_.PopDue(now_us)));
+  }
+
+  // Returns `entry` on success, see TimingWheelBase::Remove().
+  std::unique_ptr<Entry> Remove(Entry* entry) {
+    return std::unique_ptr<Entry>(wheel_.Remove(entry) ? entry : nullptr);
+  }
+
+  uint64_t NextDueUs() const { return wheel_.NextDueUs(); }
+  bool empty() const { return wheel_.empty(); }
+  size_t size() const { return wheel_.size(); }
+
+ private:
+  TimingWheelBase wheel_;
+
+  AVE_DISALLOW_COPY_AND_ASSIGN(TimingWheel);
+};
+
+}  // namespace base
+}  // namespace ave
+
+#endif /* !TIMING_WHEEL_H */
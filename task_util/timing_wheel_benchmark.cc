@@ -0,0 +1,147 @@
+/*
+ * timing_wheel_benchmark.cc
+ * Copyright (C) 2026 youfa <vsyfar@gmail.com>
+ *
+ * Distributed under terms of the GPLv2 license.
+ */
+
+#include <cstdint>
+#include <memory>
+#include <queue>
+#include <random>
+#include <vector>
+
+#include "base/task_util/timing_wheel.h"
+#include "benchmark/benchmark.h"
+
+namespace ave {
+namespace base {
+namespace {
+
+// Delays of retransmission and timeout timers, 1ms to 10s.
+constexpr uint64_t kMinDelayUs = 1000;
+constexpr uint64_t kMaxDelayUs = 10 * 1000 * 1000;
+
+struct Entry : public TimingWheelNode {};
+
+// The queue TaskRunnerStdlib used before the timing wheel.
+struct EntryOrder {
+  bool operator()(const std::unique_ptr<Entry>& first,
+                  const std::unique_ptr<Entry>& second) const {
+    if (first->when_us_ != second->when_us_) {
+      return first->when_us_ > second->when_us_;
+    }
+    return first->order_ > second->order_;
+  }
+};
+
+class HeapQueue {
+ public:
+  explicit HeapQueue(uint64_t now_us [[maybe_unused]]) {}
+
+  void Insert(std::unique_ptr<Entry> entry) { queue_.push(std::move(entry)); }
+
+  std::unique_ptr<Entry> PopDue(uint64_t now_us) {
+    if (queue_.empty() || queue_.top()->when_us_ > now_us) {
+      return nullptr;
+    }
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-type-const-cast)
+    auto entry = std::move(const_cast<std::unique_ptr<Entry>&>(queue_.top()));
+    queue_.pop();
+    return entry;
+  }
+
+  uint64_t NextDueUs() const {
+    return queue_.empty() ? TimingWheelBase::kNever : queue_.top()->when_us_;
+  }
+
+ private:
+  std::priority_queue<std::unique_ptr<Entry>,
+                      std::vector<std::unique_ptr<Entry>>,
+                      EntryOrder>
+      queue_;
+};
+
+using WheelQueue = TimingWheel<Entry>;
+
+std::vector<uint64_t> MakeDelays(size_t count) {
+  std::minstd_rand gen(count);
+  std::uniform_int_distribution<uint64_t> dis(kMinDelayUs, kMaxDelayUs);
+  std::vector<uint64_t> delays(count);
+  for (auto& delay : delays) {
+    delay = dis(gen);
+  }
+  return delays;
+}
+
+// Keeps `state.range(0)` timers pending. Every step fires the earliest one
+// and schedules a replacement, as a runner busy with timeouts would.
+template <typename Queue>
+void BM_SteadyState(benchmark::State& state) {
+  const size_t pending = state.range(0);
+  std::vector<uint64_t> delays = MakeDelays(pending * 4);
+  uint64_t now_us = 0;
+  uint64_t order = 0;
+  size_t next_delay = 0;
+
+  Queue queue(now_us);
+  for (size_t i = 0; i < pending; ++i) {
+    auto entry = std::make_unique<Entry>();
+    entry->when_us_ = now_us + delays[next_delay++ % delays.size()];
+    entry->order_ = order++;
+    queue.Insert(std::move(entry));
+  }
+
+  for (auto _ : state) {
+    now_us = queue.NextDueUs();
+    std::unique_ptr<Entry> entry;
+    while (!entry) {
+      entry = queue.PopDue(now_us);
+      if (!entry) {
+        now_us = queue.NextDueUs();
+      }
+    }
+    entry->when_us_ = now_us + delays[next_delay++ % delays.size()];
+    entry->order_ = order++;
+    queue.Insert(std::move(entry));
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+// Schedules `state.range(0)` timers and fires all of them.
+template <typename Queue>
+void BM_InsertAndDrain(benchmark::State& state) {
+  const size_t count = state.range(0);
+  std::vector<uint64_t> delays = MakeDelays(count);
+
+  for (auto _ : state) {
+    Queue queue(0);
+    for (size_t i = 0; i < count; ++i) {
+      auto entry = std::make_unique<Entry>();
+      entry->when_us_ = delays[i];
+      entry->order_ = i;
+      queue.Insert(std::move(entry));
+    }
+    uint64_t now_us = 0;
+    size_t fired = 0;
+    while (fired < count) {
+      now_us = queue.NextDueUs();
+      while (auto entry = queue.PopDue(now_us)) {
+        benchmark::DoNotOptimize(entry.get());
+        ++fired;
+      }
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * count);
+}
+
+BENCHMARK_TEMPLATE(BM_SteadyState, HeapQueue)->Range(64, 64 << 10);
+BENCHMARK_TEMPLATE(BM_SteadyState, WheelQueue)->Range(64, 64 << 10);
+BENCHMARK_TEMPLATE(BM_InsertAndDrain, HeapQueue)->Range(64, 64 << 10);
+BENCHMARK_TEMPLATE(BM_InsertAndDrain, WheelQueue)->Range(64, 64 << 10);
+
+}  // namespace
+}  // namespace base
+}  // namespace ave
+
+BENCHMARK_MAIN();
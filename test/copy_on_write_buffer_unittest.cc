@@ -68,6 +68,16 @@ TEST(CopyOnWriteBufferTest, UnsharesOnMutableData) {
   EXPECT_EQ(buf2[0], 2);
 }
 
+TEST(CopyOnWriteBufferTest, HasOneRef) {
+  CopyOnWriteBuffer buf(std::string_view("abc"));
+  EXPECT_TRUE(buf.HasOneRef());
+  {
+    CopyOnWriteBuffer slice = buf.Slice(1, 1);
+    EXPECT_FALSE(buf.HasOneRef());
+  }
+  EXPECT_TRUE(buf.HasOneRef());
+}
+
 TEST(CopyOnWriteBufferTest, SetData) {
   CopyOnWriteBuffer buf;
   // NOLINTNEXTLINE
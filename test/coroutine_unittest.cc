@@ -0,0 +1,128 @@
+/*
+ * coroutine_unittest.cc
+ * Copyright (C) 2026 youfa <vsyfar@gmail.com>
+ *
+ * Distributed under terms of the GPLv2 license.
+ */
+
+#include "base/task_util/coroutine.h"
+
+#include <chrono>
+#include <future>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+
+#include "base/task_util/default_task_runner_factory.h"
+#include "base/task_util/task_runner.h"
+#include "test/gtest.h"
+
+namespace ave {
+namespace base {
+namespace {
+
+std::unique_ptr<TaskRunner> CreateRunner(const char* name) {
+  auto factory = CreateDefaultTaskRunnerFactory();
+  return std::make_unique<TaskRunner>(
+      factory->CreateTaskRunner(name, TaskRunnerFactory::Priority::NORMAL));
+}
+
+CoTask<int> Add(TaskRunner& runner, int a, int b) {
+  co_await runner;
+  co_return a + b;
+}
+
+CoTask<int> Fail(TaskRunner& runner) {
+  co_await runner;
+  throw std::runtime_error("failed");
+  co_return 0;
+}
+
+}  // namespace
+
+TEST(CoroutineTest, AwaitRunnerHopsThreads) {
+  auto first = CreateRunner("CoFirst");
+  auto second = CreateRunner("CoSecond");
+  std::promise<std::pair<bool, bool>> done;
+
+  auto body = [](TaskRunner& first, TaskRunner& second,
+                 std::promise<std::pair<bool, bool>>& done) -> CoTask<> {
+    co_await first;
+    bool on_first = first.IsCurrent();
+    co_await second;
+    done.set_value({on_first, second.IsCurrent()});
+  };
+  body(*first, *second, done).Start();
+
+  auto result = done.get_future().get();
+  EXPECT_TRUE(result.first);
+  EXPECT_TRUE(result.second);
+}
+
+TEST(CoroutineTest, AwaitCoTaskReturnsValue) {
+  auto runner = CreateRunner("CoValue");
+  std::promise<int> done;
+
+  auto body = [](TaskRunner& runner, std::promise<int>& done) -> CoTask<> {
+    int sum = co_await Add(runner, 2, 3);
+    sum += co_await Add(runner, sum, 10);
+    done.set_value(sum);
+  };
+  body(*runner, done).Start();
+
+  EXPECT_EQ(done.get_future().get(), 20);
+}
+
+TEST(CoroutineTest, ExceptionReachesAwaiter) {
+  auto runner = CreateRunner("CoException");
+  std::promise<bool> done;
+
+  auto body = [](TaskRunner& runner, std::promise<bool>& done) -> CoTask<> {
+    bool caught = false;
+    try {
+      co_await Fail(runner);
+    } catch (const std::runtime_error&) {
+      caught = true;
+    }
+    done.set_value(caught);
+  };
+  body(*runner, done).Start();
+
+  EXPECT_TRUE(done.get_future().get());
+}
+
+TEST(CoroutineTest, SleepForWaitsOnSameRunner) {
+  auto runner = CreateRunner("CoSleep");
+  std::promise<bool> done;
+  auto start = std::chrono::steady_clock::now();
+
+  auto body = [](TaskRunner& runner, std::promise<bool>& done) -> CoTask<> {
+    co_await runner;
+    co_await SleepFor(20 * 1000);
+    done.set_value(runner.IsCurrent());
+  };
+  body(*runner, done).Start();
+
+  EXPECT_TRUE(done.get_future().get());
+  EXPECT_GE(std::chrono::steady_clock::now() - start,
+            std::chrono::milliseconds(20));
+}
+
+TEST(CoroutineTest, StartedFrameIsDestroyedWhenDone) {
+  auto runner = CreateRunner("CoDestroy");
+  auto captured = std::make_shared<int>(0);
+  std::weak_ptr<int> weak = captured;
+
+  auto body = [](TaskRunner& runner,
+                 std::shared_ptr<int> captured) -> CoTask<> {
+    co_await runner;
+    ++*captured;
+  };
+  body(*runner, std::move(captured)).Start();
+  runner->PostTaskAndWait([]() {});
+
+  EXPECT_TRUE(weak.expired());
+}
+
+}  // namespace base
+}  // namespace ave
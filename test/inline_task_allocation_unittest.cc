@@ -0,0 +1,126 @@
+/*
+ * inline_task_allocation_unittest.cc
+ * Copyright (C) 2026 youfa <vsyfar@gmail.com>
+ *
+ * Distributed under terms of the GPLv2 license.
+ */
+
+// Replaces the global operator new and delete, so this is built into its own
+// executable instead of base_unittests.
+
+#include <array>
+#include <cstdlib>
+#include <new>
+#include <utility>
+
+#include "base/count_down_latch.h"
+#include "base/task_util/default_task_runner_factory.h"
+#include "base/task_util/inline_task.h"
+#include "base/task_util/task_runner.h"
+#include "test/gtest.h"
+
+namespace {
+
+// Set while a ScopedAllocationCounter lives on the thread.
+thread_local size_t* t_allocations = nullptr;
+
+// Counts the allocations made by the current thread while it lives.
+class ScopedAllocationCounter {
+ public:
+  ScopedAllocationCounter() : previous_(t_allocations) {
+    t_allocations = &count_;
+  }
+  ~ScopedAllocationCounter() { t_allocations = previous_; }
+
+  size_t count() const { return count_; }
+
+ private:
+  size_t count_ = 0;
+  size_t* const previous_;
+};
+
+}  // namespace
+
+void* operator new(size_t size) {
+  if (t_allocations) {
+    ++*t_allocations;
+  }
+  if (void* pointer = std::malloc(size ? size : 1)) {
+    return pointer;
+  }
+  throw std::bad_alloc();
+}
+
+// Not inlined, GCC would pair the free() with the caller's operator new and
+// warn about a mismatch.
+[[gnu::noinline]] void operator delete(void* pointer) noexcept {
+  std::free(pointer);
+}
+
+[[gnu::noinline]] void operator delete(void* pointer,
+                                       size_t /* size */) noexcept {
+  std::free(pointer);
+}
+
+namespace ave {
+namespace base {
+
+TEST(InlineTaskTest, SmallClosureDoesNotAllocate) {
+  int value = 0;
+  ScopedAllocationCounter allocations;
+  InlineTask task([&value]() { ++value; });
+  InlineTask moved(std::move(task));
+  EXPECT_EQ(allocations.count(), 0u);
+  EXPECT_FALSE(task);  // NOLINT(bugprone-use-after-move)
+  ASSERT_TRUE(moved);
+  std::move(moved).Run();
+  EXPECT_EQ(value, 1);
+  EXPECT_FALSE(moved);  // NOLINT(bugprone-use-after-move)
+}
+
+TEST(InlineTaskTest, LargeClosureGoesToTheHeap) {
+  std::array<int, 64> values{};
+  values[63] = 7;
+  int result = 0;
+  ScopedAllocationCounter allocations;
+  InlineTask task([values, &result]() { result = values[63]; });
+  EXPECT_GT(allocations.count(), 0u);
+  std::move(task).Run();
+  EXPECT_EQ(result, 7);
+}
+
+TEST(InlineTaskTest, PostingSmallClosuresDoesNotAllocate) {
+  auto factory = CreateDefaultTaskRunnerFactory();
+  TaskRunner runner(factory->CreateTaskRunner(
+      "PostingSmallClosures", TaskRunnerFactory::Priority::NORMAL));
+  constexpr int kTasks = 256;
+  int counter = 0;
+
+  // Warm up the entry recycler with entries freed by the runner thread.
+  // Held back until all are posted, so the runner frees them in one go and
+  // hands batches of them to the recycler's depot. Interleaved, it would
+  // keep them in its own thread cache.
+  CountDownLatch hold(1);
+  runner.PostTask([&hold]() { hold.Wait(); });
+  for (int i = 0; i < kTasks; ++i) {
+    runner.PostTask([&counter]() { ++counter; });
+  }
+  hold.CountDown();
+  runner.PostTaskAndWait([]() {});
+
+  size_t allocations = 0;
+  {
+    ScopedAllocationCounter counter_scope;
+    for (int i = 0; i < kTasks / 2; ++i) {
+      runner.PostTask([&counter]() { ++counter; });
+    }
+    allocations = counter_scope.count();
+  }
+  runner.PostTaskAndWait([]() {});
+
+  EXPECT_EQ(allocations, 0u);
+  EXPECT_EQ(counter, kTasks + kTasks / 2);
+}
+
+}  // namespace base
+}  // namespace ave
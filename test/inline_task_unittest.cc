@@ -0,0 +1,51 @@
+/*
+ * inline_task_unittest.cc
+ * Copyright (C) 2026 youfa <vsyfar@gmail.com>
+ *
+ * Distributed under terms of the GPLv2 license.
+ */
+
+#include "base/task_util/inline_task.h"
+
+#include <memory>
+#include <utility>
+
+#include "test/gtest.h"
+
+namespace ave {
+namespace base {
+namespace {
+
+class CountingTask : public Task {
+ public:
+  CountingTask(int* runs, int* deletes) : runs_(runs), deletes_(deletes) {}
+  ~CountingTask() override { ++*deletes_; }
+
+ private:
+  bool Run() override {
+    ++*runs_;
+    return true;
+  }
+
+  int* runs_;
+  int* deletes_;
+};
+
+}  // namespace
+
+TEST(InlineTaskTest, KeepsTaskOwnership) {
+  int runs = 0;
+  int deletes = 0;
+  InlineTask task(std::make_unique<CountingTask>(&runs, &deletes));
+  std::move(task).Run();
+  EXPECT_EQ(runs, 1);
+  EXPECT_EQ(deletes, 1);
+
+  // Dropped without running.
+  { InlineTask dropped(std::make_unique<CountingTask>(&runs, &deletes)); }
+  EXPECT_EQ(runs, 1);
+  EXPECT_EQ(deletes, 2);
+}
+
+}  // namespace base
+}  // namespace ave
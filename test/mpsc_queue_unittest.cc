@@ -0,0 +1,112 @@
+/*
+ * mpsc_queue_unittest.cc
+ * Copyright (C) 2026 youfa <vsyfar@gmail.com>
+ *
+ * Distributed under terms of the GPLv2 license.
+ */
+
+#include "base/task_util/mpsc_queue.h"
+
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "test/gtest.h"
+
+namespace ave {
+namespace base {
+namespace {
+
+struct Entry : public MpscQueueNode {
+  Entry(int producer, int sequence)
+      : producer_(producer), sequence_(sequence) {}
+  int producer_;
+  int sequence_;
+};
+
+}  // namespace
+
+TEST(MpscQueueTest, EmptyQueue) {
+  MpscQueue<Entry> queue;
+  EXPECT_TRUE(queue.empty());
+  EXPECT_EQ(queue.Pop(), nullptr);
+}
+
+TEST(MpscQueueTest, SingleThreadFifo) {
+  MpscQueue<Entry> queue;
+  for (int round = 0; round < 3; ++round) {
+    for (int i = 0; i < 10; ++i) {
+      queue.Push(std::make_unique<Entry>(0, i));
+    }
+    EXPECT_FALSE(queue.empty());
+    for (int i = 0; i < 10; ++i) {
+      auto entry = queue.Pop();
+      ASSERT_NE(entry, nullptr);
+      EXPECT_EQ(entry->sequence_, i);
+    }
+    EXPECT_TRUE(queue.empty());
+    EXPECT_EQ(queue.Pop(), nullptr);
+  }
+}
+
+TEST(MpscQueueTest, ChainKeepsOrder) {
+  MpscQueue<Entry> queue;
+  queue.Push(std::make_unique<Entry>(0, 0));
+  MpscQueueBase::Chain chain;
+  for (int i = 1; i < 5; ++i) {
+    chain.Append(new Entry(0, i));
+  }
+  queue.Push(chain);
+  EXPECT_TRUE(chain.empty());
+  queue.Push(std::make_unique<Entry>(0, 5));
+
+  for (int i = 0; i < 6; ++i) {
+    auto entry = queue.Pop();
+    ASSERT_NE(entry, nullptr);
+    EXPECT_EQ(entry->sequence_, i);
+  }
+  EXPECT_TRUE(queue.empty());
+}
+
+TEST(MpscQueueTest, DeletesRemainingEntries) {
+  MpscQueue<Entry> queue;
+  queue.Push(std::make_unique<Entry>(0, 0));
+  queue.Push(std::make_unique<Entry>(0, 1));
+}
+
+TEST(MpscQueueTest, ManyProducersKeepTheirOrder) {
+  constexpr int kProducers = 8;
+  constexpr int kPerProducer = 20000;
+  MpscQueue<Entry> queue;
+
+  std::vector<std::thread> producers;
+  for (int p = 0; p < kProducers; ++p) {
+    producers.emplace_back([&queue, p] {
+      for (int i = 0; i < kPerProducer; ++i) {
+        queue.Push(std::make_unique<Entry>(p, i));
+      }
+    });
+  }
+
+  std::vector<int> next(kProducers, 0);
+  int received = 0;
+  while (received < kProducers * kPerProducer) {
+    auto entry = queue.Pop();
+    if (!entry) {
+      std::this_thread::yield();
+      continue;
+    }
+    ASSERT_EQ(entry->sequence_, next[entry->producer_]);
+    ++next[entry->producer_];
+    ++received;
+  }
+
+  for (auto& producer : producers) {
+    producer.join();
+  }
+  EXPECT_TRUE(queue.empty());
+}
+
+}  // namespace base
+}  // namespace ave
@@ -0,0 +1,88 @@
+/*
+ * parallel_unittest.cc
+ * Copyright (C) 2026 youfa <vsyfar@gmail.com>
+ *
+ * Distributed under terms of the GPLv2 license.
+ */
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <numeric>
+#include <set>
+#include <thread>
+#include <vector>
+
+#include "base/task_util/parallel.h"
+#include "test/gtest.h"
+
+namespace ave {
+namespace base {
+namespace {
+
+TEST(ParallelTest, ForVisitsEachIndexOnce) {
+  ParallelPool pool(3);
+  std::vector<std::atomic<int>> visits(10007);
+  ParallelFor(pool, 0, visits.size(), 64, [&visits](size_t begin, size_t end) {
+    EXPECT_LE(end - begin, 64u);
+    for (size_t i = begin; i < end; ++i) {
+      visits[i].fetch_add(1);
+    }
+  });
+  for (auto& count : visits) {
+    EXPECT_EQ(count.load(), 1);
+  }
+}
+
+TEST(ParallelTest, CallerTakesPart) {
+  ParallelPool pool(2);
+  std::mutex mutex;
+  std::set<std::thread::id> threads;
+  // Slow chunks give every thread the chance to claim some.
+  ParallelFor(pool, 0, 64, 1, [&](size_t, size_t) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    std::scoped_lock guard(mutex);
+    threads.insert(std::this_thread::get_id());
+  });
+  EXPECT_EQ(threads.count(std::this_thread::get_id()), 1u);
+  EXPECT_GT(threads.size(), 1u);
+}
+
+TEST(ParallelTest, NoHelpersRunsOnCaller) {
+  ParallelPool pool(0);
+  EXPECT_EQ(pool.concurrency(), 1u);
+  size_t covered = 0;
+  ParallelFor(pool, 5, 105, 0, [&covered](size_t begin, size_t end) {
+    covered += end - begin;
+  });
+  EXPECT_EQ(covered, 100u);
+}
+
+TEST(ParallelTest, Reduce) {
+  std::vector<uint64_t> values(100000);
+  std::iota(values.begin(), values.end(), 1);
+  uint64_t sum = ParallelReduce(
+      0, values.size(), 0, uint64_t{0},
+      [&values](size_t begin, size_t end) {
+        return std::accumulate(values.begin() + begin, values.begin() + end,
+                               uint64_t{0});
+      },
+      [](uint64_t a, uint64_t b) { return a + b; });
+  EXPECT_EQ(sum, uint64_t{100000} * 100001 / 2);
+}
+
+TEST(ParallelTest, NestedFor) {
+  ParallelPool pool(2);
+  std::atomic<int> total{0};
+  ParallelFor(pool, 0, 8, 1, [&](size_t, size_t) {
+    ParallelFor(pool, 0, 100, 10, [&total](size_t begin, size_t end) {
+      total.fetch_add(static_cast<int>(end - begin));
+    });
+  });
+  EXPECT_EQ(total.load(), 800);
+}
+
+}  // namespace
+}  // namespace base
+}  // namespace ave
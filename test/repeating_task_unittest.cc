@@ -6,8 +6,10 @@
  */
 
 #include <unistd.h>
+#include <chrono>
 #include <condition_variable>
 #include <cstdint>
+#include <memory>
 #include <mutex>
 
 #include "base/logging.h"
@@ -19,6 +21,15 @@
 
 namespace ave {
 namespace base {
+namespace {
+
+// Exposes the due time rounding of the runners.
+class DueTime : public TaskRunnerBase {
+ public:
+  using TaskRunnerBase::DueTimeUs;
+};
+
+}  // namespace
 
 TEST(RepeatingTaskTest, Example) {
   base::TaskRunnerForTest task_runner("TestRunner");
@@ -38,5 +49,76 @@ TEST(RepeatingTaskTest, Example) {
   EXPECT_TRUE(i == 101);
 }
 
+TEST(RepeatingTaskTest, StopReleasesPendingRun) {
+  base::TaskRunnerForTest task_runner("TestRunner");
+  auto captured = std::make_shared<int>(0);
+  std::mutex m;
+  std::condition_variable cv;
+  bool ran = false;
+
+  RepeatingTaskHandle handle = RepeatingTaskHandle::Start(
+      task_runner.Get(), [captured, &m, &cv, &ran]() {
+        std::scoped_lock lock(m);
+        ran = true;
+        cv.notify_one();
+        return static_cast<uint64_t>(10) * 1000 * 1000;
+      });
+  {
+    std::unique_lock<std::mutex> l(m);
+    EXPECT_TRUE(
+        cv.wait_for(l, std::chrono::seconds(1), [&ran] { return ran; }));
+  }
+  // Let the first run finish posting the next one.
+  task_runner.PostTaskAndWait([]() {});
+  EXPECT_EQ(captured.use_count(), 2);
+
+  handle.Stop();
+  EXPECT_FALSE(handle.Running());
+  EXPECT_EQ(captured.use_count(), 1);
+}
+
+TEST(RepeatingTaskTest, DueTimeRoundsUpToSlackGrid) {
+  EXPECT_EQ(DueTime::DueTimeUs(1000, 500, 0), 1500u);
+  // 3000us of slack align to a 2048us grid.
+  EXPECT_EQ(DueTime::DueTimeUs(1000, 500, 3000), 2048u);
+  EXPECT_EQ(DueTime::DueTimeUs(1000, 1048, 3000), 2048u);
+  EXPECT_EQ(DueTime::DueTimeUs(1000, 1049, 3000), 4096u);
+  EXPECT_EQ(DueTime::DueTimeUs(1, UINT64_MAX, 0), UINT64_MAX);
+  EXPECT_EQ(DueTime::DueTimeUs(UINT64_MAX - 10, 5, 4096), UINT64_MAX);
+}
+
+TEST(RepeatingTaskTest, PeriodDoesNotDrift) {
+  constexpr int kRuns = 20;
+  constexpr auto kPeriod = std::chrono::milliseconds(10);
+  base::TaskRunnerForTest task_runner("TestRunner");
+  std::mutex m;
+  std::condition_variable cv;
+  int runs = 0;
+  auto start = std::chrono::steady_clock::now();
+  std::chrono::steady_clock::time_point last;
+
+  RepeatingTaskHandle handle = RepeatingTaskHandle::Start(
+      task_runner.Get(), [&m, &cv, &runs, &last]() {
+        // Run time must not push the following runs back.
+        usleep(2000);
+        std::scoped_lock lock(m);
+        if (++runs == kRuns + 1) {
+          last = std::chrono::steady_clock::now();
+          cv.notify_one();
+        }
+        return static_cast<uint64_t>(10) * 1000;
+      });
+  {
+    std::unique_lock<std::mutex> l(m);
+    cv.wait(l, [&runs] { return runs > kRuns; });
+  }
+  handle.Stop();
+  task_runner.PostTaskAndWait([]() {});
+
+  EXPECT_GE(last - start, kPeriod * kRuns);
+  // Drifting by the 2ms run time would take 240ms.
+  EXPECT_LT(last - start, kPeriod * kRuns + std::chrono::milliseconds(30));
+}
+
 }  // namespace base
 }  // namespace ave
@@ -0,0 +1,104 @@
+/*
+ * simulated_time_controller_unittest.cc
+ * Copyright (C) 2026 youfa <vsyfar@gmail.com>
+ *
+ * Distributed under terms of the GPLv2 license.
+ */
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "base/task_util/repeating_task.h"
+#include "base/task_util/simulated_time_controller.h"
+#include "base/task_util/task_runner.h"
+#include "base/units/time_delta.h"
+#include "base/units/timestamp.h"
+#include "test/gtest.h"
+
+namespace ave {
+namespace base {
+namespace {
+
+std::unique_ptr<TaskRunner> CreateRunner(SimulatedTimeController& controller) {
+  return std::make_unique<TaskRunner>(
+      controller.GetTaskRunnerFactory()->CreateTaskRunner(
+          "Simulated", TaskRunnerFactory::Priority::NORMAL));
+}
+
+TEST(SimulatedTimeControllerTest, RunsTasksInDueOrderOnVirtualTime) {
+  SimulatedTimeController controller(Timestamp::Seconds(1000));
+  auto runner = CreateRunner(controller);
+  Clock* clock = controller.GetClock();
+  std::vector<int64_t> run_at_ms;
+
+  auto record = [&run_at_ms, clock] {
+    run_at_ms.push_back(clock->TimeInMilliseconds());
+  };
+  runner->PostDelayedTask(record, 30 * 1000);
+  runner->PostDelayedTask(record, 10 * 1000);
+  runner->PostTask(record);
+  EXPECT_TRUE(run_at_ms.empty());
+
+  controller.RunReady();
+  EXPECT_EQ(run_at_ms, std::vector<int64_t>({1000 * 1000}));
+
+  controller.AdvanceTime(TimeDelta::Millis(20));
+  EXPECT_EQ(run_at_ms, std::vector<int64_t>({1000 * 1000, 1000 * 1000 + 10}));
+  EXPECT_EQ(clock->TimeInMilliseconds(), 1000 * 1000 + 20);
+
+  controller.AdvanceTime(TimeDelta::Millis(20));
+  EXPECT_EQ(run_at_ms.back(), 1000 * 1000 + 30);
+  EXPECT_EQ(clock->TimeInMilliseconds(), 1000 * 1000 + 40);
+}
+
+TEST(SimulatedTimeControllerTest, RepeatingTaskRunsForHours) {
+  SimulatedTimeController controller(Timestamp::Seconds(1));
+  auto runner = CreateRunner(controller);
+  int runs = 0;
+  RepeatingTaskHandle handle =
+      RepeatingTaskHandle::Start(runner->Get(), [&runs]() -> uint64_t {
+        ++runs;
+        return 10 * 1000;
+      });
+
+  controller.AdvanceTime(TimeDelta::Seconds(3600));
+  // One run at the start and one every 10ms after it.
+  EXPECT_EQ(runs, 3600 * 100 + 1);
+  handle.Stop();
+}
+
+TEST(SimulatedTimeControllerTest, CancelledTaskDoesNotRun) {
+  SimulatedTimeController controller(Timestamp::Seconds(1));
+  auto runner = CreateRunner(controller);
+  bool ran = false;
+  TaskHandle handle = runner->PostDelayedTask([&ran] { ran = true; }, 1000);
+  EXPECT_TRUE(handle.Cancel());
+  controller.AdvanceTime(TimeDelta::Seconds(1));
+  EXPECT_FALSE(ran);
+}
+
+TEST(SimulatedTimeControllerTest, PostTaskAndWaitDrivesTheClock) {
+  SimulatedTimeController controller(Timestamp::Seconds(1));
+  auto runner = CreateRunner(controller);
+  bool current = false;
+  runner->PostDelayedTaskAndWait([&] { current = runner->IsCurrent(); },
+                                 5 * 1000);
+  EXPECT_TRUE(current);
+  EXPECT_EQ(controller.GetClock()->TimeInMilliseconds(), 1000 + 5);
+}
+
+TEST(SimulatedTimeControllerTest, DestructFromOwnTask) {
+  SimulatedTimeController controller(Timestamp::Seconds(1));
+  auto runner = CreateRunner(controller);
+  bool later_ran = false;
+  runner->PostDelayedTask([&later_ran] { later_ran = true; }, 1000);
+  runner->PostTask([&runner] { runner.reset(); });
+  controller.AdvanceTime(TimeDelta::Seconds(1));
+  EXPECT_EQ(runner, nullptr);
+  EXPECT_FALSE(later_ran);
+}
+
+}  // namespace
+}  // namespace base
+}  // namespace ave
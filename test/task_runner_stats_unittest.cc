@@ -0,0 +1,67 @@
+/*
+ * task_runner_stats_unittest.cc
+ * Copyright (C) 2026 youfa <vsyfar@gmail.com>
+ *
+ * Distributed under terms of the GPLv2 license.
+ */
+
+#include "base/task_util/task_runner_stats.h"
+
+#include <chrono>
+#include <memory>
+#include <thread>
+
+#include "base/task_util/default_task_runner_factory.h"
+#include "base/task_util/task_runner.h"
+#include "test/gtest.h"
+
+namespace ave {
+namespace base {
+
+TEST(TaskTimeHistogramTest, PowerOfTwoBuckets) {
+  EXPECT_EQ(TaskTimeHistogram::BucketFor(0), 0u);
+  EXPECT_EQ(TaskTimeHistogram::BucketFor(1), 1u);
+  EXPECT_EQ(TaskTimeHistogram::BucketFor(3), 2u);
+  EXPECT_EQ(TaskTimeHistogram::BucketFor(4), 3u);
+  EXPECT_EQ(TaskTimeHistogram::BucketFor(uint64_t{1} << 40),
+            TaskTimeHistogram::kBuckets - 1);
+}
+
+TEST(TaskTimeHistogramTest, Percentile) {
+  TaskTimeHistogram histogram;
+  EXPECT_EQ(histogram.PercentileUs(0.5), 0u);
+
+  histogram.buckets[TaskTimeHistogram::BucketFor(10)] = 90;
+  histogram.buckets[TaskTimeHistogram::BucketFor(5000)] = 10;
+  EXPECT_EQ(histogram.Count(), 100u);
+  EXPECT_EQ(histogram.PercentileUs(0.5), 16u);
+  EXPECT_EQ(histogram.PercentileUs(0.9), 16u);
+  EXPECT_EQ(histogram.PercentileUs(0.99), 8192u);
+}
+
+TEST(TaskRunnerStatsTest, RecordsTasks) {
+  auto factory = CreateDefaultTaskRunnerFactory();
+  TaskRunner runner(
+      factory->CreateTaskRunner("Stats", TaskRunnerFactory::Priority::NORMAL));
+  runner.PostTask(
+      []() { std::this_thread::sleep_for(std::chrono::milliseconds(5)); });
+  runner.PostTask([]() {});
+  // Both tasks above are recorded once this one runs, it may still be
+  // recording itself.
+  runner.PostTaskAndWait([]() {});
+
+  TaskRunnerStats stats = runner.GetStats();
+  if (!TaskRunnerStatsRecorder::kEnabled) {
+    EXPECT_EQ(stats.tasks_run, 0u);
+    return;
+  }
+  EXPECT_GE(stats.tasks_run, 2u);
+  EXPECT_LE(stats.queue_depth, 1u);
+  EXPECT_GE(stats.run_time.Count(), 2u);
+  EXPECT_GE(stats.longest_task_us, 5000u);
+  // The second task waited behind the first one.
+  EXPECT_GE(stats.queue_delay.PercentileUs(1.0), 4096u);
+}
+
+}  // namespace base
+}  // namespace ave
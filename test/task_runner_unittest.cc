@@ -4,15 +4,26 @@
  *
  * Distributed under terms of the GPLv2 license.
  */
+#include <sched.h>
+
+#include <atomic>
 #include <condition_variable>
 #include <memory>
 #include <mutex>
+#include <optional>
+#include <thread>
+#include <utility>
+#include <vector>
 
+#include "base/count_down_latch.h"
 #include "base/task_util/default_task_runner_factory.h"
+#include "base/task_util/inline_task.h"
 #include "base/task_util/task.h"
 #include "base/task_util/task_runner.h"
 #include "base/task_util/task_runner_base.h"
 #include "base/task_util/task_runner_factory.h"
+#include "base/task_util/task_handle.h"
+#include "base/task_util/task_runner_pool.h"
 #include "base/test/task_runner_unittest.h"
 #include "gtest/gtest-param-test.h"
 #include "gtest/gtest.h"
@@ -26,6 +37,12 @@ namespace {
 INSTANTIATE_TEST_SUITE_P(Default,
                          TaskRunnerTest,
                          ::testing::Values(CreateDefaultTaskRunnerFactory));
+
+INSTANTIATE_TEST_SUITE_P(Pool,
+                         TaskRunnerTest,
+                         ::testing::Values([] {
+                           return CreateTaskRunnerPoolFactory(2);
+                         }));
 }
 
 std::unique_ptr<TaskRunnerBase, TaskRunnerDeleter> CreateTaskRunner(
@@ -44,21 +61,29 @@ TEST_P(TaskRunnerTest, PostATask) {
   std::condition_variable cv;
   class CustomTask : public Task {
    public:
-    explicit CustomTask(std::condition_variable* cv) : cv_(cv) {}
+    CustomTask(std::mutex* mutex, std::condition_variable* cv)
+        : mutex_(mutex), cv_(cv) {}
 
    private:
     bool Run() override {
+      std::scoped_lock lock(*mutex_);
       cv_->notify_one();
       return true;
     }
 
+    std::mutex* mutex_;
     std::condition_variable* cv_;
   };
-  runner->PostTask(std::make_unique<CustomTask>(&cv));
+  // Hold the lock while posting so the notification can not fire before the
+  // wait starts.
   std::unique_lock<std::mutex> l(mutex);
+  runner->PostTask(std::make_unique<CustomTask>(&mutex, &cv));
   EXPECT_TRUE(cv.wait_for(l, 1000ms) == std::cv_status::no_timeout);
 
-  runner->PostTask([&cv]() { cv.notify_one(); });
+  runner->PostTask([&mutex, &cv]() {
+    std::scoped_lock lock(mutex);
+    cv.notify_one();
+  });
   EXPECT_TRUE(cv.wait_for(l, 1000ms) == std::cv_status::no_timeout);
 }
 
@@ -88,6 +113,442 @@ TEST_P(TaskRunnerTest, PostDelayedTask) {
   EXPECT_TRUE(cv.wait_for(l, 500ms) == std::cv_status::no_timeout);
 }
 
+TEST_P(TaskRunnerTest, TasksRunInPostOrder) {
+  std::unique_ptr<TaskRunnerFactory> factory = GetParam()();
+  auto runner = std::make_unique<TaskRunner>(
+      CreateTaskRunner(factory, "TasksRunInPostOrder"));
+  constexpr int kTaskCount = 1000;
+  std::vector<int> order;
+  std::atomic<int> running{0};
+  bool overlapped = false;
+  for (int i = 0; i < kTaskCount; ++i) {
+    runner->PostTask([&order, &running, &overlapped, i]() {
+      if (running.fetch_add(1) != 0) {
+        overlapped = true;
+      }
+      order.push_back(i);
+      running.fetch_sub(1);
+    });
+  }
+  runner->PostTaskAndWait([]() {});
+
+  EXPECT_FALSE(overlapped);
+  ASSERT_EQ(order.size(), static_cast<size_t>(kTaskCount));
+  for (int i = 0; i < kTaskCount; ++i) {
+    EXPECT_EQ(order[i], i);
+  }
+}
+
+TEST_P(TaskRunnerTest, PostTasksRunsBatchInOrder) {
+  std::unique_ptr<TaskRunnerFactory> factory = GetParam()();
+  auto runner =
+      std::make_unique<TaskRunner>(CreateTaskRunner(factory, "PostTasks"));
+  std::vector<int> order;
+  runner->PostTask([&order]() { order.push_back(-1); });
+
+  std::vector<InlineTask> batch;
+  for (int i = 0; i < 100; ++i) {
+    batch.emplace_back([&order, i]() { order.push_back(i); });
+  }
+  runner->PostTasks(batch);
+  runner->PostTaskAndWait([&order]() { order.push_back(100); });
+
+  ASSERT_EQ(order.size(), 102u);
+  for (int i = 0; i < 102; ++i) {
+    EXPECT_EQ(order[i], i - 1);
+  }
+}
+
+TEST_P(TaskRunnerTest, ManyProducers) {
+  std::unique_ptr<TaskRunnerFactory> factory = GetParam()();
+  auto runner =
+      std::make_unique<TaskRunner>(CreateTaskRunner(factory, "ManyProducers"));
+  constexpr int kProducers = 8;
+  constexpr int kTasksPerProducer = 2000;
+  std::vector<int> next(kProducers, 0);
+  bool in_order = true;
+
+  std::vector<std::thread> producers;
+  for (int p = 0; p < kProducers; ++p) {
+    producers.emplace_back([&, p] {
+      for (int i = 0; i < kTasksPerProducer; ++i) {
+        runner->PostTask([&, p, i]() {
+          if (next[p] != i) {
+            in_order = false;
+          }
+          next[p] = i + 1;
+        });
+      }
+    });
+  }
+  for (auto& producer : producers) {
+    producer.join();
+  }
+  runner->PostTaskAndWait([]() {});
+
+  EXPECT_TRUE(in_order);
+  for (int p = 0; p < kProducers; ++p) {
+    EXPECT_EQ(next[p], kTasksPerProducer);
+  }
+}
+
+TEST_P(TaskRunnerTest, CancelDelayedTask) {
+  std::unique_ptr<TaskRunnerFactory> factory = GetParam()();
+  auto runner = std::make_unique<TaskRunner>(
+      CreateTaskRunner(factory, "CancelDelayedTask"));
+  auto captured = std::make_shared<int>(0);
+  bool ran = false;
+  TaskHandle handle = runner->PostDelayedTask(
+      [captured, &ran]() { ran = true; }, 20 * 1000);
+  EXPECT_EQ(captured.use_count(), 2);
+
+  EXPECT_TRUE(handle.Cancel());
+  // The closure is gone right away, not when its deadline passes.
+  EXPECT_EQ(captured.use_count(), 1);
+  EXPECT_FALSE(handle.Cancel());
+
+  runner->PostDelayedTaskAndWait([]() {}, 40 * 1000);
+  EXPECT_FALSE(ran);
+}
+
+TEST_P(TaskRunnerTest, CancelAfterRun) {
+  std::unique_ptr<TaskRunnerFactory> factory = GetParam()();
+  auto runner =
+      std::make_unique<TaskRunner>(CreateTaskRunner(factory, "CancelAfterRun"));
+  bool ran = false;
+  TaskHandle handle = runner->PostDelayedTask([&ran]() { ran = true; }, 1000);
+  runner->PostDelayedTaskAndWait([]() {}, 20 * 1000);
+  EXPECT_TRUE(ran);
+  EXPECT_FALSE(handle.Cancel());
+}
+
+TEST_P(TaskRunnerTest, UrgentLaneRunsFirst) {
+  std::unique_ptr<TaskRunnerFactory> factory = GetParam()();
+  auto runner =
+      std::make_unique<TaskRunner>(CreateTaskRunner(factory, "Lanes"));
+  CountDownLatch gate(1);
+  std::vector<int> order;
+  runner->PostTask([&gate]() { gate.Wait(); });
+  runner->PostTaskWithOptions([&order]() { order.push_back(3); },
+                              {.lane = TaskLane::kBackground});
+  runner->PostTaskWithOptions([&order]() { order.push_back(2); },
+                              {.lane = TaskLane::kNormal});
+  runner->PostTaskWithOptions([&order]() { order.push_back(1); },
+                              {.lane = TaskLane::kUrgent});
+  // Queued behind the other background task.
+  CountDownLatch done(1);
+  runner->PostTaskWithOptions([&done]() { done.CountDown(); },
+                              {.lane = TaskLane::kBackground});
+  gate.CountDown();
+  done.Wait();
+
+  EXPECT_EQ(order, (std::vector<int>{1, 2, 3}));
+}
+
+TEST_P(TaskRunnerTest, LateTaskIsDropped) {
+  std::unique_ptr<TaskRunnerFactory> factory = GetParam()();
+  auto runner =
+      std::make_unique<TaskRunner>(CreateTaskRunner(factory, "Deadline"));
+  bool ran = false;
+  bool late = false;
+  bool in_time = false;
+  runner->PostTask([]() { std::this_thread::sleep_for(20ms); });
+  runner->PostTaskWithOptions([&ran]() { ran = true; },
+                              {.deadline_us = 5 * 1000,
+                               .on_late = [&late]() { late = true; }});
+  runner->PostTaskWithOptions([&in_time]() { in_time = true; },
+                              {.deadline_us = 10 * 1000 * 1000});
+  runner->PostTaskAndWait([]() {});
+
+  EXPECT_FALSE(ran);
+  EXPECT_TRUE(late);
+  EXPECT_TRUE(in_time);
+  EXPECT_EQ(runner->GetStats().late_tasks, 1u);
+}
+
+TEST_P(TaskRunnerTest, InvokeReturnsResult) {
+  std::unique_ptr<TaskRunnerFactory> factory = GetParam()();
+  auto runner =
+      std::make_unique<TaskRunner>(CreateTaskRunner(factory, "Invoke"));
+  int calls = 0;
+  EXPECT_EQ(runner->Invoke([&]() {
+    ++calls;
+    return runner->IsCurrent() ? 42 : -1;
+  }),
+            42);
+  EXPECT_TRUE(runner->Invoke([&]() { ++calls; }));
+  EXPECT_EQ(calls, 2);
+  // Nested on its own runner, runs right away instead of deadlocking.
+  EXPECT_EQ(runner->Invoke([&]() {
+    auto nested = runner->Invoke([&]() { return runner->IsCurrent(); });
+    return nested.value_or(false);
+  }),
+            true);
+  // A reference result comes back as a copy.
+  int value = 7;
+  std::optional<int> copy = runner->Invoke([&]() -> int& { return value; });
+  value = 8;
+  EXPECT_EQ(copy, 7);
+}
+
+TEST_P(TaskRunnerTest, PostTaskAndReply) {
+  std::unique_ptr<TaskRunnerFactory> factory = GetParam()();
+  // Outlives `runner`, which may still be posting to it after the reply ran.
+  auto reply_runner =
+      std::make_unique<TaskRunner>(CreateTaskRunner(factory, "Reply"));
+  auto runner =
+      std::make_unique<TaskRunner>(CreateTaskRunner(factory, "Task"));
+  std::mutex mutex;
+  std::condition_variable cv;
+  bool task_on_runner = false;
+  int result = 0;
+  bool reply_on_reply_runner = false;
+  bool replied = false;
+
+  runner->PostTaskAndReply(
+      [&]() {
+        task_on_runner = runner->IsCurrent();
+        return 7;
+      },
+      reply_runner->Get(),
+      [&](int value) {
+        std::scoped_lock lock(mutex);
+        result = value;
+        reply_on_reply_runner = reply_runner->IsCurrent();
+        replied = true;
+        cv.notify_one();
+      });
+
+  std::unique_lock<std::mutex> l(mutex);
+  EXPECT_TRUE(cv.wait_for(l, 1000ms, [&replied] { return replied; }));
+  EXPECT_TRUE(task_on_runner);
+  EXPECT_EQ(result, 7);
+  EXPECT_TRUE(reply_on_reply_runner);
+}
+
+TEST_P(TaskRunnerTest, CurrentIsSetWhileRunning) {
+  std::unique_ptr<TaskRunnerFactory> factory = GetParam()();
+  auto runner1 =
+      std::make_unique<TaskRunner>(CreateTaskRunner(factory, "Current1"));
+  auto runner2 =
+      std::make_unique<TaskRunner>(CreateTaskRunner(factory, "Current2"));
+  EXPECT_FALSE(runner1->IsCurrent());
+
+  bool current1 = false;
+  bool current2 = false;
+  runner1->PostTaskAndWait([&]() {
+    current1 = runner1->IsCurrent() && !runner2->IsCurrent() &&
+               TaskRunnerBase::Current() == runner1->Get();
+  });
+  runner2->PostTaskAndWait([&]() {
+    current2 = runner2->IsCurrent() && !runner1->IsCurrent();
+  });
+  EXPECT_TRUE(current1);
+  EXPECT_TRUE(current2);
+}
+
+TEST_P(TaskRunnerTest, DestructFromOwnTask) {
+  std::unique_ptr<TaskRunnerFactory> factory = GetParam()();
+  auto owner = std::make_unique<TaskRunner>(CreateTaskRunner(factory, "Owner"));
+  auto runner = std::make_unique<TaskRunner>(
+      CreateTaskRunner(factory, "DestructFromOwnTask"));
+  std::mutex mutex;
+  std::condition_variable cv;
+  bool done = false;
+  // The runner must not go away while this thread is still posting to it.
+  CountDownLatch posted(1);
+  TaskRunner* target = runner.get();
+  target->PostTask([&]() {
+    posted.Wait();
+    owner->PostTask([&]() {
+      runner.reset();
+      std::scoped_lock lock(mutex);
+      done = true;
+      cv.notify_one();
+    });
+  });
+  posted.CountDown();
+  std::unique_lock<std::mutex> l(mutex);
+  EXPECT_TRUE(cv.wait_for(l, 1000ms, [&done] { return done; }));
+}
+
+TEST(TaskRunnerThreadOptionsTest, PinsRunnerToCpus) {
+  cpu_set_t allowed;
+  ASSERT_EQ(sched_getaffinity(0, sizeof(allowed), &allowed), 0);
+  int cpu = 0;
+  while (!CPU_ISSET(cpu, &allowed)) {
+    ++cpu;
+  }
+  ThreadOptions options;
+  options.cpus = {cpu};
+  options.stack_size = 256 * 1024;
+  // Not permitted in most test environments, the runner must start anyway.
+  options.policy = ThreadOptions::SchedPolicy::kFifo;
+  TaskRunner runner(
+      CreateDefaultTaskRunnerFactory()->CreateTaskRunner("Pinned", options));
+
+  int ran_on = -1;
+  runner.PostTaskAndWait([&ran_on]() { ran_on = sched_getcpu(); });
+  EXPECT_EQ(ran_on, cpu);
+}
+
+// Holds the runner thread in a task until Release().
+class BusyRunner {
+ public:
+  explicit BusyRunner(TaskRunner& runner) {
+    runner.PostTask([this] {
+      started_.CountDown();
+      release_.Wait();
+    });
+    started_.Wait();
+  }
+  void Release() { release_.CountDown(); }
+
+ private:
+  CountDownLatch started_{1};
+  CountDownLatch release_{1};
+};
+
+TEST(TaskQueueLimitsTest, RejectsWhenFull) {
+  TaskRunner runner(CreateDefaultTaskRunnerFactory()->CreateTaskRunner(
+      "Bounded", TaskRunnerFactory::Priority::NORMAL));
+  runner.SetQueueLimits(
+      {.capacity = 2, .policy = QueueFullPolicy::kReject});
+  BusyRunner busy(runner);
+
+  int ran = 0;
+  CountDownLatch done(1);
+  EXPECT_TRUE(runner.PostTaskWithOptions([&ran] { ++ran; }, {}));
+  EXPECT_TRUE(runner.PostTaskWithOptions(
+      [&ran, &done] {
+        ++ran;
+        done.CountDown();
+      },
+      {}));
+  EXPECT_FALSE(runner.PostTaskWithOptions([&ran] { ++ran; }, {}));
+  busy.Release();
+  done.Wait();
+  EXPECT_EQ(ran, 2);
+  EXPECT_EQ(runner.GetStats().overflow_tasks, 1u);
+}
+
+TEST(TaskQueueLimitsTest, DropsOldestDroppable) {
+  TaskRunner runner(CreateDefaultTaskRunnerFactory()->CreateTaskRunner(
+      "Bounded", TaskRunnerFactory::Priority::NORMAL));
+  runner.SetQueueLimits(
+      {.capacity = 2, .policy = QueueFullPolicy::kDropOldest});
+  BusyRunner busy(runner);
+
+  std::vector<int> order;
+  auto push = [&order](int value) {
+    return [&order, value] { order.push_back(value); };
+  };
+  EXPECT_TRUE(runner.PostTaskWithOptions(push(1), {.droppable = true}));
+  EXPECT_TRUE(runner.PostTaskWithOptions(push(2), {}));
+  EXPECT_TRUE(runner.PostTaskWithOptions(push(3), {.droppable = true}));
+  // 1 made room for 3, 3 makes room for this one.
+  CountDownLatch done(1);
+  EXPECT_TRUE(runner.PostTaskWithOptions(
+      [&order, &done] {
+        order.push_back(4);
+        done.CountDown();
+      },
+      {.droppable = true}));
+  busy.Release();
+  done.Wait();
+  EXPECT_EQ(order, std::vector<int>({2, 4}));
+  EXPECT_EQ(runner.GetStats().overflow_tasks, 2u);
+}
+
+TEST(TaskQueueLimitsTest, DropsOldestAtPostTime) {
+  TaskRunner runner(CreateDefaultTaskRunnerFactory()->CreateTaskRunner(
+      "Bounded", TaskRunnerFactory::Priority::NORMAL));
+  constexpr size_t kCapacity = 4;
+  runner.SetQueueLimits(
+      {.capacity = kCapacity, .policy = QueueFullPolicy::kDropOldest});
+  BusyRunner busy(runner);
+
+  // Counts the closures still holding their payload.
+  auto live = std::make_shared<int>(0);
+  struct Payload {
+    explicit Payload(std::shared_ptr<int> count) : count_(std::move(count)) {
+      ++*count_;
+    }
+    Payload(Payload&& other) = default;
+    ~Payload() {
+      if (count_) {
+        --*count_;
+      }
+    }
+    std::shared_ptr<int> count_;
+  };
+  for (int i = 0; i < 100; ++i) {
+    EXPECT_TRUE(runner.PostTaskWithOptions(
+        [payload = Payload(live)] {}, {.droppable = true}));
+    EXPECT_LE(static_cast<size_t>(*live), kCapacity);
+  }
+  EXPECT_EQ(runner.GetStats().overflow_tasks, 100 - kCapacity);
+  busy.Release();
+  runner.PostTaskAndWait([] {});
+  EXPECT_EQ(*live, 0);
+}
+
+TEST(TaskQueueLimitsTest, InvokeReportsRefusedTask) {
+  TaskRunner runner(CreateDefaultTaskRunnerFactory()->CreateTaskRunner(
+      "Bounded", TaskRunnerFactory::Priority::NORMAL));
+  runner.SetQueueLimits({.capacity = 1, .policy = QueueFullPolicy::kReject});
+  BusyRunner busy(runner);
+
+  runner.PostTask([] {});
+  bool ran = false;
+  EXPECT_FALSE(runner.Invoke([&ran] { ran = true; }));
+  EXPECT_EQ(runner.Invoke([] { return 1; }), std::nullopt);
+  EXPECT_FALSE(ran);
+  busy.Release();
+}
+
+TEST(TaskQueueLimitsTest, BlocksUntilThereIsRoom) {
+  TaskRunner runner(CreateDefaultTaskRunnerFactory()->CreateTaskRunner(
+      "Bounded", TaskRunnerFactory::Priority::NORMAL));
+  runner.SetQueueLimits({.capacity = 1, .policy = QueueFullPolicy::kBlock});
+  BusyRunner busy(runner);
+
+  runner.PostTask([] {});
+  std::atomic<bool> posted{false};
+  std::thread producer([&runner, &posted] {
+    runner.PostTask([] {});
+    posted = true;
+  });
+  std::this_thread::sleep_for(50ms);
+  EXPECT_FALSE(posted.load());
+  busy.Release();
+  producer.join();
+  EXPECT_TRUE(posted.load());
+  runner.PostTaskAndWait([] {});
+}
+
+TEST(TaskQueueLimitsTest, WatermarkCallbacks) {
+  TaskRunner runner(CreateDefaultTaskRunnerFactory()->CreateTaskRunner(
+      "Bounded", TaskRunnerFactory::Priority::NORMAL));
+  std::atomic<int> high{0};
+  std::atomic<int> low{0};
+  runner.SetQueueLimits({.high_watermark = 3,
+                         .low_watermark = 1,
+                         .on_high = [&high] { ++high; },
+                         .on_low = [&low] { ++low; }});
+  BusyRunner busy(runner);
+
+  for (int i = 0; i < 5; ++i) {
+    runner.PostTask([] {});
+  }
+  EXPECT_EQ(high.load(), 1);
+  EXPECT_EQ(low.load(), 0);
+  busy.Release();
+  runner.PostTaskAndWait([] {});
+  EXPECT_EQ(high.load(), 1);
+  EXPECT_EQ(low.load(), 1);
+}
+
 GTEST_ALLOW_UNINSTANTIATED_PARAMETERIZED_TEST(TaskRunnerTest);
 }  // namespace base
 }  // namespace ave
@@ -0,0 +1,84 @@
+/*
+ * task_watchdog_unittest.cc
+ * Copyright (C) 2026 youfa <vsyfar@gmail.com>
+ *
+ * Distributed under terms of the GPLv2 license.
+ */
+
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "base/count_down_latch.h"
+#include "base/task_util/default_task_runner_factory.h"
+#include "base/task_util/task_runner.h"
+#include "base/task_util/task_watchdog.h"
+#include "test/gtest.h"
+
+namespace ave {
+namespace base {
+namespace {
+
+using ::testing::EndsWith;
+using ::testing::HasSubstr;
+
+class TaskWatchdogTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    TaskWatchdog::Start(20 * 1000, [this](const TaskWatchdog::LongTask& task) {
+      std::scoped_lock guard(mutex_);
+      reports_.push_back(task);
+    });
+  }
+
+  void TearDown() override { TaskWatchdog::Stop(); }
+
+  std::vector<TaskWatchdog::LongTask> Reports() {
+    std::scoped_lock guard(mutex_);
+    return reports_;
+  }
+
+  std::mutex mutex_;
+  std::vector<TaskWatchdog::LongTask> reports_;
+};
+
+TEST_F(TaskWatchdogTest, ReportsLongTaskOnceWithPostingLocation) {
+  auto factory = CreateDefaultTaskRunnerFactory();
+  TaskRunner runner(
+      factory->CreateTaskRunner("Watched", TaskRunnerFactory::Priority::NORMAL));
+
+  CountDownLatch done(1);
+  runner.PostTask([&done] {
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    done.CountDown();
+  });
+  done.Wait();
+  runner.PostTaskAndWait([] {});
+
+  std::vector<TaskWatchdog::LongTask> reports = Reports();
+  ASSERT_EQ(reports.size(), 1u);
+  EXPECT_EQ(reports[0].runner, "Watched");
+  EXPECT_GE(reports[0].running_us, 20u * 1000);
+  EXPECT_THAT(reports[0].file, EndsWith("task_watchdog_unittest.cc"));
+  EXPECT_GT(reports[0].line, 0u);
+  EXPECT_THAT(reports[0].function, HasSubstr("TestBody"));
+}
+
+TEST_F(TaskWatchdogTest, ShortTasksAreNotReported) {
+  auto factory = CreateDefaultTaskRunnerFactory();
+  TaskRunner runner(
+      factory->CreateTaskRunner("Quick", TaskRunnerFactory::Priority::NORMAL));
+
+  for (int i = 0; i < 50; ++i) {
+    runner.PostTask(
+        [] { std::this_thread::sleep_for(std::chrono::milliseconds(1)); });
+  }
+  runner.PostTaskAndWait([] {});
+  EXPECT_TRUE(Reports().empty());
+}
+
+}  // namespace
+}  // namespace base
+}  // namespace ave
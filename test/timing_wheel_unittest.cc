@@ -0,0 +1,158 @@
+/*
+ * timing_wheel_unittest.cc
+ * Copyright (C) 2026 youfa <vsyfar@gmail.com>
+ *
+ * Distributed under terms of the GPLv2 license.
+ */
+
+#include "base/task_util/timing_wheel.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "test/gtest.h"
+
+namespace ave {
+namespace base {
+namespace {
+
+struct Entry : public TimingWheelNode {
+  Entry(uint64_t when_us, uint64_t order) {
+    when_us_ = when_us;
+    order_ = order;
+  }
+};
+
+std::unique_ptr<Entry> MakeEntry(uint64_t when_us, uint64_t order) {
+  return std::make_unique<Entry>(when_us, order);
+}
+
+}  // namespace
+
+TEST(TimingWheelTest, EmptyWheel) {
+  TimingWheel<Entry> wheel(1000);
+  EXPECT_TRUE(wheel.empty());
+  EXPECT_EQ(wheel.NextDueUs(), TimingWheel<Entry>::kNever);
+  EXPECT_EQ(wheel.PopDue(1000000), nullptr);
+}
+
+TEST(TimingWheelTest, NeverReportsEarly) {
+  TimingWheel<Entry> wheel(0);
+  wheel.Insert(MakeEntry(1500, 0));
+
+  EXPECT_LE(wheel.NextDueUs(), 1500u);
+  EXPECT_EQ(wheel.PopDue(1024), nullptr);
+  EXPECT_EQ(wheel.PopDue(1499), nullptr);
+  EXPECT_EQ(wheel.NextDueUs(), 1500u);
+  auto entry = wheel.PopDue(1500);
+  ASSERT_NE(entry, nullptr);
+  EXPECT_EQ(entry->when_us_, 1500u);
+  EXPECT_TRUE(wheel.empty());
+}
+
+TEST(TimingWheelTest, SameDeadlineKeepsOrder) {
+  TimingWheel<Entry> wheel(0);
+  for (uint64_t i = 0; i < 10; ++i) {
+    wheel.Insert(MakeEntry(5000, i));
+  }
+  for (uint64_t i = 0; i < 10; ++i) {
+    auto entry = wheel.PopDue(5000);
+    ASSERT_NE(entry, nullptr);
+    EXPECT_EQ(entry->order_, i);
+  }
+}
+
+TEST(TimingWheelTest, PastDeadlineIsDueImmediately) {
+  TimingWheel<Entry> wheel(1000000);
+  wheel.Insert(MakeEntry(10, 0));
+  EXPECT_NE(wheel.PopDue(1000000), nullptr);
+}
+
+TEST(TimingWheelTest, FarDeadlinesCascade) {
+  TimingWheel<Entry> wheel(0);
+  // One hour and beyond the top level, which ends after about 4.7 hours.
+  constexpr uint64_t kHourUs = 3600ULL * 1000 * 1000;
+  wheel.Insert(MakeEntry(kHourUs, 0));
+  wheel.Insert(MakeEntry(10 * kHourUs, 1));
+
+  EXPECT_LE(wheel.NextDueUs(), kHourUs);
+  EXPECT_EQ(wheel.PopDue(kHourUs - 1), nullptr);
+  auto first = wheel.PopDue(kHourUs);
+  ASSERT_NE(first, nullptr);
+  EXPECT_EQ(first->order_, 0u);
+
+  EXPECT_EQ(wheel.PopDue(10 * kHourUs - 1), nullptr);
+  auto second = wheel.PopDue(10 * kHourUs);
+  ASSERT_NE(second, nullptr);
+  EXPECT_EQ(second->order_, 1u);
+}
+
+TEST(TimingWheelTest, RemoveUnlinksPendingEntries) {
+  TimingWheel<Entry> wheel(0);
+  auto first = MakeEntry(5000, 0);
+  auto second = MakeEntry(5000, 1);
+  auto far = MakeEntry(3000000, 2);
+  Entry* first_ptr = first.get();
+  Entry* far_ptr = far.get();
+  wheel.Insert(std::move(first));
+  wheel.Insert(std::move(second));
+  wheel.Insert(std::move(far));
+
+  EXPECT_EQ(wheel.Remove(first_ptr).get(), first_ptr);
+  EXPECT_EQ(wheel.Remove(far_ptr).get(), far_ptr);
+  EXPECT_EQ(wheel.size(), 1u);
+
+  auto entry = wheel.PopDue(5000);
+  ASSERT_NE(entry, nullptr);
+  EXPECT_EQ(entry->order_, 1u);
+  EXPECT_TRUE(wheel.empty());
+  EXPECT_EQ(wheel.NextDueUs(), TimingWheel<Entry>::kNever);
+}
+
+TEST(TimingWheelTest, RemoveLeavesReachedEntries) {
+  TimingWheel<Entry> wheel(0);
+  auto entry = MakeEntry(500, 0);
+  Entry* entry_ptr = entry.get();
+  wheel.Insert(std::move(entry));
+  // Within the current tick, so it is already queued to come out.
+  EXPECT_EQ(wheel.Remove(entry_ptr), nullptr);
+  EXPECT_EQ(wheel.PopDue(500).get(), entry_ptr);
+}
+
+TEST(TimingWheelTest, MatchesSortedOrder) {
+  TimingWheel<Entry> wheel(12345);
+  std::minstd_rand gen(42);
+  std::uniform_int_distribution<uint64_t> delay(0, 20ULL * 1000 * 1000);
+
+  std::vector<std::pair<uint64_t, uint64_t>> expected;
+  for (uint64_t i = 0; i < 5000; ++i) {
+    uint64_t when = 12345 + delay(gen);
+    expected.emplace_back(when, i);
+    wheel.Insert(MakeEntry(when, i));
+  }
+  std::sort(expected.begin(), expected.end());
+
+  // Step time forward unevenly, checking nothing comes out early or out of
+  // order.
+  uint64_t now = 12345;
+  size_t next = 0;
+  while (!wheel.empty()) {
+    uint64_t due = wheel.NextDueUs();
+    ASSERT_NE(due, TimingWheel<Entry>::kNever);
+    now = std::max(now, due) + (next % 3 == 0 ? 700 : 0);
+    while (auto entry = wheel.PopDue(now)) {
+      ASSERT_LT(next, expected.size());
+      EXPECT_LE(entry->when_us_, now);
+      EXPECT_EQ(entry->when_us_, expected[next].first);
+      EXPECT_EQ(entry->order_, expected[next].second);
+      ++next;
+    }
+  }
+  EXPECT_EQ(next, expected.size());
+}
+
+}  // namespace base
+}  // namespace ave
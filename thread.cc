@@ -7,13 +7,21 @@
 
 #include "thread.h"
 
+#include <linux/mempolicy.h>
+#include <sched.h>
 #include <sys/prctl.h>
 #include <sys/resource.h>
 #include <sys/syscall.h>
 #include <unistd.h>
 
 #include <cassert>
+#include <cerrno>
+#include <climits>
+#include <cstring>
 #include <string>
+#include <vector>
+
+#include "base/logging.h"
 
 namespace ave {
 namespace base {
@@ -23,24 +31,64 @@ pid_t gettid() {
   return static_cast<pid_t>(::syscall(SYS_gettid));
 }
 
+void applyAffinity(const std::vector<int>& cpus) {
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  for (int cpu : cpus) {
+    if (cpu >= 0 && cpu < CPU_SETSIZE) {
+      CPU_SET(cpu, &set);
+    }
+  }
+  int err = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+  if (err != 0) {
+    AVE_LOG(LS_WARNING) << "pthread_setaffinity_np failed: " << strerror(err);
+  }
+}
+
+// Returns false if the policy could not be set.
+bool applySchedPolicy(ThreadOptions::SchedPolicy policy, int priority) {
+  sched_param param{};
+  param.sched_priority = priority;
+  int err = pthread_setschedparam(
+      pthread_self(),
+      policy == ThreadOptions::SchedPolicy::kFifo ? SCHED_FIFO : SCHED_RR,
+      &param);
+  if (err != 0) {
+    AVE_LOG(LS_WARNING) << "pthread_setschedparam failed: " << strerror(err);
+    return false;
+  }
+  return true;
+}
+
+void applyNumaNode(int node) {
+  constexpr int kMaxNode = 8 * sizeof(unsigned long);
+  if (node >= kMaxNode) {
+    return;
+  }
+  unsigned long mask = 1UL << node;
+  if (::syscall(SYS_set_mempolicy, MPOL_PREFERRED, &mask, kMaxNode + 1) != 0) {
+    AVE_LOG(LS_WARNING) << "set_mempolicy failed: " << strerror(errno);
+  }
+}
+
 struct ThreadData {
   using ThreadFunc = base::Thread::ThreadFunc;
   ThreadFunc func_;
   std::string name_;
   pid_t* tid_;
   CountDownLatch* latch_;
-  int priority_;
+  ThreadOptions options_;
 
   ThreadData(ThreadFunc func,
              std::string name,
              pid_t* tid,
              CountDownLatch* latch,
-             int priority)
+             ThreadOptions options)
       : func_(std::move(func)),
         name_(std::move(name)),
         tid_(tid),
         latch_(latch),
-        priority_(priority) {}
+        options_(std::move(options)) {}
 
   void runInThread() {
     *tid_ = gettid();
@@ -50,9 +98,20 @@ struct ThreadData {
 
     ::prctl(PR_SET_NAME, name_.empty() ? "thread" : name_.c_str());
 
-    // Apply thread nice priority (lower value = higher priority)
-    if (priority_ != 0) {
-      setpriority(PRIO_PROCESS, 0, priority_);
+    if (!options_.cpus.empty()) {
+      applyAffinity(options_.cpus);
+    }
+    if (options_.numa_node >= 0) {
+      applyNumaNode(options_.numa_node);
+    }
+
+    // Fall back to the nice value if the real-time policy is not allowed.
+    if (options_.policy == ThreadOptions::SchedPolicy::kNormal ||
+        !applySchedPolicy(options_.policy, options_.realtime_priority)) {
+      // Apply thread nice priority (lower value = higher priority)
+      if (options_.priority != 0) {
+        setpriority(PRIO_PROCESS, 0, options_.priority);
+      }
     }
 
     func_();
@@ -69,6 +128,15 @@ void* startThread(void* obj) {
 }  // namespace
 
 Thread::Thread(ThreadFunc func, std::string name, int priority, bool joinable)
+    : Thread(std::move(func),
+             std::move(name),
+             ThreadOptions{.priority = priority},
+             joinable) {}
+
+Thread::Thread(ThreadFunc func,
+               std::string name,
+               ThreadOptions options,
+               bool joinable)
     : started_(false),
       joined_(false),
       joinable_(joinable),
@@ -76,7 +144,7 @@ Thread::Thread(ThreadFunc func, std::string name, int priority, bool joinable)
       tid_(0),
       func_(std::move(func)),
       name_(std::move(name)),
-      priority_(priority),
+      options_(std::move(options)),
       latch_(1) {}
 
 Thread::~Thread() {
@@ -89,12 +157,17 @@ void Thread::start(bool async) {
   assert(!started_);
   started_ = true;
 
-  auto* data = new ThreadData(func_, name_, &tid_, &latch_, priority_);
+  auto* data = new ThreadData(func_, name_, &tid_, &latch_, options_);
 
   pthread_attr_t attr;
   pthread_attr_init(&attr);
-  // Set the stack size to 1M.
-  pthread_attr_setstacksize(&attr, 1024 * 1024);
+  if (options_.stack_size > 0) {
+    const auto min_stack_size = static_cast<size_t>(PTHREAD_STACK_MIN);
+    size_t stack_size = options_.stack_size < min_stack_size
+                            ? min_stack_size
+                            : options_.stack_size;
+    pthread_attr_setstacksize(&attr, stack_size);
+  }
   pthread_attr_setdetachstate(
       &attr, joinable_ ? PTHREAD_CREATE_JOINABLE : PTHREAD_CREATE_DETACHED);
 
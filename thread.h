@@ -9,8 +9,10 @@
 #define THREAD_H
 
 #include <pthread.h>
+#include <cstddef>
 #include <functional>
 #include <string>
+#include <vector>
 
 #include "base/constructor_magic.h"
 #include "base/count_down_latch.h"
@@ -19,6 +21,32 @@
 namespace ave {
 namespace base {
 
+// Where and how a thread runs. Settings the process is not allowed to use,
+// e.g. a real-time policy without CAP_SYS_NICE, are logged and skipped, the
+// thread still starts.
+struct ThreadOptions {
+  enum class SchedPolicy {
+    // SCHED_OTHER with the nice value of `priority`.
+    kNormal,
+    // SCHED_FIFO / SCHED_RR with `realtime_priority`.
+    kFifo,
+    kRoundRobin,
+  };
+
+  // Nice value, see thread_defs.h. Only used with SchedPolicy::kNormal.
+  int priority = AVE_PRIORITY_DEFAULT;
+  SchedPolicy policy = SchedPolicy::kNormal;
+  // 1 (lowest) to 99 (highest).
+  int realtime_priority = 1;
+  // CPUs the thread may run on, empty for any.
+  std::vector<int> cpus;
+  // 0 for the system default.
+  size_t stack_size = 1024 * 1024;
+  // Preferred NUMA node for the memory the thread allocates, -1 for none.
+  // Pin the thread to the CPUs of the node with `cpus` as well.
+  int numa_node = -1;
+};
+
 class Thread {
  public:
   using ThreadFunc = std::function<void()>;
@@ -26,6 +54,10 @@ class Thread {
                   std::string name = std::string(),
                   int priority = AVE_PRIORITY_DEFAULT,
                   bool joinable = false);
+  Thread(ThreadFunc,
+         std::string name,
+         ThreadOptions options,
+         bool joinable = false);
   virtual ~Thread();
 
   void start(bool async = false);
@@ -44,7 +76,7 @@ class Thread {
   pid_t tid_;
   ThreadFunc func_;
   std::string name_;
-  int priority_;
+  ThreadOptions options_;
   CountDownLatch latch_;
 
   AVE_DISALLOW_COPY_AND_ASSIGN(Thread);